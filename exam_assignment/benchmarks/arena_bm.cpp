@@ -0,0 +1,77 @@
+// Allocator contention in ParallelSimulator. Every replica of SEIHR records the full state after every event, which is
+// the allocation-heavy case: the buffers grow all through the run. The same monitor is run with its buffers on the
+// global heap and in the replica arenas (src/arena.h), at 1 to 32 threads with 4 replicas per thread:
+//   events/s         events per second of wall time, over all threads
+//   arena_overflows  heap allocations the arenas could not serve, per iteration. An untimed first round grows the
+//                    arenas to their high-water mark, so this stays near 0.
+// With few threads both variants run at about the same speed; the gap that opens with more threads is the contention
+// in malloc (and the cost of scattered buffers). Run with --benchmark_out=arena.json --benchmark_out_format=json to
+// keep the results.
+#include "../src/parallel_simulator.h"
+#include "../src/examples/examples.h"
+
+#include <memory_resource>
+#include <benchmark/benchmark.h>
+
+namespace {
+    constexpr size_t replicas_per_thread = 4;
+
+    // All amounts after every event, in one buffer per replica
+    class TrajectoryMonitor {
+    public:
+        void operator()(const System& system, double t)
+        {
+            times_.push_back(t);
+            for (const auto& [species, amount] : system.getSpecies()) {
+                amounts_.push_back(amount);
+            }
+        }
+
+        [[nodiscard]] size_t events() const { return times_.size(); }
+
+    protected:
+        std::pmr::vector<double> times_;
+        std::pmr::vector<int> amounts_;
+    };
+
+    // The same buffers in the results arena of the replica
+    class ArenaTrajectoryMonitor : public TrajectoryMonitor {
+    public:
+        void useMemoryResource(std::pmr::memory_resource* resource)
+        {
+            std::destroy_at(&times_);
+            std::construct_at(&times_, resource);
+            std::destroy_at(&amounts_);
+            std::construct_at(&amounts_, resource);
+        }
+    };
+
+    template <typename MonitorType>
+    void replicas_bm(benchmark::State& state)
+    {
+        const auto threads = static_cast<size_t>(state.range(0));
+        ParallelSimulator<MonitorType> simulator([] { return seihr(10000); },
+                                                 [] { return std::make_unique<MonitorType>(); },
+                                                 100, replicas_per_thread * threads, threads);
+        simulator.simulate();  // warm-up: grows the arenas
+        const auto warm_overflows = simulator.arenaOverflows();
+        size_t events = 0;
+        for (auto _ : state) {
+            simulator.simulate();
+            for (const auto& monitor : simulator.getMonitors()) {
+                events += monitor->events();
+            }
+        }
+        const auto overflows = simulator.arenaOverflows() - warm_overflows;
+        state.counters["events/s"] = benchmark::Counter(static_cast<double>(events), benchmark::Counter::kIsRate);
+        state.counters["arena_overflows"] = benchmark::Counter(static_cast<double>(overflows),
+                                                               benchmark::Counter::kAvgIterations);
+    }
+}
+
+BENCHMARK_TEMPLATE(replicas_bm, TrajectoryMonitor)->Name("heap")->RangeMultiplier(2)->Range(1, 32)
+        ->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(replicas_bm, ArenaTrajectoryMonitor)->Name("arena")->RangeMultiplier(2)->Range(1, 32)
+        ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,42 @@
+#ifndef PERF_COUNTERS_BM_H
+#define PERF_COUNTERS_BM_H
+
+// Hardware counters (src/perf_counters.h) as google-benchmark user counters. Open the counters before the timed loop,
+// then pass the sample and the number of work items (events, calls) to `add_perf_counters`. Nothing is added when
+// perf_event_open is unavailable; the reason is printed once.
+//
+//     PerfCounters perf;
+//     perf.start();
+//     for (auto _ : state) { ... }
+//     add_perf_counters(state, perf, events);
+
+#include <cmath>
+#include <iostream>
+#include <benchmark/benchmark.h>
+
+#include "../src/perf_counters.h"
+
+inline void add_perf_counters(benchmark::State& state, PerfCounters& perf, double items)
+{
+    const auto sample = perf.stop();
+    if (!perf.available()) {
+        static bool warned = false;
+        if (!warned) {
+            std::cerr << "Hardware counters unavailable (" << perf.why() << "), reporting times only" << std::endl;
+            warned = true;
+        }
+        return;
+    }
+
+    const auto per_item = sample.per(items);
+    for (size_t i = 0; i < num_perf_events; ++i) {
+        if (!std::isnan(per_item.values[i])) {
+            state.counters[std::string(to_string(static_cast<PerfEvent>(i))) + "/item"] = per_item.values[i];
+        }
+    }
+    if (!std::isnan(sample.ipc())) {
+        state.counters["IPC"] = sample.ipc();
+    }
+}
+
+#endif //PERF_COUNTERS_BM_H
@@ -0,0 +1,91 @@
+// Persisting a record per event from parallel replicas of SEIHR, to a file in the temporary directory:
+//   in_task  every worker writes its records itself, to the one file behind a mutex
+//   sink     every worker pushes its records into its ring of a ResultSink (src/result_sink.h), and the writer thread
+//            writes them in batches
+// at 1 to 16 threads with 4 replicas per thread:
+//   events/s  events per second of wall time, over all threads, including writing out what is still buffered
+//   waits     pushes that found their ring full, per iteration: the writer could not keep up
+// Run with --benchmark_out=result_sink.json --benchmark_out_format=json to keep the results.
+#include "../src/parallel_simulator.h"
+#include "../src/result_sink.h"
+#include "../src/examples/examples.h"
+
+#include <filesystem>
+#include <mutex>
+#include <benchmark/benchmark.h>
+
+namespace {
+    constexpr size_t replicas_per_thread = 4;
+
+    // The time and the amount of the first species
+    struct EventRecord {
+        double time;
+        int amount;
+    };
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "result_sink_bm.bin";
+
+    void in_task_bm(benchmark::State& state)
+    {
+        const auto threads = static_cast<size_t>(state.range(0));
+        RecordFile file(path);
+        std::mutex file_mutex;
+        struct FileMonitor : Monitor {
+            RecordFile* file;
+            std::mutex* mutex;
+            void operator()(const System& system, double t) override {
+                const EventRecord record{t, system.getSpecies().begin()->second};
+                std::lock_guard lock(*mutex);
+                file->write(std::span(&record, 1));
+            }
+        };
+        ParallelSimulator<FileMonitor> simulator([] { return seihr(10000); }, [&] {
+            auto monitor = std::make_unique<FileMonitor>();
+            monitor->file = &file;
+            monitor->mutex = &file_mutex;
+            return monitor;
+        }, 100, replicas_per_thread * threads, threads);
+        for (auto _ : state) {
+            simulator.simulate();
+            file.flush();
+        }
+        const auto events = std::filesystem::file_size(path) / sizeof(EventRecord);
+        state.counters["events/s"] = benchmark::Counter(static_cast<double>(events), benchmark::Counter::kIsRate);
+        std::filesystem::remove(path);
+    }
+
+    void sink_bm(benchmark::State& state)
+    {
+        const auto threads = static_cast<size_t>(state.range(0));
+        RecordFile file(path);
+        std::optional<ResultSink<EventRecord>> sink;
+        struct SinkMonitor : Monitor {
+            ResultSink<EventRecord>* sink;
+            void operator()(const System& system, double t) override {
+                sink->push(ThreadPool::current_slot(), {t, system.getSpecies().begin()->second});
+            }
+        };
+        ParallelSimulator<SinkMonitor> simulator([] { return seihr(10000); }, [&] {
+            auto monitor = std::make_unique<SinkMonitor>();
+            monitor->sink = &*sink;
+            return monitor;
+        }, 100, replicas_per_thread * threads, threads);
+        uint64_t events = 0, waits = 0;
+        for (auto _ : state) {
+            sink.emplace(threads, [&file](std::span<const EventRecord> batch) { file.write(batch); });
+            simulator.simulate();
+            sink->close();
+            file.flush();
+            events += sink->stats().written;
+            waits += sink->stats().waits;
+        }
+        state.counters["events/s"] = benchmark::Counter(static_cast<double>(events), benchmark::Counter::kIsRate);
+        state.counters["waits"] = benchmark::Counter(static_cast<double>(waits), benchmark::Counter::kAvgIterations);
+        std::filesystem::remove(path);
+    }
+}
+
+BENCHMARK(in_task_bm)->Name("in_task")->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(sink_bm)->Name("sink")->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,176 @@
+// Engine scaling from 10 to 10^6 reactions on the synthetic networks of network_generator.h.
+// Every run simulates about `target_events` events, so the counters are comparable across sizes:
+//   events/s     events per second of wall time
+//   ns/event     its inverse
+//   peak_bytes   peak heap in use while the engine is constructed and run, on top of the network itself
+//   network_bytes heap held by the compiled network
+//   <event>/item  hardware counters per simulated event, and IPC, where perf_event_open is available
+// Run with --benchmark_out=scaling.json --benchmark_out_format=json to keep the results.
+#include "../src/network_generator.h"
+#include "../src/engines/adaptive_simulator.h"
+#include "../src/engines/uniformization_simulator.h"
+#include "perf_counters_bm.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <benchmark/benchmark.h>
+
+// Heap accounting for the memory counters. Each block carries its size in a header, so frees can be subtracted.
+namespace heap {
+    std::atomic<size_t> live{0}, peak{0};
+
+    void reset_peak() { peak = live.load(); }
+}
+
+void* operator new(std::size_t size)
+{
+    auto* block = static_cast<std::size_t*>(std::malloc(size + 16));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    *block = size;
+    const auto now = heap::live += size;
+    auto peak = heap::peak.load();
+    while (now > peak && !heap::peak.compare_exchange_weak(peak, now)) {}
+    return reinterpret_cast<char*>(block) + 16;
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p == nullptr) {
+        return;
+    }
+    auto* block = reinterpret_cast<std::size_t*>(static_cast<char*>(p) - 16);
+    heap::live -= *block;
+    std::free(block);
+}
+
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+
+namespace {
+    constexpr double target_events = 20000;
+    constexpr unsigned seed = 42;
+
+    enum class Family { ScaleFree, Metapopulation, Cascade };
+    enum class Engine { Direct, NextReaction, CompositionRejection, TauLeaping, Uniformization };
+
+    struct Model {
+        std::unique_ptr<CompiledNetwork> network;
+        size_t bytes;
+        double end_time;  // simulated time that covers about `target_events` events
+    };
+
+    size_t run(Engine engine, const CompiledNetwork& network, double end_time);
+
+    size_t run_pilot(const CompiledNetwork& network, double end_time)
+    {
+        return run(Engine::NextReaction, network, end_time);
+    }
+
+    // Networks are built once per family and size, outside the timed region
+    const Model& model(Family family, size_t reactions)
+    {
+        static std::map<std::pair<Family, size_t>, Model> models;
+        auto it = models.find({family, reactions});
+        if (it != models.end()) {
+            return it->second;
+        }
+
+        const size_t before = heap::live;
+        std::unique_ptr<CompiledNetwork> network;
+        switch (family) {
+            case Family::ScaleFree:
+                network = std::make_unique<CompiledNetwork>(scale_free_network(
+                        {.species = std::max<size_t>(reactions / 4, 2), .reactions = reactions, .rate_spread = 2, .seed = seed}));
+                break;
+            case Family::Metapopulation:
+                network = std::make_unique<CompiledNetwork>(metapopulation_seihr(std::max<size_t>(reactions / 13, 1), 10000, 0.01, seed));
+                break;
+            case Family::Cascade:
+                network = std::make_unique<CompiledNetwork>(gene_cascade(std::max<size_t>(reactions / 6, 1), 2, seed));
+                break;
+        }
+        const size_t bytes = heap::live - before;
+
+        // a0 changes as the dynamics unfold (the cascade starts with a single active gene), so the end time is
+        // found by pilot runs of the next reaction method rather than from the initial a0
+        double a0 = 0;
+        for (size_t r = 0; r < network->numReactions(); ++r) {
+            a0 += network->propensity(r, network->initialState().data());
+        }
+        double end_time = a0 > 0 ? target_events / a0 : 1;
+        for (int pilot = 0; pilot < 20; ++pilot) {
+            const auto events = static_cast<double>(run_pilot(*network, end_time));
+            if (events > 0.8 * target_events && events < 1.25 * target_events) {
+                break;
+            }
+            end_time *= events > 0 ? std::clamp(target_events / events, 0.1, 10.0) : 10.0;
+        }
+        return models.emplace(std::make_pair(family, reactions), Model{std::move(network), bytes, end_time}).first->second;
+    }
+
+    struct Discard : StateMonitor {
+        void operator()(const CompiledNetwork&, std::span<const int>, double) override {}
+    };
+
+    size_t run(Engine engine, const CompiledNetwork& network, double end_time)
+    {
+        Discard monitor;
+        if (engine == Engine::Uniformization) {
+            UniformizationSimulator simulator(network, end_time, seed);
+            simulator.simulate(monitor);
+            return simulator.acceptedEvents();
+        }
+
+        const EngineKind kinds[] = {EngineKind::Direct, EngineKind::NextReaction, EngineKind::CompositionRejection,
+                                    EngineKind::TauLeaping};
+        AdaptiveSimulator simulator(network, end_time, seed, {.engine = kinds[static_cast<int>(engine)]});
+        simulator.simulate(monitor);
+        return simulator.metadata().exact_events + simulator.metadata().leaped_firings;
+    }
+}
+
+void engine_bm(benchmark::State& state, Engine engine, Family family)
+{
+    const auto& [network, bytes, end_time] = model(family, state.range(0));
+
+    size_t events = 0;
+    heap::reset_peak();
+    const size_t baseline = heap::live;
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        events += run(engine, *network, end_time);
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["reactions"] = static_cast<double>(network->numReactions());
+    state.counters["events/s"] = benchmark::Counter(static_cast<double>(events), benchmark::Counter::kIsRate);
+    state.counters["ns/event"] = benchmark::Counter(static_cast<double>(events) * 1e-9,
+                                                    benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["peak_bytes"] = static_cast<double>(heap::peak - baseline);
+    state.counters["network_bytes"] = static_cast<double>(bytes);
+    add_perf_counters(state, perf, static_cast<double>(events));
+}
+
+// The direct method scans every propensity per event, so it stops at 10^5 reactions
+BENCHMARK_CAPTURE(engine_bm, direct/scale_free, Engine::Direct, Family::ScaleFree)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(engine_bm, next_reaction/scale_free, Engine::NextReaction, Family::ScaleFree)->RangeMultiplier(10)->Range(10, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(engine_bm, composition_rejection/scale_free, Engine::CompositionRejection, Family::ScaleFree)->RangeMultiplier(10)->Range(10, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(engine_bm, tau_leaping/scale_free, Engine::TauLeaping, Family::ScaleFree)->RangeMultiplier(10)->Range(10, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(engine_bm, uniformization/scale_free, Engine::Uniformization, Family::ScaleFree)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(engine_bm, direct/metapopulation, Engine::Direct, Family::Metapopulation)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(engine_bm, next_reaction/metapopulation, Engine::NextReaction, Family::Metapopulation)->RangeMultiplier(10)->Range(10, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(engine_bm, composition_rejection/metapopulation, Engine::CompositionRejection, Family::Metapopulation)->RangeMultiplier(10)->Range(10, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(engine_bm, tau_leaping/metapopulation, Engine::TauLeaping, Family::Metapopulation)->RangeMultiplier(10)->Range(10, 1000000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(engine_bm, direct/cascade, Engine::Direct, Family::Cascade)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(engine_bm, next_reaction/cascade, Engine::NextReaction, Family::Cascade)->RangeMultiplier(10)->Range(10, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(engine_bm, composition_rejection/cascade, Engine::CompositionRejection, Family::Cascade)->RangeMultiplier(10)->Range(10, 1000000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
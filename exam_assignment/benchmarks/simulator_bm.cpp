@@ -0,0 +1,145 @@
+// Per-component costs of the `System`-based Simulator (first reaction method), so that changes to the hot path
+// can be measured one step at a time instead of through whole simulations:
+//   compute_delay            one delay per reaction, as at the top of every step
+//   find_min_delay_reaction  the scan for the earliest delay
+//   react                    applying one reaction to the amounts
+//   monitor                  one monitor call per event, empty lambda vs. the monitors of src/monitor
+//   simulate                 whole runs of the examples
+// Every benchmark also reports hardware counters per item where perf_event_open is available, which attributes
+// cache and branch misses to the individual phases. Seeds are fixed. Run with --benchmark_out=simulator.json
+// --benchmark_out_format=json to keep the results.
+#include "../src/stochastic_simulator.h"
+#include "../src/examples/examples.h"
+#include "../src/monitor/species_peak_monitor.h"
+#include "../src/monitor/species_trajectory_monitor.h"
+#include "perf_counters_bm.h"
+
+#include <random>
+#include <benchmark/benchmark.h>
+
+namespace {
+    constexpr unsigned seed = 42;
+
+    enum class Example { Simple, Circadian, Seihr };
+
+    System example(Example example)
+    {
+        switch (example) {
+            case Example::Simple: return simple();
+            case Example::Circadian: return circadian_oscillator();
+            case Example::Seihr: return seihr(10000);
+        }
+        return {};
+    }
+
+    // Gives every reaction a delay, as the simulator does before picking the next one
+    void assign_delays(std::vector<Reaction>& reactions)
+    {
+        auto generator = std::mt19937{seed};
+        auto dist = std::exponential_distribution<double>{1.0};
+        for (auto& r : reactions) {
+            r.setDelay(dist(generator));
+        }
+    }
+}
+
+void compute_delay_bm(benchmark::State& state, Example model)
+{
+    auto system = example(model);
+    auto simulator = Simulator(system, 100, seed);
+    const auto& reactions = system.getReactions();
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        for (const auto& r : reactions) {
+            benchmark::DoNotOptimize(simulator.compute_delay(r));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(reactions.size()));
+    add_perf_counters(state, perf, static_cast<double>(state.iterations() * reactions.size()));
+}
+BENCHMARK_CAPTURE(compute_delay_bm, simple, Example::Simple);
+BENCHMARK_CAPTURE(compute_delay_bm, circadian, Example::Circadian);
+BENCHMARK_CAPTURE(compute_delay_bm, seihr, Example::Seihr);
+
+void find_min_delay_reaction_bm(benchmark::State& state, Example model)
+{
+    auto system = example(model);
+    auto simulator = Simulator(system, 100, seed);
+    auto& reactions = system.getReactions();
+    assign_delays(reactions);
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(simulator.find_min_delay_reaction(reactions));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(reactions.size()));
+    add_perf_counters(state, perf, static_cast<double>(state.iterations() * reactions.size()));
+}
+BENCHMARK_CAPTURE(find_min_delay_reaction_bm, simple, Example::Simple);
+BENCHMARK_CAPTURE(find_min_delay_reaction_bm, circadian, Example::Circadian);
+BENCHMARK_CAPTURE(find_min_delay_reaction_bm, seihr, Example::Seihr);
+
+void react_bm(benchmark::State& state, Example model)
+{
+    auto system = example(model);
+    auto simulator = Simulator(system, 100, seed);
+    auto& reactions = system.getReactions();
+    // Round robin over the reactions, so every shape of reaction is measured; amounts may go negative, which
+    // `react` does not check
+    size_t next = 0;
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        simulator.react(reactions[next]);
+        next = next + 1 == reactions.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+    add_perf_counters(state, perf, static_cast<double>(state.iterations()));
+}
+BENCHMARK_CAPTURE(react_bm, simple, Example::Simple);
+BENCHMARK_CAPTURE(react_bm, circadian, Example::Circadian);
+BENCHMARK_CAPTURE(react_bm, seihr, Example::Seihr);
+
+// `simulate` takes the monitor by value as a template parameter, as here, so this is the cost of the call itself
+// and of the work the monitor does per event
+template <typename MonitorT>
+void monitor_bm(benchmark::State& state, MonitorT monitor)
+{
+    const auto system = seihr(10000);
+    double t = 0;
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        monitor(system, t);
+        t += 1e-3;
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    add_perf_counters(state, perf, static_cast<double>(state.iterations()));
+}
+BENCHMARK_CAPTURE(monitor_bm, empty_lambda, [](const System&, double) {});
+BENCHMARK_CAPTURE(monitor_bm, peak, SpeciesPeakMonitor("H"));
+// The trajectory grows with every call, so its iterations are capped
+BENCHMARK_CAPTURE(monitor_bm, trajectory, SpeciesTrajectoryMonitor())->Iterations(1 << 20);
+
+void simulate_bm(benchmark::State& state, Example model)
+{
+    const auto system = example(model);
+    const double end_time = static_cast<double>(state.range(0));
+    size_t events = 0;
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        auto simulator = Simulator(system, end_time, seed);
+        simulator.simulate([&events](const System&, double) { ++events; });
+    }
+    state.counters["events/s"] = benchmark::Counter(static_cast<double>(events), benchmark::Counter::kIsRate);
+    state.counters["events"] = benchmark::Counter(static_cast<double>(events), benchmark::Counter::kAvgIterations);
+    add_perf_counters(state, perf, static_cast<double>(events));
+}
+BENCHMARK_CAPTURE(simulate_bm, simple, Example::Simple)->Arg(2000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(simulate_bm, circadian, Example::Circadian)->Arg(100)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(simulate_bm, seihr, Example::Seihr)->Arg(100)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
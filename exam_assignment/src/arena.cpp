@@ -0,0 +1,86 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+void* ReplicaArena::Overflow::do_allocate(size_t bytes, size_t alignment) {
+    ++allocations;
+    this->bytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void ReplicaArena::Overflow::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+bool ReplicaArena::Overflow::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+ReplicaArena::ReplicaArena(size_t initial_size)
+        : size_(initial_size), buffer_(std::make_unique_for_overwrite<std::byte[]>(initial_size)) {
+    monotonic_.emplace(buffer_.get(), size_, &upstream_);
+}
+
+void ReplicaArena::reset() {
+    monotonic_.reset();  // returns the overflow to the heap
+    if (upstream_.bytes > 0) {
+        size_ = std::bit_ceil(size_ + upstream_.bytes);
+        buffer_ = std::make_unique_for_overwrite<std::byte[]>(size_);
+        upstream_.bytes = 0;
+    }
+    monotonic_.emplace(buffer_.get(), size_, &upstream_);
+}
+
+ArenaPool::ArenaPool(size_t slots)
+        : slots_(std::make_unique<Slot[]>(std::max<size_t>(slots, 1))), num_slots_(std::max<size_t>(slots, 1)),
+          free_(num_slots_) {
+    std::iota(free_.begin(), free_.end(), 0);
+}
+
+ArenaPool::Lease ArenaPool::acquire(size_t preferred) {
+    size_t slot;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_free_.wait(lock, [this] { return !free_.empty(); });
+        auto it = std::find(free_.begin(), free_.end(), preferred);
+        if (it == free_.end()) {
+            it = std::prev(free_.end());
+        }
+        slot = *it;
+        free_.erase(it);
+    }
+    if (slots_[slot].results_stale) {
+        slots_[slot].results.reset();
+        slots_[slot].results_stale = false;
+    }
+    return {this, slot};
+}
+
+void ArenaPool::release(size_t slot) {
+    slots_[slot].scratch.reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(slot);
+    cv_free_.notify_one();
+}
+
+ArenaPool::Lease::~Lease() {
+    if (pool_ != nullptr) {
+        pool_->release(slot_);
+    }
+}
+
+void ArenaPool::resetResults() {
+    for (size_t i = 0; i < num_slots_; ++i) {
+        slots_[i].results_stale = true;
+    }
+}
+
+size_t ArenaPool::overflows() const {
+    size_t overflows = 0;
+    for (size_t i = 0; i < num_slots_; ++i) {
+        overflows += slots_[i].scratch.overflows() + slots_[i].results.overflows();
+    }
+    return overflows;
+}
@@ -0,0 +1,113 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+// Arenas for the memory a replica allocates while it runs, so parallel replicas do not contend in malloc and each
+// keeps its data in one contiguous block. A `ReplicaArena` is a `std::pmr::monotonic_buffer_resource` over a buffer
+// it owns: allocation is a pointer bump, deallocation is a no-op, and `reset()` drops everything at once. When a
+// replica overflows the buffer the overflow comes from the heap, and the next `reset()` grows the buffer to the
+// high-water mark, so after the first few replicas no allocation reaches the heap at all.
+//
+// An `ArenaPool` holds one pair of arenas per worker, handed out per replica:
+//   scratch  state that dies with the replica (the simulator's working storage), reset when the lease ends
+//   results  what the replica leaves behind (monitor buffers), reset by `resetResults()` once those are gone
+//
+//     ArenaPool arenas(threads);
+//     // on a worker:
+//     auto lease = arenas.acquire();
+//     Simulator simulator(std::move(system), end_time, seed, lease.scratch());
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+class ReplicaArena {
+public:
+    explicit ReplicaArena(size_t initial_size = 64 * 1024);
+    ReplicaArena(const ReplicaArena&) = delete;
+    ReplicaArena& operator=(const ReplicaArena&) = delete;
+
+    [[nodiscard]] std::pmr::memory_resource* resource() { return &*monotonic_; }
+
+    // Releases everything allocated from the arena; nothing allocated from it may be used afterwards
+    void reset();
+
+    [[nodiscard]] size_t capacity() const { return size_; }
+    // Allocations that did not fit the buffer and went to the heap, since construction
+    [[nodiscard]] size_t overflows() const { return upstream_.allocations; }
+
+private:
+    // Forwards to the heap and counts what the monotonic resource asks for beyond the buffer
+    class Overflow : public std::pmr::memory_resource {
+    public:
+        size_t allocations = 0, bytes = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    size_t size_;
+    std::unique_ptr<std::byte[]> buffer_;
+    Overflow upstream_;
+    std::optional<std::pmr::monotonic_buffer_resource> monotonic_;
+};
+
+class ArenaPool {
+    struct Slot {
+        ReplicaArena scratch, results;
+        bool results_stale = false;  // reset on the next lease, by the worker that takes it
+    };
+
+public:
+    // The arenas of one replica, returned to the pool (with the scratch arena reset) when the lease is destroyed
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept : pool_(other.pool_), slot_(other.slot_) { other.pool_ = nullptr; }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        [[nodiscard]] std::pmr::memory_resource* scratch() { return pool_->slots_[slot_].scratch.resource(); }
+        [[nodiscard]] std::pmr::memory_resource* results() { return pool_->slots_[slot_].results.resource(); }
+
+    private:
+        friend class ArenaPool;
+        Lease(ArenaPool* pool, size_t slot) : pool_(pool), slot_(slot) {}
+
+        ArenaPool* pool_;
+        size_t slot_;
+    };
+
+    explicit ArenaPool(size_t slots);
+    ArenaPool(const ArenaPool&) = delete;
+    ArenaPool& operator=(const ArenaPool&) = delete;
+
+    // Blocks while every slot is leased; with one slot per worker thread it never does. Workers that always ask for the
+    // same `preferred` slot (their ThreadPool slot) keep their arenas on their own NUMA node, as a buffer that grows
+    // is reallocated, and so first touched, by the worker that leases it.
+    Lease acquire(size_t preferred = SIZE_MAX);
+
+    // Releases the results arenas, each when its slot is next leased. Only call it with no lease out and after
+    // whatever used them is destroyed.
+    void resetResults();
+
+    // Heap allocations made by all arenas, since construction
+    [[nodiscard]] size_t overflows() const;
+
+private:
+    std::unique_ptr<Slot[]> slots_;
+    size_t num_slots_;
+    std::vector<size_t> free_;
+    std::mutex mutex_;
+    std::condition_variable cv_free_;
+
+    void release(size_t slot);
+};
+
+#endif //ARENA_H
@@ -0,0 +1,21 @@
+#ifndef CACHE_LINE_H
+#define CACHE_LINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// For data that several threads write on their hot paths (instrumentation, telemetry and result sink counters and
+// rings), kept on cache lines of its own so no thread invalidates another's line.
+
+// Cache line size of the x86 and ARM cores we run on. std::hardware_destructive_interference_size says the same
+// portably, but GCC warns that it may differ between translation units built for different targets.
+inline constexpr size_t CACHE_LINE = 64;
+
+// Adds to a counter that only the calling thread writes (others may read it): a relaxed load and store are enough
+// and avoid the locked read-modify-write of fetch_add
+inline void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+#endif //CACHE_LINE_H
@@ -0,0 +1,226 @@
+#include "compiled_network.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+CompiledNetwork::Definition CompiledNetwork::define(const System& system) {
+    Definition definition;
+    std::map<std::string, uint32_t> index;
+    for (const auto& [species, amount] : system.getSpecies()) {
+        index.emplace(species.getName(), static_cast<uint32_t>(definition.species_names.size()));
+        definition.species_names.push_back(species.getName());
+        definition.initial_state.push_back(amount);
+    }
+
+    const auto& reactions = system.getReactions();
+    for (uint32_t r = 0; r < reactions.size(); ++r) {
+        const auto& reaction = reactions[r];
+        definition.rates.push_back(reaction.rate());
+        for (const auto& s : reaction.reactants) {
+            definition.reactants.push_back(index.at(s.getName()));
+        }
+        definition.reactant_offsets.push_back(static_cast<uint32_t>(definition.reactants.size()));
+        for (const auto& s : reaction.products) {
+            definition.products.push_back(index.at(s.getName()));
+        }
+        definition.product_offsets.push_back(static_cast<uint32_t>(definition.products.size()));
+
+        for (const auto& breakpoint : reaction.schedule) {
+            definition.scheduled_events.push_back({breakpoint.time, r, false, breakpoint.rate});
+        }
+    }
+    for (const auto& injection : system.getInjections()) {
+        definition.scheduled_events.push_back({injection.time, index.at(injection.species.getName()), true, static_cast<double>(injection.amount)});
+    }
+    return definition;
+}
+
+CompiledNetwork::CompiledNetwork(const System& system) : CompiledNetwork(define(system)) {}
+
+CompiledNetwork::CompiledNetwork(Definition definition)
+        : species_names_(std::move(definition.species_names)), initial_state_(std::move(definition.initial_state)),
+          scheduled_events_(std::move(definition.scheduled_events)) {
+    const size_t num_species = species_names_.size();
+    const size_t num_reactions = definition.rates.size();
+    if (initial_state_.size() != num_species || definition.reactant_offsets.size() != num_reactions + 1
+            || definition.product_offsets.size() != num_reactions + 1) {
+        throw std::runtime_error("Network definition has inconsistent sizes");
+    }
+    auto check = [num_species](const std::vector<uint32_t>& species) {
+        for (auto s : species) {
+            if (s >= num_species) {
+                throw std::runtime_error("Reaction refers to a species that does not exist");
+            }
+        }
+    };
+    check(definition.reactants);
+    check(definition.products);
+
+    owned_.rates = std::move(definition.rates);
+    owned_.reactant_species = std::move(definition.reactants);
+    owned_.reactant_offsets = std::move(definition.reactant_offsets);
+    owned_.change_offsets.reserve(num_reactions + 1);
+    owned_.change_offsets.push_back(0);
+
+    // Scratch buffers reused across reactions, so large networks compile without per-reaction allocations
+    std::vector<uint32_t> products;
+    for (size_t r = 0; r < num_reactions; ++r) {
+        // Sorted so repeated reactants are adjacent, which `canFire` relies on
+        auto first = owned_.reactant_species.begin() + owned_.reactant_offsets[r];
+        auto last = owned_.reactant_species.begin() + owned_.reactant_offsets[r + 1];
+        std::sort(first, last);
+        products.assign(definition.products.begin() + definition.product_offsets[r],
+                        definition.products.begin() + definition.product_offsets[r + 1]);
+        std::sort(products.begin(), products.end());
+
+        // Merge of the two sorted lists gives the net change per species in increasing species order
+        auto p = products.begin();
+        while (first != last || p != products.end()) {
+            const uint32_t s = p == products.end() || (first != last && *first < *p) ? *first : *p;
+            int delta = 0;
+            for (; first != last && *first == s; ++first) {
+                --delta;
+            }
+            for (; p != products.end() && *p == s; ++p) {
+                ++delta;
+            }
+            if (delta != 0) {
+                owned_.change_species.push_back(s);
+                owned_.change_deltas.push_back(delta);
+            }
+        }
+        owned_.change_offsets.push_back(static_cast<uint32_t>(owned_.change_species.size()));
+    }
+
+    // The accessors used below read through the views, which are re-pointed as the arrays are completed
+    view();
+
+    // species -> reactions that read it, counted first so the CSR arrays are filled in place
+    owned_.reader_offsets.assign(num_species + 1, 0);
+    auto forEachReader = [this, num_reactions](auto&& visit) {
+        for (uint32_t r = 0; r < num_reactions; ++r) {
+            auto rs = reactants(r);
+            for (size_t i = 0; i < rs.size(); ++i) {
+                if (i == 0 || rs[i] != rs[i - 1]) {
+                    visit(rs[i], r);
+                }
+            }
+        }
+    };
+    forEachReader([this](uint32_t s, uint32_t) { ++owned_.reader_offsets[s + 1]; });
+    for (size_t s = 0; s < num_species; ++s) {
+        owned_.reader_offsets[s + 1] += owned_.reader_offsets[s];
+    }
+    owned_.reader_reactions.resize(owned_.reader_offsets[num_species]);
+    std::vector<uint32_t> cursor(owned_.reader_offsets.begin(), owned_.reader_offsets.end() - 1);
+    forEachReader([this, &cursor](uint32_t s, uint32_t r) { owned_.reader_reactions[cursor[s]++] = r; });
+
+    view();
+    owned_.dependent_offsets.reserve(num_reactions + 1);
+    owned_.dependent_offsets.push_back(0);
+    std::vector<uint32_t> deps;
+    for (uint32_t r = 0; r < num_reactions; ++r) {
+        deps.clear();
+        for (auto s : changedSpecies(r)) {
+            auto rs = readers(s);
+            deps.insert(deps.end(), rs.begin(), rs.end());
+        }
+        std::sort(deps.begin(), deps.end());
+        deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+
+        owned_.dependent_reactions.insert(owned_.dependent_reactions.end(), deps.begin(), deps.end());
+        owned_.dependent_offsets.push_back(static_cast<uint32_t>(owned_.dependent_reactions.size()));
+    }
+
+    view();
+
+    std::stable_sort(scheduled_events_.begin(), scheduled_events_.end(),
+                     [](const ScheduledEvent& a, const ScheduledEvent& b) { return a.time < b.time; });
+}
+
+CompiledNetwork::CompiledNetwork(const CompiledNetwork& other) {
+    *this = other;
+}
+
+CompiledNetwork& CompiledNetwork::operator=(const CompiledNetwork& other) {
+    species_names_ = other.species_names_;
+    initial_state_ = other.initial_state_;
+    scheduled_events_ = other.scheduled_events_;
+    owned_ = other.owned_;
+    image_ = other.image_;
+
+    rates_ = other.rates_;
+    reactant_offsets_ = other.reactant_offsets_;
+    reactant_species_ = other.reactant_species_;
+    change_offsets_ = other.change_offsets_;
+    change_species_ = other.change_species_;
+    change_deltas_ = other.change_deltas_;
+    dependent_offsets_ = other.dependent_offsets_;
+    dependent_reactions_ = other.dependent_reactions_;
+    reader_offsets_ = other.reader_offsets_;
+    reader_reactions_ = other.reader_reactions_;
+    // Copies of a mapped image share the mapping; copies of built arrays view their own copy
+    if (image_ == nullptr) {
+        view();
+    }
+    return *this;
+}
+
+void CompiledNetwork::view() {
+    rates_ = owned_.rates;
+    reactant_offsets_ = owned_.reactant_offsets;
+    reactant_species_ = owned_.reactant_species;
+    change_offsets_ = owned_.change_offsets;
+    change_species_ = owned_.change_species;
+    change_deltas_ = owned_.change_deltas;
+    dependent_offsets_ = owned_.dependent_offsets;
+    dependent_reactions_ = owned_.dependent_reactions;
+    reader_offsets_ = owned_.reader_offsets;
+    reader_reactions_ = owned_.reader_reactions;
+}
+
+size_t CompiledNetwork::speciesIndex(const std::string& name) const {
+    auto it = std::find(species_names_.begin(), species_names_.end(), name);
+    if (it == species_names_.end()) {
+        throw std::runtime_error("Species '" + name + "' does not exist");
+    }
+    return static_cast<size_t>(it - species_names_.begin());
+}
+
+void CompiledNetwork::requireNoScheduledEvents(const std::string& engine) const {
+    if (!scheduled_events_.empty()) {
+        throw std::runtime_error(engine + " does not support scheduled rate changes or injections");
+    }
+}
+
+bool CompiledNetwork::canFire(size_t r, const int* state) const {
+    auto rs = reactants(r);
+    for (size_t i = 0; i < rs.size();) {
+        size_t count = 1;
+        while (i + count < rs.size() && rs[i + count] == rs[i]) {
+            ++count;
+        }
+        if (state[rs[i]] < static_cast<int>(count)) {
+            return false;
+        }
+        i += count;
+    }
+    return true;
+}
+
+void CompiledNetwork::fire(size_t r, int* state) const {
+    auto species = changedSpecies(r);
+    auto deltas = changeDeltas(r);
+    for (size_t i = 0; i < species.size(); ++i) {
+        state[species[i]] += deltas[i];
+    }
+}
+
+void CompiledNetwork::fire(size_t r, int* state, int64_t k) const {
+    auto species = changedSpecies(r);
+    auto deltas = changeDeltas(r);
+    for (size_t i = 0; i < species.size(); ++i) {
+        state[species[i]] += static_cast<int>(deltas[i] * k);
+    }
+}
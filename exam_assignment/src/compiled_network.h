@@ -0,0 +1,142 @@
+#ifndef COMPILED_NETWORK_H
+#define COMPILED_NETWORK_H
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+// Index-based form of a `System`. Species become positions in a flat state vector and reactions become
+// CSR arrays of species indices, so engines never touch the string-keyed species map in their inner loop.
+class CompiledNetwork {
+public:
+    using State = std::vector<int>;
+
+    // A reaction rate breakpoint or a species injection from the `System`, in compiled form.
+    struct ScheduledEvent {
+        double time;
+        uint32_t target;  // reaction index for rate changes, species index for injections
+        bool injection;
+        double value;     // new rate, or amount added
+    };
+
+    // Index-level description of a network, for loaders that resolve species names themselves. Reactants and
+    // products are CSR lists with one entry per occurrence, in any order; scheduled events need not be sorted.
+    struct Definition {
+        std::vector<std::string> species_names;
+        State initial_state;
+        std::vector<double> rates;
+        std::vector<uint32_t> reactant_offsets{0}, reactants;
+        std::vector<uint32_t> product_offsets{0}, products;
+        std::vector<ScheduledEvent> scheduled_events;
+    };
+
+    explicit CompiledNetwork(const System& system);
+    explicit CompiledNetwork(Definition definition);
+
+    CompiledNetwork(const CompiledNetwork& other);
+    CompiledNetwork(CompiledNetwork&& other) noexcept = default;
+    CompiledNetwork& operator=(const CompiledNetwork& other);
+    CompiledNetwork& operator=(CompiledNetwork&& other) noexcept = default;
+
+    // Writes the network as a position-independent binary image: a header with section offsets followed by the
+    // species names, the initial state, the rates, the CSR arrays, the dependency graph and the scheduled events,
+    // each section 64-byte aligned. See network_image.cpp for the layout.
+    void saveImage(const std::filesystem::path& path) const;
+    // Maps an image written by `saveImage` read-only. The rates, CSR arrays and dependency graph are used in place,
+    // so processes mapping the same file share its pages and loading costs O(species), not O(reactions).
+    static CompiledNetwork mapImage(const std::filesystem::path& path);
+
+    [[nodiscard]] size_t numSpecies() const { return species_names_.size(); }
+    [[nodiscard]] size_t numReactions() const { return rates_.size(); }
+
+    [[nodiscard]] const std::vector<std::string>& speciesNames() const { return species_names_; }
+    [[nodiscard]] size_t speciesIndex(const std::string& name) const;
+    [[nodiscard]] const State& initialState() const { return initial_state_; }
+
+    [[nodiscard]] double rate(size_t r) const { return rates_[r]; }
+
+    // Reactant species of reaction `r`, one entry per occurrence (so `A + A` lists A twice).
+    [[nodiscard]] std::span<const uint32_t> reactants(size_t r) const {
+        return {reactant_species_.data() + reactant_offsets_[r], reactant_offsets_[r + 1] - reactant_offsets_[r]};
+    }
+
+    // Net state change of reaction `r`; species with a net change of zero (catalysts) are left out.
+    [[nodiscard]] std::span<const uint32_t> changedSpecies(size_t r) const {
+        return {change_species_.data() + change_offsets_[r], change_offsets_[r + 1] - change_offsets_[r]};
+    }
+    [[nodiscard]] std::span<const int> changeDeltas(size_t r) const {
+        return {change_deltas_.data() + change_offsets_[r], change_offsets_[r + 1] - change_offsets_[r]};
+    }
+
+    // Reactions whose propensity may change when `r` fires (including `r` itself if it consumes its own reactants).
+    [[nodiscard]] std::span<const uint32_t> dependents(size_t r) const {
+        return {dependent_reactions_.data() + dependent_offsets_[r], dependent_offsets_[r + 1] - dependent_offsets_[r]};
+    }
+
+    // Reactions whose propensity reads species `s`.
+    [[nodiscard]] std::span<const uint32_t> readers(size_t s) const {
+        return {reader_reactions_.data() + reader_offsets_[s], reader_offsets_[s + 1] - reader_offsets_[s]};
+    }
+
+    // Rate changes and injections sorted by time. Engines that support them keep their own copy of the rates.
+    [[nodiscard]] const std::vector<ScheduledEvent>& scheduledEvents() const { return scheduled_events_; }
+    // For the engines that do not apply them: throws if the network has any, rather than quietly simulating without
+    void requireNoScheduledEvents(const std::string& engine) const;
+
+    // ∏i Ri,k, i.e. the propensity without the rate constant
+    [[nodiscard]] double massAction(size_t r, const int* state) const {
+        double a = 1.0;
+        for (auto s : reactants(r)) {
+            a *= state[s];
+        }
+        return a;
+    }
+
+    // λk = λ * ∏i Ri,k - the same mass-action rule as `Simulator::compute_delay`.
+    [[nodiscard]] double propensity(size_t r, const int* state) const {
+        return rates_[r] * massAction(r, state);
+    }
+
+    [[nodiscard]] bool canFire(size_t r, const int* state) const;
+    void fire(size_t r, int* state) const;
+
+    // Applies `k` firings of reaction `r` at once (used by leaping engines).
+    void fire(size_t r, int* state, int64_t k) const;
+
+private:
+    // Per-reaction arrays built by the constructors. They stay empty for a mapped image.
+    struct Arrays {
+        std::vector<double> rates;
+        std::vector<uint32_t> reactant_offsets, reactant_species;
+        std::vector<uint32_t> change_offsets, change_species;
+        std::vector<int> change_deltas;
+        std::vector<uint32_t> dependent_offsets, dependent_reactions;
+        std::vector<uint32_t> reader_offsets, reader_reactions;
+    };
+
+    std::vector<std::string> species_names_;
+    State initial_state_;
+    std::vector<ScheduledEvent> scheduled_events_;
+    Arrays owned_;
+    std::shared_ptr<const void> image_;  // keeps a mapped image alive
+
+    // What the accessors read: views into `owned_` or into the mapped image
+    std::span<const double> rates_;
+    std::span<const uint32_t> reactant_offsets_, reactant_species_;
+    std::span<const uint32_t> change_offsets_, change_species_;
+    std::span<const int> change_deltas_;
+    std::span<const uint32_t> dependent_offsets_, dependent_reactions_;
+    std::span<const uint32_t> reader_offsets_, reader_reactions_;
+
+    CompiledNetwork() = default;
+    static Definition define(const System& system);
+    // Points the views at `owned_`
+    void view();
+};
+
+#endif //COMPILED_NETWORK_H
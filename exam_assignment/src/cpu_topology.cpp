@@ -0,0 +1,121 @@
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <charconv>
+#include <numeric>
+#include <thread>
+
+#ifdef __linux__
+#include <filesystem>
+#include <fstream>
+#include <sched.h>
+#endif
+
+std::string_view to_string(Placement placement) {
+    switch (placement) {
+        case Placement::None: return "none";
+        case Placement::Cores: return "cores";
+        case Placement::Sockets: return "sockets";
+        default: return "unknown";
+    }
+}
+
+size_t CpuTopology::numCpus() const {
+    size_t cpus = 0;
+    for (const auto& node : nodes) {
+        cpus += node.size();
+    }
+    return cpus;
+}
+
+std::vector<int> parse_cpu_list(std::string_view list) {
+    std::vector<int> cpus;
+    while (!list.empty()) {
+        const auto comma = list.find(',');
+        const auto range = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+        int first = 0, last = 0;
+        const auto dash = range.find('-');
+        const auto first_end = range.data() + (dash == std::string_view::npos ? range.size() : dash);
+        if (std::from_chars(range.data(), first_end, first).ec != std::errc()) {
+            continue;  // blank or trailing newline
+        }
+        last = first;
+        if (dash != std::string_view::npos) {
+            std::from_chars(range.data() + dash + 1, range.data() + range.size(), last);
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+#ifdef __linux__
+CpuTopology CpuTopology::detect() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const bool have_affinity = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    auto usable = [&](int cpu) { return !have_affinity || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)); };
+
+    CpuTopology topology;
+    std::error_code error;
+    std::vector<std::pair<int, std::vector<int>>> nodes;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+        const auto name = entry.path().filename().string();
+        int id = 0;
+        if (name.rfind("node", 0) != 0 || std::from_chars(name.data() + 4, name.data() + name.size(), id).ec != std::errc()) {
+            continue;
+        }
+        std::ifstream in(entry.path() / "cpulist");
+        std::string list;
+        std::getline(in, list);
+        auto cpus = parse_cpu_list(list);
+        std::erase_if(cpus, [&](int cpu) { return !usable(cpu); });
+        if (!cpus.empty()) {
+            nodes.emplace_back(id, std::move(cpus));
+        }
+    }
+    std::sort(nodes.begin(), nodes.end());
+    for (auto& [id, cpus] : nodes) {
+        topology.nodes.push_back(std::move(cpus));
+    }
+
+    if (topology.nodes.empty()) {
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (have_affinity && CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (cpus.empty()) {
+            cpus.resize(std::max(1u, std::thread::hardware_concurrency()));
+            std::iota(cpus.begin(), cpus.end(), 0);
+        }
+        topology.nodes.push_back(std::move(cpus));
+    }
+    return topology;
+}
+
+bool pin_current_thread(std::span<const int> cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return CPU_COUNT(&set) > 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+#else
+CpuTopology CpuTopology::detect() {
+    std::vector<int> cpus(std::max(1u, std::thread::hardware_concurrency()));
+    std::iota(cpus.begin(), cpus.end(), 0);
+    return {{std::move(cpus)}};
+}
+
+bool pin_current_thread(std::span<const int>) {
+    return false;
+}
+#endif
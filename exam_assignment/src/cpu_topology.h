@@ -0,0 +1,38 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+// Which CPUs belong to which NUMA node (socket), and pinning threads to them. On Linux the nodes come from
+// /sys/devices/system/node, restricted to the CPUs the process may run on. Elsewhere, and where sysfs is not
+// available (some containers), the machine is one node with `hardware_concurrency` CPUs and pinning does nothing,
+// so every placement degrades to the default scheduling.
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class Placement {
+    None,     // threads float, as scheduled by the OS
+    Cores,    // every worker pinned to a core of its own, workers split evenly over the sockets
+    Sockets   // every worker pinned to the cores of one socket, free to move within it
+};
+
+std::string_view to_string(Placement placement);
+
+struct CpuTopology {
+    std::vector<std::vector<int>> nodes;  // usable CPUs of each NUMA node; nodes without any are left out
+
+    static CpuTopology detect();
+
+    [[nodiscard]] size_t numCpus() const;
+    [[nodiscard]] bool numa() const { return nodes.size() > 1; }
+};
+
+// The CPUs of a sysfs CPU list such as "0-3,8,10-11"
+std::vector<int> parse_cpu_list(std::string_view list);
+
+// Restricts the calling thread to `cpus`. Returns false, changing nothing, where affinity is unsupported or refused.
+bool pin_current_thread(std::span<const int> cpus);
+
+#endif //CPU_TOPOLOGY_H
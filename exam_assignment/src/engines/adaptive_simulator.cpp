@@ -0,0 +1,531 @@
+#include "adaptive_simulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+#include "../instrumentation.h"
+
+namespace {
+    using instrumentation::Counter;
+    using instrumentation::Phase;
+    using instrumentation::ScopedPhase;
+
+    constexpr double NEVER = std::numeric_limits<double>::infinity();  // firing time of a reaction that cannot fire
+    // frexp exponents of finite doubles lie in [-1073, 1024]
+    constexpr int MIN_EXPONENT = -1080;
+    constexpr int MAX_EXPONENT = 1030;
+    constexpr int NUM_GROUPS = MAX_EXPONENT - MIN_EXPONENT + 1;
+
+    int group_of(double a) {
+        int exponent;
+        std::frexp(a, &exponent);
+        return exponent - MIN_EXPONENT;
+    }
+}
+
+std::string_view to_string(EngineKind engine) {
+    switch (engine) {
+        case EngineKind::Direct: return "direct";
+        case EngineKind::NextReaction: return "next reaction";
+        case EngineKind::CompositionRejection: return "composition-rejection";
+        case EngineKind::TauLeaping: return "tau-leaping";
+    }
+    return "unknown";
+}
+
+std::ostream& operator<<(std::ostream& os, const EngineDecision& decision) {
+    return os << "t=" << decision.time << ": " << to_string(decision.engine) << " (" << decision.reason << ")";
+}
+
+NetworkStatistics NetworkStatistics::of(const CompiledNetwork& network, std::span<const int> state,
+                                        std::span<const double> propensities, double tau) {
+    NetworkStatistics statistics;
+    statistics.reactions = network.numReactions();
+
+    size_t total_fanout = 0;
+    double min_a = std::numeric_limits<double>::infinity(), max_a = 0;
+    int min_amount = std::numeric_limits<int>::max();
+    for (size_t r = 0; r < network.numReactions(); ++r) {
+        const auto fanout = network.dependents(r).size();
+        total_fanout += fanout;
+        statistics.max_fanout = std::max(statistics.max_fanout, fanout);
+
+        if (propensities[r] > 0) {
+            statistics.a0 += propensities[r];
+            min_a = std::min(min_a, propensities[r]);
+            max_a = std::max(max_a, propensities[r]);
+            for (auto s : network.reactants(r)) {
+                min_amount = std::min(min_amount, state[s]);
+            }
+        }
+    }
+
+    if (statistics.reactions > 0) {
+        statistics.mean_fanout = static_cast<double>(total_fanout) / static_cast<double>(statistics.reactions);
+    }
+    statistics.min_reactant_amount = min_amount == std::numeric_limits<int>::max() ? 0 : min_amount;
+    statistics.propensity_octaves = max_a > 0 ? std::log2(max_a / min_a) : 0;
+    statistics.leap_gain = statistics.a0 > 0 ? statistics.a0 * tau : 0;
+    return statistics;
+}
+
+EngineKind AdaptiveSimulator::select(const NetworkStatistics& statistics, const AdaptiveOptions& options) {
+    if (statistics.leap_gain >= options.leap_gain) {
+        return EngineKind::TauLeaping;
+    }
+    if (statistics.reactions <= options.direct_max_reactions) {
+        return EngineKind::Direct;
+    }
+    if (statistics.propensity_octaves <= options.composition_max_octaves) {
+        return EngineKind::CompositionRejection;
+    }
+    const double reactions = static_cast<double>(statistics.reactions);
+    return statistics.mean_fanout * std::log2(reactions) < reactions ? EngineKind::NextReaction : EngineKind::Direct;
+}
+
+std::string AdaptiveSimulator::explain(EngineKind engine, const NetworkStatistics& statistics, const AdaptiveOptions& options) {
+    std::ostringstream reason;
+    switch (engine) {
+        case EngineKind::TauLeaping:
+            reason << "a leap covers " << statistics.leap_gain << " firings, smallest reactant population "
+                   << statistics.min_reactant_amount;
+            break;
+        case EngineKind::CompositionRejection:
+            reason << "propensities span " << statistics.propensity_octaves << " octaves, selection is O(groups)";
+            break;
+        case EngineKind::NextReaction:
+            reason << "mean fan-out " << statistics.mean_fanout << " of " << statistics.reactions
+                   << " reactions, queue updates beat a scan";
+            break;
+        default:
+            if (statistics.reactions <= options.direct_max_reactions) {
+                reason << statistics.reactions << " reactions, a linear scan is cheapest";
+            } else {
+                reason << "mean fan-out " << statistics.mean_fanout << " is too high for a queue";
+            }
+    }
+    return reason.str();
+}
+
+std::pair<EngineKind, std::string> AdaptiveSimulator::choose(const NetworkStatistics& statistics, const AdaptiveOptions& options) {
+    const auto engine = select(statistics, options);
+    return {engine, explain(engine, statistics, options)};
+}
+
+AdaptiveSimulator::AdaptiveSimulator(const CompiledNetwork& network, double end_time, unsigned seed, AdaptiveOptions options)
+        : network_(network), end_time_(end_time), options_(options), generator_(seed),
+          propensities_(network.numReactions()), queue_(network.numReactions()),
+          members_(network.numReactions()), group_begin_(NUM_GROUPS + 1), group_sum_(NUM_GROUPS),
+          group_of_(network.numReactions(), -1), slot_(network.numReactions()), highest_order_(network.numSpecies(), 0),
+          mu_(network.numSpecies()), sigma_(network.numSpecies()) {
+    for (size_t r = 0; r < network.numReactions(); ++r) {
+        rates_.push_back(network.rate(r));
+        const auto order = static_cast<int>(network.reactants(r).size());
+        for (auto s : network.reactants(r)) {
+            highest_order_[s] = std::max(highest_order_[s], order);
+        }
+    }
+    std::iota(members_.begin(), members_.end(), 0);
+    std::iota(slot_.begin(), slot_.end(), 0);
+}
+
+void AdaptiveSimulator::swapMembers(uint32_t i, uint32_t j) {
+    std::swap(members_[i], members_[j]);
+    slot_[members_[i]] = i;
+    slot_[members_[j]] = j;
+}
+
+void AdaptiveSimulator::groupInsert(size_t r) {
+    if (propensities_[r] <= 0) {
+        group_of_[r] = -1;
+        return;
+    }
+    const auto g = group_of(propensities_[r]);
+
+    // Appended to the active reactions, i.e. to the end of the highest group ...
+    swapMembers(slot_[r], active_++);
+    if (highest_group_ < lowest_group_) {
+        lowest_group_ = highest_group_ = g;
+        group_begin_[g] = 0;
+    } else if (g > highest_group_) {
+        for (int h = highest_group_ + 1; h <= g; ++h) {
+            group_begin_[h] = active_ - 1;
+        }
+        highest_group_ = g;
+    } else {
+        for (int h = g; h < lowest_group_; ++h) {
+            group_begin_[h] = 0;
+        }
+        lowest_group_ = std::min(lowest_group_, g);
+        // ... and moved down: the first member of each group above g takes its place at that group's end
+        for (int h = highest_group_; h > g; --h) {
+            swapMembers(slot_[r], group_begin_[h]++);
+        }
+    }
+    group_begin_[highest_group_ + 1] = active_;
+    group_of_[r] = g;
+    group_sum_[g] += propensities_[r];
+}
+
+void AdaptiveSimulator::groupRemove(size_t r, double old_a) {
+    const auto g = group_of_[r];
+    if (g < 0) {
+        return;
+    }
+    group_sum_[g] = groupSize(g) == 1 ? 0 : group_sum_[g] - old_a;
+
+    // Moved up to the end of the highest group and out of the active reactions
+    for (int h = g + 1; h <= highest_group_; ++h) {
+        swapMembers(slot_[r], --group_begin_[h]);
+    }
+    swapMembers(slot_[r], --active_);
+    group_begin_[highest_group_ + 1] = active_;
+    group_of_[r] = -1;
+
+    while (highest_group_ >= lowest_group_ && groupSize(highest_group_) == 0) {
+        --highest_group_;
+    }
+    while (lowest_group_ <= highest_group_ && groupSize(lowest_group_) == 0) {
+        ++lowest_group_;
+    }
+}
+
+void AdaptiveSimulator::rebuild(double t, const CompiledNetwork::State& state) {
+    for (size_t r = 0; r < propensities_.size(); ++r) {
+        propensities_[r] = rates_[r] * network_.massAction(r, state.data());
+    }
+    // Resum on every rebuild so the incrementally updated a0 does not drift
+    a0_ = std::accumulate(propensities_.begin(), propensities_.end(), 0.0);
+
+    if (engine_ == EngineKind::NextReaction) {
+        std::exponential_distribution<double> exponential(1.0);
+        for (size_t r = 0; r < propensities_.size(); ++r) {
+            queue_.update(r, propensities_[r] > 0 ? t + exponential(generator_) / propensities_[r] : NEVER);
+        }
+        instrumentation::count(Counter::HeapOperations, propensities_.size());
+    } else if (engine_ == EngineKind::CompositionRejection) {
+        // Counting sort by group, with the reactions that cannot fire after the active ones
+        std::fill(group_sum_.begin(), group_sum_.end(), 0.0);
+        active_ = 0;
+        lowest_group_ = NUM_GROUPS;
+        highest_group_ = -1;
+        for (size_t r = 0; r < propensities_.size(); ++r) {
+            group_of_[r] = propensities_[r] > 0 ? group_of(propensities_[r]) : -1;
+            if (group_of_[r] >= 0) {
+                ++active_;
+                lowest_group_ = std::min(lowest_group_, group_of_[r]);
+                highest_group_ = std::max(highest_group_, group_of_[r]);
+                group_sum_[group_of_[r]] += propensities_[r];
+            }
+        }
+        if (highest_group_ >= lowest_group_) {
+            std::fill(group_begin_.begin() + lowest_group_, group_begin_.begin() + highest_group_ + 2, 0);
+            for (size_t r = 0; r < propensities_.size(); ++r) {
+                if (group_of_[r] >= 0) {
+                    ++group_begin_[group_of_[r] + 1];
+                }
+            }
+            for (int g = lowest_group_ + 1; g <= highest_group_ + 1; ++g) {
+                group_begin_[g] += group_begin_[g - 1];
+            }
+        }
+        uint32_t inactive = active_;
+        for (size_t r = 0; r < propensities_.size(); ++r) {
+            const auto slot = group_of_[r] >= 0 ? group_begin_[group_of_[r]]++ : inactive++;
+            members_[slot] = static_cast<uint32_t>(r);
+            slot_[r] = slot;
+        }
+        // Placing advanced each group's begin to the next group's, so shift them back
+        for (int g = highest_group_; g > lowest_group_; --g) {
+            group_begin_[g] = group_begin_[g - 1];
+        }
+        if (highest_group_ >= lowest_group_) {
+            group_begin_[lowest_group_] = 0;
+        }
+    }
+}
+
+void AdaptiveSimulator::setPropensity(size_t r, double a, double t) {
+    const double old = propensities_[r];
+    propensities_[r] = a;
+    a0_ += a - old;
+
+    if (engine_ == EngineKind::NextReaction) {
+        // Gibson & Bruck: rescale the remaining waiting time instead of drawing a new one
+        const double scheduled = queue_.key(r);
+        double next = NEVER;
+        if (a > 0) {
+            next = old > 0 && scheduled < NEVER
+                    ? t + old / a * (scheduled - t)
+                    : t + std::exponential_distribution<double>(1.0)(generator_) / a;
+        }
+        queue_.update(r, next);
+    } else if (engine_ == EngineKind::CompositionRejection) {
+        if (a > 0 && group_of_[r] >= 0 && group_of(a) == group_of_[r]) {
+            group_sum_[group_of_[r]] += a - old;  // most updates stay within their power of two
+        } else {
+            groupRemove(r, old);
+            groupInsert(r);
+        }
+    }
+}
+
+double AdaptiveSimulator::selectTau(const CompiledNetwork::State& state) {
+    std::fill(mu_.begin(), mu_.end(), 0.0);
+    std::fill(sigma_.begin(), sigma_.end(), 0.0);
+    for (size_t r = 0; r < propensities_.size(); ++r) {
+        const auto species = network_.changedSpecies(r);
+        const auto deltas = network_.changeDeltas(r);
+        for (size_t i = 0; i < species.size(); ++i) {
+            mu_[species[i]] += deltas[i] * propensities_[r];
+            sigma_[species[i]] += static_cast<double>(deltas[i]) * deltas[i] * propensities_[r];
+        }
+    }
+
+    // Cao, Gillespie & Petzold (2006): bound the expected change and its standard deviation of every reactant
+    // species by max(epsilon * x / g, 1), where g is the highest order of the reactions it takes part in
+    double tau = std::numeric_limits<double>::infinity();
+    for (size_t s = 0; s < state.size(); ++s) {
+        if (highest_order_[s] == 0) {
+            continue;
+        }
+        const double bound = std::max(options_.epsilon * state[s] / highest_order_[s], 1.0);
+        if (mu_[s] != 0) {
+            tau = std::min(tau, bound / std::abs(mu_[s]));
+        }
+        if (sigma_[s] > 0) {
+            tau = std::min(tau, bound * bound / sigma_[s]);
+        }
+    }
+    return tau;
+}
+
+void AdaptiveSimulator::evaluate(double t, const CompiledNetwork::State& state, bool initial) {
+    const auto statistics = NetworkStatistics::of(network_, state, propensities_, selectTau(state));
+    const auto engine = options_.engine ? *options_.engine : select(statistics, options_);
+
+    // The reason is only formatted for a recorded decision, so re-evaluating without a switch does not allocate
+    if (initial || engine != engine_) {
+        engine_ = engine;
+        metadata_.decisions.push_back({t, engine, statistics,
+                                       options_.engine ? "forced by the options" : explain(engine, statistics, options_)});
+    }
+    rebuild(t, state);
+}
+
+void AdaptiveSimulator::applyScheduledEvent(const CompiledNetwork::ScheduledEvent& event, CompiledNetwork::State& state, double t) {
+    if (!event.injection) {
+        rates_[event.target] = event.value;
+        setPropensity(event.target, rates_[event.target] * network_.massAction(event.target, state.data()), t);
+        return;
+    }
+
+    state[event.target] = std::max(0, state[event.target] + static_cast<int>(event.value));
+    for (auto d : network_.readers(event.target)) {
+        setPropensity(d, rates_[d] * network_.massAction(d, state.data()), t);
+    }
+}
+
+double AdaptiveSimulator::nextDirect(double t, size_t& r) {
+    if (a0_ <= 0) {
+        return NEVER;
+    }
+    const double dt = std::exponential_distribution<double>(a0_)(generator_);
+    double target = std::uniform_real_distribution<double>(0.0, a0_)(generator_);
+    // a0_ is maintained incrementally and can exceed the actual sum; the target then falls to the last reaction
+    // that can fire, never to one with propensity 0
+    r = propensities_.size();
+    for (size_t i = 0; i < propensities_.size(); ++i) {
+        if (propensities_[i] <= 0) {
+            continue;
+        }
+        r = i;
+        if (target < propensities_[i]) {
+            break;
+        }
+        target -= propensities_[i];
+    }
+    return r < propensities_.size() ? t + dt : NEVER;
+}
+
+double AdaptiveSimulator::nextComposition(double t, size_t& r) {
+    if (a0_ <= 0 || highest_group_ < 0) {
+        return NEVER;
+    }
+    const double dt = std::exponential_distribution<double>(a0_)(generator_);
+
+    // Composition: a group with probability proportional to its sum ...
+    double target = std::uniform_real_distribution<double>(0.0, a0_)(generator_);
+    int g = -1;
+    for (int i = lowest_group_; i <= highest_group_; ++i) {
+        if (groupSize(i) == 0) {
+            continue;
+        }
+        g = i;
+        if (target < group_sum_[i]) {
+            break;
+        }
+        target -= group_sum_[i];
+    }
+    if (g < 0) {
+        return NEVER;  // only rounding residue left in a0
+    }
+
+    // ... rejection: a uniform member, accepted with probability a / 2^exponent, which is at least 1/2
+    const double bound = std::ldexp(1.0, g + MIN_EXPONENT);
+    std::uniform_int_distribution<uint32_t> pick(group_begin_[g], group_begin_[g + 1] - 1);
+    std::uniform_real_distribution<double> uniform(0.0, bound);
+    do {
+        r = members_[pick(generator_)];
+    } while (uniform(generator_) >= propensities_[r]);
+
+    return t + dt;
+}
+
+bool AdaptiveSimulator::leap(double t, double h, CompiledNetwork::State& state) {
+    trial_ = state;
+    size_t firings = 0;
+    for (size_t r = 0; r < propensities_.size(); ++r) {
+        if (propensities_[r] <= 0) {
+            continue;
+        }
+        const auto k = std::poisson_distribution<int64_t>(propensities_[r] * h)(generator_);
+        if (k > 0) {
+            network_.fire(r, trial_.data(), k);
+            firings += static_cast<size_t>(k);
+        }
+    }
+
+    // Rejecting a leap that drives a species negative, rather than clamping it, keeps the counts consistent
+    if (std::any_of(trial_.begin(), trial_.end(), [](int x) { return x < 0; })) {
+        ++metadata_.rejected_leaps;
+        instrumentation::count(Counter::Rejected);
+        return false;
+    }
+
+    state.swap(trial_);
+    ++metadata_.leaps;
+    metadata_.leaped_firings += firings;
+    instrumentation::count(Counter::Events, firings);
+    rebuild(t + h, state);
+    return true;
+}
+
+void AdaptiveSimulator::simulate(StateMonitor& monitor) {
+    auto state = network_.initialState();
+    const auto& events = network_.scheduledEvents();
+    size_t next_event = 0;
+
+    double t = 0;
+    evaluate(t, state, true);
+
+    size_t steps = 0;
+    while (t <= end_time_) {
+        const double next_event_time = next_event < events.size() ? events[next_event].time : NEVER;
+
+        if (engine_ == EngineKind::TauLeaping) {
+            double tau;
+            {
+                ScopedPhase phase(Phase::Selection);
+                tau = selectTau(state);
+            }
+            if (!options_.engine && a0_ * tau < options_.exact_gain) {
+                evaluate(t, state, false);
+                continue;
+            }
+
+            double h = std::min({tau, next_event_time - t, end_time_ - t});
+            if (h <= 0 && t >= end_time_) {
+                break;
+            }
+            {
+                // A leap draws, applies and re-evaluates every reaction at once
+                ScopedPhase phase(Phase::StateUpdate);
+                while (h > 0 && !leap(t, h, state)) {
+                    h /= 2;
+                }
+            }
+            t += h;
+
+            if (t >= next_event_time) {
+                applyScheduledEvent(events[next_event++], state, t);
+            }
+            {
+                ScopedPhase phase(Phase::MonitorCallback);
+                monitor(network_, state, t);
+            }
+            if (t >= end_time_) {
+                break;
+            }
+            continue;
+        }
+
+        size_t r = 0;
+        double t_next;
+        {
+            ScopedPhase phase(Phase::Selection);
+            switch (engine_) {
+                case EngineKind::NextReaction:
+                    t_next = queue_.topKey();
+                    r = queue_.top();
+                    break;
+                case EngineKind::CompositionRejection:
+                    t_next = nextComposition(t, r);
+                    break;
+                default:
+                    t_next = nextDirect(t, r);
+            }
+        }
+
+        if (t_next >= next_event_time && next_event_time <= end_time_) {
+            // By memorylessness the drawn event can be dropped; the NRM queue is redrawn from the new time
+            t = next_event_time;
+            applyScheduledEvent(events[next_event++], state, t);
+            rebuild(t, state);
+            ScopedPhase phase(Phase::MonitorCallback);
+            monitor(network_, state, t);
+            continue;
+        }
+        if (t_next > end_time_) {
+            break;
+        }
+
+        t = t_next;
+        if (network_.canFire(r, state.data())) {
+            {
+                ScopedPhase phase(Phase::StateUpdate);
+                network_.fire(r, state.data());
+            }
+            {
+                ScopedPhase phase(Phase::PropensityUpdate);
+                const auto dependents = network_.dependents(r);
+                for (auto d : dependents) {
+                    setPropensity(d, rates_[d] * network_.massAction(d, state.data()), t);
+                }
+                if (engine_ == EngineKind::NextReaction) {
+                    instrumentation::count(Counter::HeapOperations, dependents.size());
+                }
+            }
+            ++metadata_.exact_events;
+            instrumentation::count(Counter::Events);
+            ScopedPhase phase(Phase::MonitorCallback);
+            monitor(network_, state, t);
+        } else {
+            instrumentation::count(Counter::Rejected);
+        }
+        if (engine_ == EngineKind::NextReaction) {
+            // The fired reaction always needs a fresh waiting time, even if it does not depend on itself
+            queue_.update(r, propensities_[r] > 0
+                    ? t + std::exponential_distribution<double>(1.0)(generator_) / propensities_[r]
+                    : NEVER);
+            instrumentation::count(Counter::HeapOperations);
+        }
+
+        if (++steps % options_.reevaluation_steps == 0) {
+            evaluate(t, state, false);
+        }
+    }
+}
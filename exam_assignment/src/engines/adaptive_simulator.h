@@ -0,0 +1,129 @@
+#ifndef ADAPTIVE_SIMULATOR_H
+#define ADAPTIVE_SIMULATOR_H
+
+#include <optional>
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../compiled_network.h"
+#include "../indexed_priority_queue.h"
+#include "../monitor/monitor.h"
+
+enum class EngineKind {
+    Direct,                // Gillespie's direct method, linear search over the propensities
+    NextReaction,          // Gibson & Bruck, indexed priority queue of absolute firing times
+    CompositionRejection,  // Slepoy, Thompson & Plimpton, propensities binned by powers of two
+    TauLeaping             // Cao, Gillespie & Petzold step size, Poisson firings per channel
+};
+
+std::string_view to_string(EngineKind engine);
+
+// What the engine choice is based on, measured on the compiled network and the current state.
+struct NetworkStatistics {
+    size_t reactions = 0;
+    double mean_fanout = 0;         // mean size of the dependency lists
+    size_t max_fanout = 0;
+    int min_reactant_amount = 0;    // smallest population read by a reaction that can currently fire
+    double propensity_octaves = 0;  // log2(max / min) over the positive propensities
+    double a0 = 0;
+    double leap_gain = 0;           // a0 * tau, i.e. the expected number of firings a single leap would cover
+
+    static NetworkStatistics of(const CompiledNetwork& network, std::span<const int> state,
+                                std::span<const double> propensities, double tau);
+};
+
+struct AdaptiveOptions {
+    std::optional<EngineKind> engine;   // forces one engine and disables switching
+    double epsilon = 0.03;              // tau-leaping error control: bound on the relative change of a species
+    double leap_gain = 10;              // leap once a leap covers at least this many firings ...
+    double exact_gain = 3;              // ... and fall back to an exact engine when it covers fewer than this
+    size_t direct_max_reactions = 32;   // networks this small scan their propensities faster than any index
+    double composition_max_octaves = 20;
+    size_t reevaluation_steps = 1000;   // exact events between re-evaluations of the choice
+};
+
+// One entry per engine switch (the first is the initial choice), kept as run metadata.
+struct EngineDecision {
+    double time;
+    EngineKind engine;
+    NetworkStatistics statistics;
+    std::string reason;
+};
+
+std::ostream& operator<<(std::ostream& os, const EngineDecision& decision);
+
+struct RunMetadata {
+    std::vector<EngineDecision> decisions;
+    size_t exact_events = 0;
+    size_t leaps = 0, leaped_firings = 0, rejected_leaps = 0;
+};
+
+// Facade over the exact and leaping engines that picks one from the network statistics and keeps re-evaluating the
+// choice while it runs. All engines share the state and the propensity vector, so a switch only rebuilds the
+// index structure of the new engine (the NRM queue or the composition-rejection groups); by memorylessness the
+// tentative firing times of the old engine can simply be dropped. A typical SEIHR run starts exact while there
+// are only a handful of infectious, leaps through the peak, and goes back to exact as the epidemic dies out.
+// Scheduled rate changes and injections are supported by every engine.
+class AdaptiveSimulator {
+public:
+    AdaptiveSimulator(const CompiledNetwork& network, double end_time, unsigned seed, AdaptiveOptions options = {});
+
+    // Exact engines report every event to the monitor, tau-leaping every leap.
+    void simulate(StateMonitor& monitor);
+
+    [[nodiscard]] const RunMetadata& metadata() const { return metadata_; }
+
+    // The selection policy on its own, returning the engine and a human-readable reason.
+    static std::pair<EngineKind, std::string> choose(const NetworkStatistics& statistics, const AdaptiveOptions& options);
+    // The two halves of `choose`; the engine alone is cheap enough to decide every `reevaluation_steps`
+    static EngineKind select(const NetworkStatistics& statistics, const AdaptiveOptions& options);
+    static std::string explain(EngineKind engine, const NetworkStatistics& statistics, const AdaptiveOptions& options);
+
+private:
+    const CompiledNetwork& network_;
+    double end_time_;
+    AdaptiveOptions options_;
+    std::mt19937_64 generator_;
+
+    std::vector<double> rates_, propensities_;
+    double a0_ = 0;
+    EngineKind engine_ = EngineKind::Direct;
+    RunMetadata metadata_;
+
+    IndexedPriorityQueue queue_;      // NextReaction
+    // CompositionRejection. The reactions with a positive propensity lead `members_`, sorted by group, so group g is
+    // members_[group_begin_[g], group_begin_[g + 1]) and a reaction changes group by swapping across the boundaries
+    // in between; unlike a member list per group this never allocates. Groups are indexed by frexp exponent - MIN_EXPONENT.
+    std::vector<uint32_t> members_;
+    std::vector<uint32_t> group_begin_;  // valid from the lowest to one past the highest group
+    std::vector<double> group_sum_;
+    uint32_t active_ = 0;
+    int lowest_group_ = 0, highest_group_ = -1;
+    std::vector<int32_t> group_of_;   // per reaction, -1 when its propensity is zero
+    std::vector<uint32_t> slot_;      // position in `members_`
+    std::vector<int> highest_order_;  // per species, for the tau selection
+    std::vector<double> mu_, sigma_;  // per species, expected change and variance per unit time
+    CompiledNetwork::State trial_;
+
+    // Recomputes the propensities and a0 from scratch and builds the active engine's index
+    void rebuild(double t, const CompiledNetwork::State& state);
+    void evaluate(double t, const CompiledNetwork::State& state, bool initial);
+    double selectTau(const CompiledNetwork::State& state);
+    // Sets the propensity of `r` and keeps a0 and the active engine's index in sync
+    void setPropensity(size_t r, double a, double t);
+    void applyScheduledEvent(const CompiledNetwork::ScheduledEvent& event, CompiledNetwork::State& state, double t);
+
+    // Returns the time of the next event, or +inf, without firing it
+    double nextDirect(double t, size_t& r);
+    double nextComposition(double t, size_t& r);
+    [[nodiscard]] uint32_t groupSize(int g) const { return group_begin_[g + 1] - group_begin_[g]; }
+    void swapMembers(uint32_t i, uint32_t j);
+    void groupInsert(size_t r);
+    void groupRemove(size_t r, double old_a);
+    bool leap(double t, double h, CompiledNetwork::State& state);
+};
+
+#endif //ADAPTIVE_SIMULATOR_H
@@ -0,0 +1,162 @@
+#include "fsp_solver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    struct StateHash {
+        std::size_t operator()(const std::vector<int>& state) const {
+            std::size_t h = 0;
+            for (auto x : state) {
+                h = h * 1000003u ^ std::hash<int>{}(x);
+            }
+            return h;
+        }
+    };
+
+    struct Transition {
+        uint32_t to, from;
+        double rate;
+    };
+}
+
+FspSolver::FspSolver(const System& system, FspOptions options) : network_(system), options_(options) {
+    network_.requireNoScheduledEvents("The FSP solver");
+    enumerate();
+}
+
+void FspSolver::enumerate() {
+    const auto num_species = network_.numSpecies();
+    const auto& names = network_.speciesNames();
+    const auto environment = std::find(names.begin(), names.end(), "environment") - names.begin();
+
+    std::unordered_map<std::vector<int>, uint32_t, StateHash> index;
+    std::vector<Transition> transitions;
+
+    auto initial = network_.initialState();
+    if (environment < static_cast<long>(num_species)) {
+        initial[environment] = 0;
+    }
+    index.emplace(initial, 0);
+    states_ = initial;
+    num_states_ = 1;
+
+    std::vector<int> state(num_species), next(num_species);
+
+    // Breadth-first search; `states_` doubles as the queue
+    for (size_t i = 0; i < num_states_; ++i) {
+        std::copy_n(states_.begin() + static_cast<long>(i * num_species), num_species, state.begin());
+        outflow_.push_back(0);
+
+        for (size_t r = 0; r < network_.numReactions(); ++r) {
+            if (!network_.canFire(r, state.data())) {
+                continue;
+            }
+            const double a = network_.propensity(r, state.data());
+            if (a <= 0) {
+                continue;
+            }
+            outflow_[i] += a;
+
+            next = state;
+            network_.fire(r, next.data());
+            if (environment < static_cast<long>(num_species)) {
+                next[environment] = 0;
+            }
+            if (std::any_of(next.begin(), next.end(), [this](int x) { return x > options_.max_amount; })) {
+                continue; // leaves the projection; the outflow above is what makes the lost mass measurable
+            }
+
+            auto [it, inserted] = index.try_emplace(next, static_cast<uint32_t>(num_states_));
+            if (inserted) {
+                if (++num_states_ > options_.max_states) {
+                    throw std::runtime_error("FSP state space exceeds " + std::to_string(options_.max_states) + " states");
+                }
+                states_.insert(states_.end(), next.begin(), next.end());
+            }
+            transitions.push_back({it->second, static_cast<uint32_t>(i), a});
+        }
+    }
+
+    std::sort(transitions.begin(), transitions.end(), [](const Transition& a, const Transition& b) {
+        return a.to < b.to || (a.to == b.to && a.from < b.from);
+    });
+
+    row_offsets_.assign(num_states_ + 1, 0);
+    for (const auto& tr : transitions) {
+        ++row_offsets_[tr.to + 1];
+        columns_.push_back(tr.from);
+        values_.push_back(tr.rate);
+    }
+    std::partial_sum(row_offsets_.begin(), row_offsets_.end(), row_offsets_.begin());
+}
+
+// p(t) = Σ_k Poisson(k; Λt) (I + A/Λ)^k p(0), with Λ bounding every exit rate so that I + A/Λ is (sub)stochastic.
+FspResult FspSolver::solve(double t) const {
+    FspResult result;
+    result.t = t;
+    result.probabilities.assign(num_states_, 0.0);
+
+    std::vector<double> v(num_states_, 0.0), next(num_states_);
+    v[0] = 1.0;
+
+    const double lambda = *std::max_element(outflow_.begin(), outflow_.end());
+    const double q = lambda * t;
+    if (q <= 0) {
+        result.probabilities = v;
+        return result;
+    }
+
+    const auto max_terms = static_cast<size_t>(q + 10 * std::sqrt(q) + 100);
+    double accumulated = 0;
+    for (size_t k = 0; k <= max_terms; ++k) {
+        const double weight = std::exp(-q + k * std::log(q) - std::lgamma(k + 1.0));
+        if (weight > 0) {
+            for (size_t i = 0; i < num_states_; ++i) {
+                result.probabilities[i] += weight * v[i];
+            }
+            accumulated += weight;
+        }
+        if (k > q && 1.0 - accumulated < options_.tolerance) {
+            break;
+        }
+
+        for (size_t i = 0; i < num_states_; ++i) {
+            double y = v[i] * (1.0 - outflow_[i] / lambda);
+            for (size_t e = row_offsets_[i]; e < row_offsets_[i + 1]; ++e) {
+                y += values_[e] / lambda * v[columns_[e]];
+            }
+            next[i] = y;
+        }
+        std::swap(v, next);
+    }
+
+    const double total = std::accumulate(result.probabilities.begin(), result.probabilities.end(), 0.0);
+    result.truncation_error = std::max(0.0, 1.0 - total);
+    return result;
+}
+
+std::vector<double> FspSolver::marginal(const FspResult& result, const std::string& species) const {
+    const auto s = network_.speciesIndex(species);
+    std::vector<double> distribution;
+    for (size_t i = 0; i < num_states_; ++i) {
+        const auto x = static_cast<size_t>(amount(i, s));
+        if (x >= distribution.size()) {
+            distribution.resize(x + 1, 0.0);
+        }
+        distribution[x] += result.probabilities[i];
+    }
+    return distribution;
+}
+
+double FspSolver::mean(const FspResult& result, const std::string& species) const {
+    const auto s = network_.speciesIndex(species);
+    double m = 0;
+    for (size_t i = 0; i < num_states_; ++i) {
+        m += amount(i, s) * result.probabilities[i];
+    }
+    return m;
+}
@@ -0,0 +1,55 @@
+#ifndef FSP_SOLVER_H
+#define FSP_SOLVER_H
+
+#include <string>
+#include <vector>
+
+#include "../compiled_network.h"
+
+struct FspOptions {
+    int max_amount = 1000;          // states with any species above this are cut from the projection
+    size_t max_states = 2'000'000;  // enumeration gives up (throws) beyond this many states
+    double tolerance = 1e-10;       // Poisson tail mass dropped by the uniformization series
+};
+
+struct FspResult {
+    double t = 0;
+    std::vector<double> probabilities;  // one entry per enumerated state
+    double truncation_error = 0;        // probability mass that left the projection by time t
+};
+
+// Finite State Projection (Munsky & Khammash, 2006): enumerates the states reachable from the initial state of a
+// small network, builds the sparse generator of the chemical master equation on them and propagates the exact
+// distribution with uniformization. Mass flowing to states outside the bound is lost, and that loss is the
+// reported truncation error. The `environment` species is only ever produced, so it is left out of the state.
+class FspSolver {
+public:
+    FspSolver(const System& system, FspOptions options = {});
+
+    [[nodiscard]] size_t numStates() const { return num_states_; }
+    [[nodiscard]] const CompiledNetwork& network() const { return network_; }
+
+    // Amount of `species` in enumerated state `i`.
+    [[nodiscard]] int amount(size_t i, size_t species) const { return states_[i * network_.numSpecies() + species]; }
+
+    [[nodiscard]] FspResult solve(double t) const;
+
+    [[nodiscard]] std::vector<double> marginal(const FspResult& result, const std::string& species) const;
+    [[nodiscard]] double mean(const FspResult& result, const std::string& species) const;
+
+private:
+    CompiledNetwork network_;
+    FspOptions options_;
+    size_t num_states_ = 0;
+    std::vector<int> states_;
+
+    // Off-diagonal part of the generator in CSR form by destination state, plus the total outflow of each state
+    std::vector<size_t> row_offsets_;
+    std::vector<uint32_t> columns_;
+    std::vector<double> values_;
+    std::vector<double> outflow_;
+
+    void enumerate();
+};
+
+#endif //FSP_SOLVER_H
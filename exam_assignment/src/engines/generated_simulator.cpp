@@ -0,0 +1,264 @@
+#include "generated_simulator.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+    constexpr const char* ENTRY_POINT = "stochastic_kernel_run";
+
+    uint64_t fnv1a(const std::string& text) {
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : text) {
+            hash = (hash ^ c) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::string read_file(const std::filesystem::path& path) {
+        std::ifstream in(path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+
+    // Refuses anything another user could have planted or could still replace: a symbolic link, an entry of the
+    // wrong type, or one that we do not own or that is group or world writable
+    void require_private(const std::filesystem::path& path, bool directory) {
+        struct stat info{};
+        if (lstat(path.c_str(), &info) != 0) {
+            throw std::runtime_error("Cannot inspect " + path.string() + ": " + std::strerror(errno));
+        }
+        const bool right_type = directory ? S_ISDIR(info.st_mode) : S_ISREG(info.st_mode);
+        if (!right_type || info.st_uid != geteuid() || (info.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+            throw std::runtime_error("Refusing the kernel cache entry " + path.string() + ": it must be a " +
+                                     (directory ? "directory" : "regular file") +
+                                     " owned by the current user and writable only by them");
+        }
+    }
+
+    // Creates the last component with mode 0700 (parents as usual), then checks it whether new or not
+    void make_private_directory(const std::filesystem::path& dir) {
+        if (dir.has_parent_path()) {
+            std::filesystem::create_directories(dir.parent_path());
+        }
+        if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Cannot create " + dir.string() + ": " + std::strerror(errno));
+        }
+        require_private(dir, true);
+    }
+
+    // Runs `args` without a shell, with stderr written to `log_path`, and returns whether it exited with 0
+    bool run_compiler(const std::vector<std::string>& args, const std::string& log_path) {
+        std::vector<char*> argv;
+        for (const auto& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        pid_t pid;
+        const int error = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (error != 0) {
+            std::ofstream(log_path) << "Cannot run " << args[0] << ": " << std::strerror(error) << '\n';
+            return false;
+        }
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+}
+
+std::filesystem::path default_kernel_cache() {
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg == '/') {
+        return std::filesystem::path(xdg) / "stochastic_simulator" / "kernels";
+    }
+    if (const char* home = std::getenv("HOME"); home != nullptr && *home == '/') {
+        return std::filesystem::path(home) / ".cache" / "stochastic_simulator" / "kernels";
+    }
+    return std::filesystem::temp_directory_path() / ("stochastic_simulator_kernels_" + std::to_string(geteuid()));
+}
+
+std::string GeneratedKernel::source(const CompiledNetwork& network) {
+    const size_t R = network.numReactions();
+    std::ostringstream out;
+    // Hex floats keep the rates exact, so the propensities are bit-identical to the interpreted engines
+    out << std::hexfloat;
+
+    out << "// Generated by GeneratedKernel; do not edit.\n";
+    out << "#include <cstddef>\n#include <random>\n\nnamespace {\n";
+
+    for (size_t r = 0; r < R; ++r) {
+        out << "    inline double propensity_" << r << "(const int* x) { return " << network.rate(r) << " * (1.0";
+        for (auto s : network.reactants(r)) {
+            out << " * x[" << s << ']';
+        }
+        out << "); }\n";
+    }
+    out << '\n';
+
+    for (size_t r = 0; r < R; ++r) {
+        out << "    inline bool fire_" << r << "(int* x, double* a) {\n";
+        // Reactants are sorted, so repeated species are adjacent and checked once against their multiplicity
+        auto reactants = network.reactants(r);
+        for (size_t i = 0; i < reactants.size();) {
+            size_t count = 1;
+            while (i + count < reactants.size() && reactants[i + count] == reactants[i]) {
+                ++count;
+            }
+            out << "        if (x[" << reactants[i] << "] < " << count << ") return false;\n";
+            i += count;
+        }
+        auto species = network.changedSpecies(r);
+        auto deltas = network.changeDeltas(r);
+        for (size_t i = 0; i < species.size(); ++i) {
+            out << "        x[" << species[i] << "] += " << deltas[i] << ";\n";
+        }
+        for (auto d : network.dependents(r)) {
+            out << "        a[" << d << "] = propensity_" << d << "(x);\n";
+        }
+        out << "        return true;\n    }\n";
+    }
+
+    out << "}\n\n";
+    out << "extern \"C\" __attribute__((visibility(\"default\")))\n";
+    out << "std::size_t " << ENTRY_POINT << "(int* x, double* a, double end_time, std::mt19937_64* generator,\n";
+    out << "        void (*monitor)(void*, const int*, double), void* context) {\n";
+    for (size_t r = 0; r < R; ++r) {
+        out << "    a[" << r << "] = propensity_" << r << "(x);\n";
+    }
+    out << "    std::uniform_real_distribution<double> uniform(0.0, 1.0);\n";
+    out << "    std::size_t events = 0;\n";
+    out << "    double t = 0;\n";
+    out << "    while (true) {\n";
+    out << "        double a0 = 0;\n";
+    out << "        for (std::size_t j = 0; j < " << R << "; ++j) a0 += a[j];\n";
+    out << "        if (a0 <= 0) break;\n";
+    out << "        t += std::exponential_distribution<double>(a0)(*generator);\n";
+    out << "        if (t > end_time) break;\n";
+    out << "        double target = uniform(*generator) * a0;\n";
+    // Rounding can carry the target past the last propensity; it then falls to the last reaction that can fire
+    out << "        std::size_t j = 0;\n";
+    out << "        for (std::size_t i = 0; i < " << R << "; ++i) {\n";
+    out << "            if (a[i] <= 0) continue;\n";
+    out << "            j = i;\n";
+    out << "            if (target < a[i]) break;\n";
+    out << "            target -= a[i];\n";
+    out << "        }\n";
+    out << "        bool fired = false;\n";
+    out << "        switch (j) {\n";
+    for (size_t r = 0; r < R; ++r) {
+        out << "            case " << r << ": fired = fire_" << r << "(x, a); break;\n";
+    }
+    out << "        }\n";
+    out << "        if (fired) {\n";
+    out << "            ++events;\n";
+    out << "            monitor(context, x, t);\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return events;\n";
+    out << "}\n";
+    return out.str();
+}
+
+GeneratedKernel::GeneratedKernel(const CompiledNetwork& network, CodegenOptions options) : network_(network) {
+    const std::string code = source(network);
+    std::vector<std::string> args{options.compiler};
+    std::istringstream flags(options.flags);
+    for (std::string flag; flags >> flag;) {
+        args.push_back(flag);
+    }
+    args.insert(args.end(), {"-std=c++20", "-shared", "-fPIC"});
+    std::string command_line;
+    for (const auto& arg : args) {
+        command_line += (command_line.empty() ? "" : " ") + arg;
+    }
+
+    std::ostringstream name;
+    name << "kernel_" << std::hex << std::setw(16) << std::setfill('0') << fnv1a(command_line + '\n' + code);
+    make_private_directory(options.cache_dir);
+    library_ = options.cache_dir / (name.str() + ".so");
+
+    cached_ = std::filesystem::exists(library_);
+    if (!cached_) {
+        // Built under a process-specific name and renamed into place, so concurrent builds never load a partial file
+        const auto stem = options.cache_dir / (name.str() + "." + std::to_string(getpid()));
+        const auto source_path = stem.string() + ".cpp", library_path = stem.string() + ".so",
+                   log_path = stem.string() + ".log";
+        std::ofstream(source_path) << code;
+
+        args.insert(args.end(), {"-o", library_path, source_path});
+        if (!run_compiler(args, log_path)) {
+            const std::string log = read_file(log_path);
+            std::filesystem::remove(source_path);
+            std::filesystem::remove(log_path);
+            throw std::runtime_error("Compiling the generated kernel failed (" + command_line + "):\n" + log);
+        }
+        // The linker honours the umask, which may leave the library group writable and so refused below
+        using std::filesystem::perms;
+        std::filesystem::permissions(library_path, perms::group_write | perms::others_write,
+                                     std::filesystem::perm_options::remove);
+        std::filesystem::rename(library_path, library_);
+        std::filesystem::remove(source_path);
+        std::filesystem::remove(log_path);
+    }
+    require_private(library_, false);
+
+    handle_ = dlopen(library_.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle_ == nullptr) {
+        throw std::runtime_error("Loading the generated kernel failed: " + std::string(dlerror()));
+    }
+    entry_ = reinterpret_cast<Entry>(dlsym(handle_, ENTRY_POINT));
+    if (entry_ == nullptr) {
+        dlclose(handle_);
+        throw std::runtime_error("Generated kernel " + library_.string() + " has no entry point");
+    }
+}
+
+GeneratedKernel::~GeneratedKernel() {
+    if (handle_ != nullptr) {
+        dlclose(handle_);
+    }
+}
+
+GeneratedSimulator::GeneratedSimulator(const GeneratedKernel& kernel, double end_time, unsigned seed)
+        : kernel_(kernel), end_time_(end_time), generator_(seed), propensities_(kernel.network().numReactions()) {
+    kernel.network().requireNoScheduledEvents("The generated kernel");
+}
+
+void GeneratedSimulator::simulate(StateMonitor& monitor) {
+    const auto& network = kernel_.network();
+    auto state = network.initialState();
+
+    struct Context {
+        const CompiledNetwork& network;
+        StateMonitor& monitor;
+    } context{network, monitor};
+    auto forward = [](void* context, const int* state, double t) {
+        auto& c = *static_cast<Context*>(context);
+        c.monitor(c.network, std::span<const int>(state, c.network.numSpecies()), t);
+    };
+
+    events_ = kernel_.run(state.data(), propensities_.data(), end_time_, generator_, forward, &context);
+}
@@ -0,0 +1,87 @@
+#ifndef GENERATED_SIMULATOR_H
+#define GENERATED_SIMULATOR_H
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../compiled_network.h"
+#include "../monitor/monitor.h"
+
+// Per-user kernel cache: `$XDG_CACHE_HOME/stochastic_simulator/kernels`, `~/.cache/...` without it, or
+// `<temp>/stochastic_simulator_kernels_<uid>` when neither is set
+std::filesystem::path default_kernel_cache();
+
+struct CodegenOptions {
+    std::string compiler = "c++";              // run directly, not through a shell
+    std::string flags = "-O2 -march=native";   // split on whitespace into separate arguments
+    // Compiled kernels are kept here as `kernel_<hash>.so`, so a network is only compiled once per user. The
+    // directory is created with mode 0700; one (or a cached library in it) that belongs to another user or is group
+    // or world writable is refused instead of loaded.
+    std::filesystem::path cache_dir = default_kernel_cache();
+};
+
+// Runtime counterpart of `static_network::Kernel` for networks that are only known at run time. The network is
+// written out as a C++ translation unit with the species indices, rates, reactant checks, state changes and
+// dependency lists hard-coded into one firing routine per reaction, compiled with the system compiler into a
+// shared library and loaded with `dlopen`. The library is cached on disk under a hash of the generated source and
+// the compiler command, so later runs (and other processes) with the same network skip the compiler.
+//
+// The generated loop is the direct method and draws its random numbers in the same order as the other direct
+// method implementations, so the trajectories match theirs for the same seed.
+class GeneratedKernel {
+public:
+    explicit GeneratedKernel(const CompiledNetwork& network, CodegenOptions options = {});
+    ~GeneratedKernel();
+
+    GeneratedKernel(const GeneratedKernel&) = delete;
+    GeneratedKernel& operator=(const GeneratedKernel&) = delete;
+
+    // The translation unit for `network`; also what the cache key is computed from
+    static std::string source(const CompiledNetwork& network);
+
+    [[nodiscard]] const CompiledNetwork& network() const { return network_; }
+    [[nodiscard]] const std::filesystem::path& library() const { return library_; }
+    // Whether the library was found in the cache instead of being compiled by this instance
+    [[nodiscard]] bool cached() const { return cached_; }
+
+    using Callback = void (*)(void* context, const int* state, double t);
+    using Entry = size_t (*)(int* state, double* propensities, double end_time, std::mt19937_64* generator,
+                             Callback monitor, void* context);
+
+    // Runs the direct method on `state` in place until `end_time` and returns the number of events. `propensities`
+    // is working storage for one value per reaction, kept off the stack since networks loaded from files can have
+    // millions of reactions.
+    size_t run(int* state, double* propensities, double end_time, std::mt19937_64& generator, Callback monitor,
+               void* context) const {
+        return entry_(state, propensities, end_time, &generator, monitor, context);
+    }
+
+private:
+    const CompiledNetwork& network_;
+    std::filesystem::path library_;
+    bool cached_ = false;
+    void* handle_ = nullptr;
+    Entry entry_ = nullptr;
+};
+
+// Engine interface over a loaded kernel. One kernel can be shared by any number of simulators and threads.
+// Scheduled rate changes and injections are not supported, since the rates are compiled in.
+class GeneratedSimulator {
+public:
+    GeneratedSimulator(const GeneratedKernel& kernel, double end_time, unsigned seed);
+
+    void simulate(StateMonitor& monitor);
+
+    [[nodiscard]] size_t events() const { return events_; }
+
+private:
+    const GeneratedKernel& kernel_;
+    double end_time_;
+    std::mt19937_64 generator_;
+    std::vector<double> propensities_;
+    size_t events_ = 0;
+};
+
+#endif //GENERATED_SIMULATOR_H
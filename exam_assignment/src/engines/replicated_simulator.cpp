@@ -0,0 +1,182 @@
+#include "replicated_simulator.h"
+
+#include <algorithm>
+#include <limits>
+
+ReplicatedSimulator::ReplicatedSimulator(const ReplicatedNetwork& model, double end_time, unsigned seed)
+        : model_(model), cell_(model.cell()), end_time_(end_time), num_species_(model.cell().numSpecies()),
+          num_reactions_(model.cell().numReactions()), num_instances_(model.numInstances()), generator_(seed),
+          scratch_(model.cell().numReactions()), tree_(model.numInstances() + model.couplings().size()) {
+    for (size_t r = 0; r < num_reactions_; ++r) {
+        rates_.push_back(cell_.rate(r));
+    }
+
+    // Couplings per instance they read, in CSR form
+    const auto& couplings = model.couplings();
+    std::vector<std::vector<uint32_t>> readers(num_instances_);
+    for (uint32_t c = 0; c < couplings.size(); ++c) {
+        for (const auto& site : couplings[c].reactants) {
+            if (readers[site.instance].empty() || readers[site.instance].back() != c) {
+                readers[site.instance].push_back(c);
+            }
+        }
+    }
+    reader_offsets_.push_back(0);
+    for (const auto& cs : readers) {
+        reader_couplings_.insert(reader_couplings_.end(), cs.begin(), cs.end());
+        reader_offsets_.push_back(static_cast<uint32_t>(reader_couplings_.size()));
+    }
+}
+
+double ReplicatedSimulator::couplingPropensity(size_t c) const {
+    const auto& coupling = model_.couplings()[c];
+    double a = coupling.rate;
+    for (const auto& site : coupling.reactants) {
+        a *= state_[site.instance * num_species_ + site.species];
+    }
+    return a;
+}
+
+double ReplicatedSimulator::refresh(size_t k) {
+    const int* x = state_.data() + k * num_species_;
+    double sum = 0;
+    for (size_t r = 0; r < num_reactions_; ++r) {
+        scratch_[r] = rates_[r] * cell_.massAction(r, x);
+        sum += scratch_[r];
+    }
+    tree_.update(k, sum);
+
+    for (auto i = reader_offsets_[k]; i < reader_offsets_[k + 1]; ++i) {
+        const auto c = reader_couplings_[i];
+        tree_.update(num_instances_ + c, couplingPropensity(c));
+    }
+    return sum;
+}
+
+void ReplicatedSimulator::fireInstance(size_t k, double target) {
+    const double sum = refresh(k);
+    target = std::min(target, std::nextafter(sum, 0.0));
+
+    // Rounding can carry the target past the last propensity; it then falls to the last reaction that can fire,
+    // never to one with propensity 0
+    size_t r = num_reactions_;
+    for (size_t i = 0; i < num_reactions_; ++i) {
+        if (scratch_[i] <= 0) {
+            continue;
+        }
+        r = i;
+        if (target < scratch_[i]) {
+            break;
+        }
+        target -= scratch_[i];
+    }
+
+    int* x = state_.data() + k * num_species_;
+    if (r == num_reactions_ || !cell_.canFire(r, x)) {
+        return;
+    }
+    const auto species = cell_.changedSpecies(r);
+    const auto deltas = cell_.changeDeltas(r);
+    for (size_t i = 0; i < species.size(); ++i) {
+        x[species[i]] += deltas[i];
+        totals_[species[i]] += deltas[i];
+    }
+    refresh(k);
+    ++events_;
+}
+
+void ReplicatedSimulator::fireCoupling(size_t c) {
+    const auto& coupling = model_.couplings()[c];
+    auto amount = [this](const ReplicatedNetwork::Site& site) -> int& {
+        return state_[site.instance * num_species_ + site.species];
+    };
+
+    for (const auto& site : coupling.reactants) {
+        --amount(site);
+    }
+    // Repeated reactant sites can ask for more than there is
+    if (std::any_of(coupling.reactants.begin(), coupling.reactants.end(), [&amount](const auto& site) { return amount(site) < 0; })) {
+        for (const auto& site : coupling.reactants) {
+            ++amount(site);
+        }
+        return;
+    }
+    for (const auto& site : coupling.products) {
+        ++amount(site);
+    }
+
+    for (const auto& site : coupling.reactants) {
+        --totals_[site.species];
+    }
+    for (const auto& site : coupling.products) {
+        ++totals_[site.species];
+    }
+    for (const auto& site : coupling.reactants) {
+        refresh(site.instance);
+    }
+    for (const auto& site : coupling.products) {
+        refresh(site.instance);
+    }
+    ++coupling_events_;
+}
+
+void ReplicatedSimulator::applyScheduledEvent(const CompiledNetwork::ScheduledEvent& event) {
+    if (!event.injection) {
+        rates_[event.target] = event.value;
+    } else {
+        for (size_t k = 0; k < num_instances_; ++k) {
+            int& x = state_[k * num_species_ + event.target];
+            const int before = x;
+            x = std::max(0, x + static_cast<int>(event.value));
+            totals_[event.target] += x - before;
+        }
+    }
+    for (size_t k = 0; k < num_instances_; ++k) {
+        refresh(k);
+    }
+}
+
+void ReplicatedSimulator::simulate(StateMonitor& monitor) {
+    state_ = model_.initialState();
+    totals_.assign(num_species_, 0);
+    for (size_t k = 0; k < num_instances_; ++k) {
+        for (size_t s = 0; s < num_species_; ++s) {
+            totals_[s] += state_[k * num_species_ + s];
+        }
+        refresh(k);
+    }
+
+    const auto& events = cell_.scheduledEvents();
+    size_t next_event = 0;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    double t = 0;
+    while (t <= end_time_) {
+        const double next_event_time = next_event < events.size()
+                ? events[next_event].time
+                : std::numeric_limits<double>::infinity();
+        const double a0 = tree_.total();
+        const double dt = a0 > 0
+                ? std::exponential_distribution<double>(a0)(generator_)
+                : std::numeric_limits<double>::infinity();
+
+        if (t + dt >= next_event_time && next_event_time <= end_time_) {
+            t = next_event_time;
+            applyScheduledEvent(events[next_event++]);
+            monitor(cell_, totals_, t);
+            continue;
+        }
+        if (t + dt > end_time_) {
+            break;
+        }
+
+        t += dt;
+        const auto [leaf, offset] = tree_.find(uniform(generator_) * a0);
+        if (leaf < num_instances_) {
+            fireInstance(leaf, offset);
+        } else {
+            fireCoupling(leaf - num_instances_);
+        }
+        monitor(cell_, totals_, t);
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef REPLICATED_SIMULATOR_H
+#define REPLICATED_SIMULATOR_H
+
+#include <random>
+#include <span>
+#include <vector>
+
+#include "../replicated_network.h"
+#include "../sum_tree.h"
+#include "../monitor/monitor.h"
+
+// Hierarchical direct method for a `ReplicatedNetwork`. A `SumTree` over the instance totals and the coupling
+// propensities picks an instance (or a coupling) in O(log(K + C)); inside the instance the template propensities
+// are recomputed into one template-sized buffer and scanned. Only the K totals are stored, never K copies of the
+// propensity vector, so both memory and per-event cost scale with the template rather than K x template.
+// Rate breakpoints and injections of the template apply to every instance.
+class ReplicatedSimulator {
+public:
+    ReplicatedSimulator(const ReplicatedNetwork& model, double end_time, unsigned seed);
+
+    // The monitor sees the template network and the species totals over all instances after every event
+    void simulate(StateMonitor& monitor);
+
+    // Instance-major amounts after `simulate`
+    [[nodiscard]] const std::vector<int>& state() const { return state_; }
+    [[nodiscard]] std::span<const int> instance(size_t k) const {
+        return {state_.data() + k * num_species_, num_species_};
+    }
+    [[nodiscard]] size_t events() const { return events_; }
+    [[nodiscard]] size_t couplingEvents() const { return coupling_events_; }
+
+private:
+    const ReplicatedNetwork& model_;
+    const CompiledNetwork& cell_;
+    double end_time_;
+    size_t num_species_, num_reactions_, num_instances_;
+    std::mt19937_64 generator_;
+
+    std::vector<double> rates_;
+    std::vector<int> state_, totals_;
+    std::vector<double> scratch_;  // propensities of the instance being fired
+    SumTree tree_;                 // leaves: instances, then couplings
+    std::vector<uint32_t> reader_offsets_, reader_couplings_;  // per instance, the couplings that read it
+    size_t events_ = 0, coupling_events_ = 0;
+
+    // Recomputes the instance's propensities into `scratch_` and its leaf, and the couplings that read it
+    double refresh(size_t k);
+    [[nodiscard]] double couplingPropensity(size_t c) const;
+    void fireInstance(size_t k, double target);
+    void fireCoupling(size_t c);
+    void applyScheduledEvent(const CompiledNetwork::ScheduledEvent& event);
+};
+
+#endif //REPLICATED_SIMULATOR_H
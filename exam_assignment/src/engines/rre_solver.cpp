@@ -0,0 +1,155 @@
+#include "rre_solver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    // Dormand-Prince 5(4) tableau
+    constexpr double c2 = 1.0 / 5, c3 = 3.0 / 10, c4 = 4.0 / 5, c5 = 8.0 / 9;
+    constexpr double a21 = 1.0 / 5;
+    constexpr double a31 = 3.0 / 40, a32 = 9.0 / 40;
+    constexpr double a41 = 44.0 / 45, a42 = -56.0 / 15, a43 = 32.0 / 9;
+    constexpr double a51 = 19372.0 / 6561, a52 = -25360.0 / 2187, a53 = 64448.0 / 6561, a54 = -212.0 / 729;
+    constexpr double a61 = 9017.0 / 3168, a62 = -355.0 / 33, a63 = 46732.0 / 5247, a64 = 49.0 / 176, a65 = -5103.0 / 18656;
+    constexpr double b1 = 35.0 / 384, b3 = 500.0 / 1113, b4 = 125.0 / 192, b5 = -2187.0 / 6784, b6 = 11.0 / 84;
+    // Difference between the 5th and the embedded 4th order weights
+    constexpr double e1 = 71.0 / 57600, e3 = -71.0 / 16695, e4 = 71.0 / 1920, e5 = -17253.0 / 339200, e6 = 22.0 / 525, e7 = -1.0 / 40;
+}
+
+std::vector<double> RreTrajectory::of(const std::string& name) const {
+    const auto it = std::find(species.begin(), species.end(), name);
+    if (it == species.end()) {
+        throw std::runtime_error("Species '" + name + "' does not exist");
+    }
+    const auto s = static_cast<size_t>(it - species.begin());
+
+    std::vector<double> values;
+    for (size_t i = 0; i < times.size(); ++i) {
+        values.push_back(states[i * species.size() + s]);
+    }
+    return values;
+}
+
+double RreTrajectory::peak(const std::string& name) const {
+    const auto values = of(name);
+    return values.empty() ? 0.0 : *std::max_element(values.begin(), values.end());
+}
+
+RreSolver::RreSolver(const System& system, RreOptions options) : network_(system), options_(options) {
+    network_.requireNoScheduledEvents("The RRE solver");
+}
+
+void RreSolver::derivative(const double* x, double* dx, double* propensities) const {
+    const auto num_reactions = network_.numReactions();
+    const auto num_species = network_.numSpecies();
+
+    for (size_t r = 0; r < num_reactions; ++r) {
+        double a = network_.rate(r);
+        for (auto s : network_.reactants(r)) {
+            a *= x[s];
+        }
+        propensities[r] = a;
+    }
+
+    std::fill(dx, dx + num_species, 0.0);
+    for (size_t r = 0; r < num_reactions; ++r) {
+        const auto species = network_.changedSpecies(r);
+        const auto deltas = network_.changeDeltas(r);
+        for (size_t i = 0; i < species.size(); ++i) {
+            dx[species[i]] += deltas[i] * propensities[r];
+        }
+    }
+}
+
+RreTrajectory RreSolver::solve(double end_time, double output_step) const {
+    // Checked up front: a NaN end time never ends the loop, and a step that is not positive never reaches an output
+    if (!std::isfinite(end_time)) {
+        throw std::invalid_argument("RRE solver end time must be finite");
+    }
+    if (!(output_step > 0)) {
+        throw std::invalid_argument("RRE solver output step must be positive");
+    }
+
+    const auto n = network_.numSpecies();
+
+    RreTrajectory trajectory;
+    trajectory.species = network_.speciesNames();
+
+    std::vector<double> x(network_.initialState().begin(), network_.initialState().end());
+    std::vector<double> next(n), error(n), stage(n), propensities(network_.numReactions());
+    std::vector<double> k1(n), k2(n), k3(n), k4(n), k5(n), k6(n), k7(n);
+
+    auto record = [&](double t) {
+        trajectory.times.push_back(t);
+        trajectory.states.insert(trajectory.states.end(), x.begin(), x.end());
+    };
+
+    double t = 0;
+    double h = options_.initial_step;
+    double next_output = output_step;
+    record(t);
+    derivative(x.data(), k1.data(), propensities.data());
+
+    while (t < end_time) {
+        if (trajectory.accepted_steps + trajectory.rejected_steps >= options_.max_steps) {
+            throw std::runtime_error("RRE solver exceeded the maximum number of steps");
+        }
+
+        // Land exactly on output times so no interpolation is needed
+        const double step = std::min({h, options_.max_step, next_output - t, end_time - t});
+
+        auto combine = [&](std::initializer_list<std::pair<double, const std::vector<double>*>> terms) {
+            for (size_t i = 0; i < n; ++i) {
+                double sum = 0;
+                for (const auto& [coefficient, k] : terms) {
+                    sum += coefficient * (*k)[i];
+                }
+                stage[i] = x[i] + step * sum;
+            }
+        };
+
+        combine({{a21, &k1}});
+        derivative(stage.data(), k2.data(), propensities.data());
+        combine({{a31, &k1}, {a32, &k2}});
+        derivative(stage.data(), k3.data(), propensities.data());
+        combine({{a41, &k1}, {a42, &k2}, {a43, &k3}});
+        derivative(stage.data(), k4.data(), propensities.data());
+        combine({{a51, &k1}, {a52, &k2}, {a53, &k3}, {a54, &k4}});
+        derivative(stage.data(), k5.data(), propensities.data());
+        combine({{a61, &k1}, {a62, &k2}, {a63, &k3}, {a64, &k4}, {a65, &k5}});
+        derivative(stage.data(), k6.data(), propensities.data());
+        combine({{b1, &k1}, {b3, &k3}, {b4, &k4}, {b5, &k5}, {b6, &k6}});
+        next = stage;
+        derivative(next.data(), k7.data(), propensities.data());
+
+        double err = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const double e = step * (e1 * k1[i] + e3 * k3[i] + e4 * k4[i] + e5 * k5[i] + e6 * k6[i] + e7 * k7[i]);
+            const double scale = options_.absolute_tolerance + options_.relative_tolerance * std::max(std::abs(x[i]), std::abs(next[i]));
+            err += (e / scale) * (e / scale);
+        }
+        err = std::sqrt(err / static_cast<double>(n));
+
+        const double factor = std::clamp(0.9 * std::pow(std::max(err, 1e-10), -0.2), 0.2, 5.0);
+        if (err > 1.0) {
+            ++trajectory.rejected_steps;
+            h = step * factor;
+            continue;
+        }
+
+        ++trajectory.accepted_steps;
+        t += step;
+        std::swap(x, next);
+        std::swap(k1, k7);  // first-same-as-last: f(x_new) is the next step's first stage
+        // Do not let a step shortened by an output time shrink the next one
+        h = std::max(h, step) * factor;
+
+        if (t >= next_output - 1e-12 * std::max(1.0, next_output) || t >= end_time) {
+            record(t);
+            next_output += output_step;
+        }
+    }
+
+    return trajectory;
+}
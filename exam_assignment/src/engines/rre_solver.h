@@ -0,0 +1,47 @@
+#ifndef RRE_SOLVER_H
+#define RRE_SOLVER_H
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../compiled_network.h"
+
+struct RreOptions {
+    double relative_tolerance = 1e-6;
+    double absolute_tolerance = 1e-6;
+    double initial_step = 1e-3;
+    double max_step = std::numeric_limits<double>::infinity();
+    size_t max_steps = 10'000'000;
+};
+
+// Deterministic trajectory sampled at fixed output times; `states` holds one row of species amounts per time.
+struct RreTrajectory {
+    std::vector<std::string> species;
+    std::vector<double> times;
+    std::vector<double> states;
+    size_t accepted_steps = 0, rejected_steps = 0;
+
+    [[nodiscard]] std::vector<double> of(const std::string& name) const;
+    [[nodiscard]] double peak(const std::string& name) const;
+};
+
+// Reaction rate equations (the mean-field ODE) of a `System`: dx/dt = Σ_k ν_k a_k(x), with the same mass-action
+// propensities as the stochastic engines but on continuous amounts. Integrated with the adaptive Dormand-Prince
+// 5(4) pair, the embedded big brother of the fixed-step RK4 in lecture12/src.
+class RreSolver {
+public:
+    explicit RreSolver(const System& system, RreOptions options = {});
+
+    // Throws std::invalid_argument unless `end_time` is finite and `output_step` positive
+    [[nodiscard]] RreTrajectory solve(double end_time, double output_step) const;
+
+    // dx/dt at `x`; `propensities` is scratch space of numReactions() entries.
+    void derivative(const double* x, double* dx, double* propensities) const;
+
+private:
+    CompiledNetwork network_;
+    RreOptions options_;
+};
+
+#endif //RRE_SOLVER_H
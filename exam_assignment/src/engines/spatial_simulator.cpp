@@ -0,0 +1,217 @@
+#include "spatial_simulator.h"
+
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <numeric>
+
+Metapopulation::Metapopulation(const System& local, size_t num_regions) : local_(local), num_regions_(num_regions) {
+    for (size_t i = 0; i < num_regions; ++i) {
+        initial_.insert(initial_.end(), local_.initialState().begin(), local_.initialState().end());
+    }
+}
+
+void Metapopulation::setAmount(size_t region, const std::string& species, int amount) {
+    initial_.at(region * local_.numSpecies() + local_.speciesIndex(species)) = amount;
+}
+
+void Metapopulation::addMigration(size_t from, size_t to, const std::string& species, double rate) {
+    if (from >= num_regions_ || to >= num_regions_) {
+        throw std::runtime_error("Region does not exist");
+    }
+    migrations_.push_back({static_cast<uint32_t>(from), static_cast<uint32_t>(to),
+                           static_cast<uint32_t>(local_.speciesIndex(species)), rate});
+}
+
+SpatialSimulator::SpatialSimulator(const Metapopulation& model, double end_time, unsigned seed,
+                                   size_t num_threads, double sync_window)
+        : model_(model), local_(model.local()), end_time_(end_time),
+          num_species_(model.local().numSpecies()), num_reactions_(model.local().numReactions()),
+          sync_window_(sync_window), thread_pool_(num_threads) {
+    local_.requireNoScheduledEvents("The spatial engine");
+    const auto num_regions = model.numRegions();
+    const auto stride = num_reactions_ + num_species_;
+    propensities_.assign(num_regions * stride, 0.0);
+    totals_.assign(num_regions, 0.0);
+
+    // Migration edges grouped by (region, species) in CSR form
+    auto migrations = model.migrations();
+    std::sort(migrations.begin(), migrations.end(), [this](const auto& a, const auto& b) {
+        return a.from * num_species_ + a.species < b.from * num_species_ + b.species;
+    });
+    migration_rate_.assign(num_regions * num_species_, 0.0);
+    edge_offsets_.assign(num_regions * num_species_ + 1, 0);
+    for (const auto& m : migrations) {
+        const auto key = m.from * num_species_ + m.species;
+        migration_rate_[key] += m.rate;
+        ++edge_offsets_[key + 1];
+        edge_targets_.push_back(m.to);
+        edge_rates_.push_back(m.rate);
+    }
+    std::partial_sum(edge_offsets_.begin(), edge_offsets_.end(), edge_offsets_.begin());
+
+    const size_t num_partitions = std::max<size_t>(1, std::min(num_threads, num_regions));
+    partition_of_.resize(num_regions);
+    for (size_t p = 0; p < num_partitions; ++p) {
+        const auto first = static_cast<uint32_t>(p * num_regions / num_partitions);
+        const auto last = static_cast<uint32_t>((p + 1) * num_regions / num_partitions);
+        std::seed_seq seq{seed, static_cast<unsigned>(p)};
+        partitions_.push_back({first, last - first, IndexedPriorityQueue(last - first), std::mt19937_64(seq),
+                               std::vector<std::vector<Message>>(num_partitions)});
+        std::fill(partition_of_.begin() + first, partition_of_.begin() + last, static_cast<uint32_t>(p));
+    }
+}
+
+size_t SpatialSimulator::events() const {
+    size_t events = 0;
+    for (const auto& p : partitions_) {
+        events += p.events;
+    }
+    return events;
+}
+
+void SpatialSimulator::refreshRegion(size_t region) {
+    const int* x = &state_[region * num_species_];
+    double* a = &propensities_[region * (num_reactions_ + num_species_)];
+    double total = 0;
+
+    for (size_t r = 0; r < num_reactions_; ++r) {
+        a[r] = local_.propensity(r, x);
+        total += a[r];
+    }
+    for (size_t s = 0; s < num_species_; ++s) {
+        a[num_reactions_ + s] = migration_rate_[region * num_species_ + s] * x[s];
+        total += a[num_reactions_ + s];
+    }
+    totals_[region] = total;
+}
+
+void SpatialSimulator::schedule(Partition& partition, size_t region, double t) {
+    const double total = totals_[region];
+    const double next = total > 0
+            ? t + std::exponential_distribution<double>(total)(partition.generator)
+            : std::numeric_limits<double>::infinity();
+    partition.queue.update(region - partition.first_region, next);
+}
+
+void SpatialSimulator::fireIn(Partition& partition, size_t region, double t, StateMonitor* monitor) {
+    const auto stride = num_reactions_ + num_species_;
+    const double* a = &propensities_[region * stride];
+    int* x = &state_[region * num_species_];
+
+    // Rounding can carry the target past the last propensity; it then falls to the last index that can fire, never
+    // to one with propensity 0 (e.g. the migration of a species that is absent or has no edges)
+    double target = std::uniform_real_distribution<double>(0.0, totals_[region])(partition.generator);
+    size_t k = stride;
+    for (size_t i = 0; i < stride; ++i) {
+        if (a[i] <= 0) {
+            continue;
+        }
+        k = i;
+        if (target < a[i]) {
+            break;
+        }
+        target -= a[i];
+    }
+
+    if (k == stride) {
+        // The total was rounding noise over all-zero propensities: nothing can happen here
+        refreshRegion(region);
+        schedule(partition, region, t);
+        return;
+    }
+
+    if (k < num_reactions_) {
+        if (local_.canFire(k, x)) {
+            local_.fire(k, x);
+            if (monitor) {
+                local_.fire(k, global_.data());
+                (*monitor)(local_, global_, t);
+            }
+        }
+    } else {
+        const auto s = k - num_reactions_;
+        const auto key = region * num_species_ + s;
+        double pick = std::uniform_real_distribution<double>(0.0, migration_rate_[key])(partition.generator);
+        auto e = edge_offsets_[key];
+        for (; e + 1 < edge_offsets_[key + 1] && pick >= edge_rates_[e]; ++e) {
+            pick -= edge_rates_[e];
+        }
+
+        const auto destination = edge_targets_[e];
+        --x[s];
+        if (partition_of_[destination] == partition_of_[region]) {
+            ++state_[destination * num_species_ + s];
+            refreshRegion(destination);
+            schedule(partition, destination, t);
+        } else {
+            partition.outbox[partition_of_[destination]].push_back({destination, static_cast<uint32_t>(s)});
+        }
+    }
+
+    refreshRegion(region);
+    schedule(partition, region, t);
+    ++partition.events;
+}
+
+void SpatialSimulator::advance(Partition& partition, double until, StateMonitor* monitor) {
+    while (partition.queue.topKey() <= until) {
+        const double t = partition.queue.topKey();
+        fireIn(partition, partition.first_region + partition.queue.top(), t, monitor);
+    }
+}
+
+void SpatialSimulator::deliver(double t) {
+    for (auto& source : partitions_) {
+        for (size_t q = 0; q < partitions_.size(); ++q) {
+            for (const auto& message : source.outbox[q]) {
+                ++state_[message.region * num_species_ + message.species];
+                refreshRegion(message.region);
+                schedule(partitions_[q], message.region, t);
+            }
+            source.outbox[q].clear();
+        }
+    }
+}
+
+void SpatialSimulator::simulate(StateMonitor& monitor) {
+    state_ = model_.initialState();
+    global_.assign(num_species_, 0);
+    for (size_t region = 0; region < model_.numRegions(); ++region) {
+        for (size_t s = 0; s < num_species_; ++s) {
+            global_[s] += state_[region * num_species_ + s];
+        }
+        refreshRegion(region);
+    }
+    for (auto& partition : partitions_) {
+        for (size_t region = partition.first_region; region < partition.first_region + partition.num_regions; ++region) {
+            schedule(partition, region, 0.0);
+        }
+    }
+
+    if (partitions_.size() == 1) {
+        advance(partitions_.front(), end_time_, &monitor);
+        return;
+    }
+
+    for (double t = 0; t < end_time_;) {
+        const double until = std::min(t + sync_window_, end_time_);
+
+        std::vector<std::future<void>> futures;
+        for (auto& partition : partitions_) {
+            futures.emplace_back(thread_pool_.enqueue([this, &partition, until] { advance(partition, until, nullptr); }));
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+
+        deliver(until);
+        t = until;
+
+        std::fill(global_.begin(), global_.end(), 0);
+        for (size_t i = 0; i < state_.size(); ++i) {
+            global_[i % num_species_] += state_[i];
+        }
+        monitor(local_, global_, t);
+    }
+}
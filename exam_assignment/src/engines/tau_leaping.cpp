@@ -0,0 +1,154 @@
+#include "tau_leaping.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+TauLeapSimulator::TauLeapSimulator(const CompiledNetwork& network, double end_time, double tau, unsigned seed)
+        : network_(network), end_time_(end_time), tau_(tau), generator_(seed),
+          propensities_(network.numReactions()), other_propensities_(network.numReactions()) {
+    network.requireNoScheduledEvents("Tau-leaping");
+}
+
+int64_t TauLeapSimulator::poisson(double mean) {
+    if (mean <= 0) {
+        return 0;
+    }
+    std::poisson_distribution<int64_t> distribution(mean);
+    return distribution(generator_);
+}
+
+void TauLeapSimulator::computePropensities(const CompiledNetwork::State& state, std::vector<double>& out) const {
+    for (size_t r = 0; r < network_.numReactions(); ++r) {
+        out[r] = network_.propensity(r, state.data());
+    }
+}
+
+void TauLeapSimulator::clampNegative(size_t r, CompiledNetwork::State& state) const {
+    for (auto s : network_.changedSpecies(r)) {
+        state[s] = std::max(state[s], 0);
+    }
+}
+
+void TauLeapSimulator::simulate(StateMonitor& monitor) {
+    auto state = network_.initialState();
+    const auto num_reactions = network_.numReactions();
+
+    for (double t = 0; t < end_time_;) {
+        const double h = std::min(tau_, end_time_ - t);
+        computePropensities(state, propensities_);
+
+        for (size_t r = 0; r < num_reactions; ++r) {
+            if (auto k = poisson(propensities_[r] * h); k > 0) {
+                network_.fire(r, state.data(), k);
+                clampNegative(r, state);
+            }
+        }
+
+        t += h;
+        monitor(network_, state, t);
+    }
+}
+
+void TauLeapSimulator::simulateCoupled(size_t refinement, StateMonitor& fine, StateMonitor& coarse) {
+    auto fine_state = network_.initialState();
+    auto coarse_state = network_.initialState();
+    auto& fine_a = propensities_;
+    auto& coarse_a = other_propensities_;
+    const auto num_reactions = network_.numReactions();
+
+    size_t step = 0;
+    for (double t = 0; t < end_time_; ++step) {
+        const double h = std::min(tau_, end_time_ - t);
+
+        // Coarse propensities stay frozen over a whole coarse step
+        if (step % refinement == 0) {
+            computePropensities(coarse_state, coarse_a);
+        }
+        computePropensities(fine_state, fine_a);
+
+        for (size_t r = 0; r < num_reactions; ++r) {
+            const double shared = std::min(fine_a[r], coarse_a[r]);
+            const auto common = poisson(shared * h);
+            const auto fine_only = poisson((fine_a[r] - shared) * h);
+            const auto coarse_only = poisson((coarse_a[r] - shared) * h);
+
+            if (common + fine_only > 0) {
+                network_.fire(r, fine_state.data(), common + fine_only);
+                clampNegative(r, fine_state);
+            }
+            if (common + coarse_only > 0) {
+                network_.fire(r, coarse_state.data(), common + coarse_only);
+                clampNegative(r, coarse_state);
+            }
+        }
+
+        t += h;
+        fine(network_, fine_state, t);
+        if ((step + 1) % refinement == 0 || t >= end_time_) {
+            coarse(network_, coarse_state, t);
+        }
+    }
+}
+
+void TauLeapSimulator::simulateCoupledExact(StateMonitor& exact, StateMonitor& leap) {
+    auto exact_state = network_.initialState();
+    auto leap_state = network_.initialState();
+    auto& exact_a = propensities_;
+    auto& leap_a = other_propensities_;
+    const auto num_reactions = network_.numReactions();
+
+    computePropensities(exact_state, exact_a);
+    computePropensities(leap_state, leap_a);
+
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    double t = 0;
+    double next_grid = std::min(tau_, end_time_);
+
+    while (t < end_time_) {
+        // Channel j carries rate max(a_j, b_j): min(a_j, b_j) moves both paths, the excess moves only one of them
+        double total = 0;
+        for (size_t r = 0; r < num_reactions; ++r) {
+            total += std::max(exact_a[r], leap_a[r]);
+        }
+
+        const double dt = total > 0
+                ? std::exponential_distribution<double>(total)(generator_)
+                : std::numeric_limits<double>::infinity();
+
+        if (t + dt >= next_grid) {
+            // By memorylessness we may discard the pending event and restart the clocks at the grid point
+            t = next_grid;
+            leap(network_, leap_state, t);
+            computePropensities(leap_state, leap_a);
+            next_grid = std::min(next_grid + tau_, end_time_);
+            continue;
+        }
+        t += dt;
+
+        double target = uniform(generator_) * total;
+        size_t r = 0;
+        for (; r + 1 < num_reactions; ++r) {
+            const double channel = std::max(exact_a[r], leap_a[r]);
+            if (target < channel) {
+                break;
+            }
+            target -= channel;
+        }
+
+        const bool moves_exact = target < exact_a[r];
+        const bool moves_leap = target < leap_a[r];
+
+        if (moves_leap) {
+            network_.fire(r, leap_state.data());
+            clampNegative(r, leap_state);
+        }
+        if (moves_exact && network_.canFire(r, exact_state.data())) {
+            network_.fire(r, exact_state.data());
+            for (auto d : network_.dependents(r)) {
+                exact_a[d] = network_.propensity(d, exact_state.data());
+            }
+            exact(network_, exact_state, t);
+        }
+    }
+}
@@ -0,0 +1,497 @@
+#include "time_warp_simulator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <deque>
+#include <future>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
+
+
+namespace {
+    constexpr uint32_t SINK = UINT32_MAX;
+    constexpr double INF = std::numeric_limits<double>::infinity();
+}
+
+// Named rather than anonymous because `TimeWarpSimulator::Block` has members of these types
+namespace time_warp {
+    // Timestamped increment of a species owned by the receiving block, or the cancellation of one
+    struct Message {
+        double time;
+        uint32_t species;
+        int delta;
+        uint64_t id;
+        bool anti;
+    };
+
+    struct EarlierMessage {
+        bool operator()(const Message& a, const Message& b) const {
+            return a.time < b.time || (a.time == b.time && a.id < b.id);
+        }
+    };
+
+    // Lock-free multi-producer single-consumer mailbox (a Treiber stack drained all at once)
+    class Mailbox {
+    public:
+        struct Node {
+            Message message;
+            Node* next;
+        };
+
+        ~Mailbox() {
+            release(head_.exchange(nullptr));
+        }
+
+        void push(const Message& message) {
+            auto* node = new Node{message, head_.load(std::memory_order_relaxed)};
+            while (!head_.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+        }
+
+        // Takes every queued message, oldest first
+        Node* takeAll() {
+            Node* reversed = nullptr;
+            for (Node* node = head_.exchange(nullptr, std::memory_order_acquire); node != nullptr;) {
+                Node* next = node->next;
+                node->next = reversed;
+                reversed = node;
+                node = next;
+            }
+            return reversed;
+        }
+
+        // Only safe while no producer is running (i.e. at the GVT barrier)
+        [[nodiscard]] double earliest() const {
+            double t = INF;
+            for (const Node* node = head_.load(std::memory_order_acquire); node != nullptr; node = node->next) {
+                t = std::min(t, node->message.time);
+            }
+            return t;
+        }
+
+        static void release(Node* node) {
+            while (node != nullptr) {
+                Node* next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+
+    private:
+        std::atomic<Node*> head_{nullptr};
+    };
+
+    struct Snapshot {
+        double time;
+        std::vector<int> values;  // the block's saved species
+        size_t processed, sent, events;
+    };
+
+    struct SentMessage {
+        Message message;
+        uint32_t to;
+    };
+}
+
+using namespace time_warp;
+
+struct TimeWarpSimulator::Block {
+    uint32_t id = 0;
+    std::vector<uint32_t> reactions;       // owned reactions (global indices)
+    std::vector<uint32_t> saved_species;   // owned and sink species, i.e. what a snapshot holds
+    std::vector<double> propensities;      // per owned reaction
+    std::vector<uint32_t> local_index;     // global reaction -> position in `reactions`
+    double a0 = 0;
+
+    std::vector<int> state;
+    double lvt = 0;
+    double next_time = INF;
+    std::mt19937_64 generator;
+
+    std::deque<Snapshot> snapshots;
+    std::multiset<Message, EarlierMessage> pending;
+    std::deque<Message> processed;
+    std::deque<SentMessage> sent;
+    size_t processed_base = 0, sent_base = 0;
+    Mailbox mailbox;
+
+    uint64_t sequence = 0;
+    size_t events = 0, rolled_back = 0, rollbacks = 0, messages = 0, anti_messages = 0;
+};
+
+TimeWarpSimulator::TimeWarpSimulator(const CompiledNetwork& network, double end_time, unsigned seed, size_t num_blocks,
+                                     TimeWarpOptions options)
+        : network_(network), end_time_(end_time), options_(options), thread_pool_(std::max<size_t>(1, num_blocks)) {
+    network.requireNoScheduledEvents("Time Warp");
+    partition(std::max<size_t>(1, num_blocks), seed);
+}
+
+TimeWarpSimulator::~TimeWarpSimulator() = default;
+
+void TimeWarpSimulator::partition(size_t num_blocks, unsigned seed) {
+    const auto num_species = network_.numSpecies();
+    const auto num_reactions = network_.numReactions();
+
+    // Union-find over species: all reactants of a reaction must end up in the same block
+    std::vector<uint32_t> parent(num_species);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&parent](uint32_t s) {
+        while (parent[s] != s) {
+            s = parent[s] = parent[parent[s]];
+        }
+        return s;
+    };
+    for (size_t r = 0; r < num_reactions; ++r) {
+        const auto reactants = network_.reactants(r);
+        for (size_t i = 1; i < reactants.size(); ++i) {
+            parent[find(reactants[i])] = find(reactants[0]);
+        }
+    }
+    if (options_.locality) {
+        std::map<std::string, uint32_t> first_with_key;
+        for (uint32_t s = 0; s < num_species; ++s) {
+            const auto first = first_with_key.try_emplace(options_.locality(network_.speciesNames()[s]), s).first->second;
+            parent[find(s)] = find(first);
+        }
+    }
+
+    std::vector<uint32_t> root_of_reaction(num_reactions);
+    std::vector<size_t> weight(num_species, 0);
+    for (size_t r = 0; r < num_reactions; ++r) {
+        const auto reactants = network_.reactants(r);
+        const auto changed = network_.changedSpecies(r);
+        const uint32_t anchor = !reactants.empty() ? reactants[0] : (!changed.empty() ? changed[0] : 0);
+        root_of_reaction[r] = find(anchor);
+        ++weight[root_of_reaction[r]];
+    }
+
+    // Largest components first, each onto the least loaded block
+    std::vector<uint32_t> roots;
+    for (uint32_t s = 0; s < num_species; ++s) {
+        if (find(s) == s) {
+            roots.push_back(s);
+        }
+    }
+    std::stable_sort(roots.begin(), roots.end(), [&weight](uint32_t a, uint32_t b) { return weight[a] > weight[b]; });
+
+    std::vector<uint32_t> block_of_root(num_species, 0);
+    std::vector<size_t> load(num_blocks, 0);
+    for (auto root : roots) {
+        const auto b = static_cast<uint32_t>(std::min_element(load.begin(), load.end()) - load.begin());
+        block_of_root[root] = b;
+        load[b] += weight[root] + 1;
+    }
+
+    owner_.resize(num_species);
+    for (uint32_t s = 0; s < num_species; ++s) {
+        owner_[s] = network_.readers(s).empty() ? SINK : block_of_root[find(s)];
+    }
+
+    for (size_t b = 0; b < num_blocks; ++b) {
+        auto block = std::make_unique<Block>();
+        block->id = static_cast<uint32_t>(b);
+        block->local_index.assign(num_reactions, UINT32_MAX);
+        std::seed_seq seq{seed, static_cast<unsigned>(b)};
+        block->generator.seed(seq);
+        for (uint32_t s = 0; s < num_species; ++s) {
+            if (owner_[s] == b || owner_[s] == SINK) {
+                block->saved_species.push_back(s);
+            }
+        }
+        blocks_.push_back(std::move(block));
+    }
+
+    reaction_block_.resize(num_reactions);
+    for (uint32_t r = 0; r < num_reactions; ++r) {
+        const auto b = block_of_root[root_of_reaction[r]];
+        reaction_block_[r] = b;
+        blocks_[b]->local_index[r] = static_cast<uint32_t>(blocks_[b]->reactions.size());
+        blocks_[b]->reactions.push_back(r);
+    }
+}
+
+void TimeWarpSimulator::recomputePropensities(Block& block) {
+    block.propensities.resize(block.reactions.size());
+    block.a0 = 0;
+    for (size_t k = 0; k < block.reactions.size(); ++k) {
+        block.propensities[k] = network_.propensity(block.reactions[k], block.state.data());
+        block.a0 += block.propensities[k];
+    }
+}
+
+void TimeWarpSimulator::drawNextTime(Block& block) {
+    block.next_time = block.a0 > 0
+            ? block.lvt + std::exponential_distribution<double>(block.a0)(block.generator)
+            : INF;
+}
+
+void TimeWarpSimulator::saveState(Block& block) {
+    Snapshot snapshot{block.lvt, {}, block.processed_base + block.processed.size(), block.sent_base + block.sent.size(), block.events};
+    snapshot.values.reserve(block.saved_species.size());
+    for (auto s : block.saved_species) {
+        snapshot.values.push_back(block.state[s]);
+    }
+    block.snapshots.push_back(std::move(snapshot));
+}
+
+void TimeWarpSimulator::send(Block& from, double t, uint32_t species, int delta) {
+    const Message message{t, species, delta, (uint64_t{from.id} << 48) | from.sequence++, false};
+    from.sent.push_back({message, owner_[species]});
+    blocks_[owner_[species]]->mailbox.push(message);
+    ++from.messages;
+}
+
+void TimeWarpSimulator::rollback(Block& block, double t) {
+    const auto events_before = block.events;
+
+    while (block.snapshots.size() > 1 && block.snapshots.back().time >= t) {
+        block.snapshots.pop_back();
+    }
+    const auto& snapshot = block.snapshots.back();
+    for (size_t i = 0; i < block.saved_species.size(); ++i) {
+        block.state[block.saved_species[i]] = snapshot.values[i];
+    }
+    // Nothing happened between the snapshot and `t` in the old history either, and that part of it stays valid:
+    // redrawing from the snapshot time instead would resample it and bias the event rate upwards
+    block.lvt = t;
+    block.events = snapshot.events;
+
+    // Inputs after the restored point have to be processed again
+    while (block.processed_base + block.processed.size() > snapshot.processed) {
+        block.pending.insert(block.processed.back());
+        block.processed.pop_back();
+    }
+    // Messages sent after it never happened
+    while (block.sent_base + block.sent.size() > snapshot.sent) {
+        auto anti = block.sent.back().message;
+        anti.anti = true;
+        blocks_[block.sent.back().to]->mailbox.push(anti);
+        block.sent.pop_back();
+        ++block.anti_messages;
+    }
+
+    block.rolled_back += events_before - block.events;
+    ++block.rollbacks;
+    recomputePropensities(block);
+    drawNextTime(block);
+}
+
+void TimeWarpSimulator::drain(Block& block) {
+    auto* head = block.mailbox.takeAll();
+    for (auto* node = head; node != nullptr; node = node->next) {
+        const auto& message = node->message;
+
+        if (!message.anti) {
+            if (message.time < block.lvt) {
+                rollback(block, message.time);
+            }
+            block.pending.insert(message);
+            continue;
+        }
+
+        // A message and its anti-message travel the same FIFO channel, so the positive one is either still
+        // pending or has been processed, in which case undoing it puts it back into `pending`
+        auto same = [&message](const Message& m) { return m.id == message.id; };
+        auto it = std::find_if(block.pending.begin(), block.pending.end(), same);
+        if (it == block.pending.end()) {
+            rollback(block, message.time);
+            it = std::find_if(block.pending.begin(), block.pending.end(), same);
+        }
+        block.pending.erase(it);
+    }
+    Mailbox::release(head);
+}
+
+void TimeWarpSimulator::processInput(Block& block) {
+    const auto message = *block.pending.begin();
+    block.pending.erase(block.pending.begin());
+
+    block.lvt = message.time;
+    block.state[message.species] += message.delta;
+    block.processed.push_back(message);
+
+    for (auto r : network_.readers(message.species)) {
+        const auto k = block.local_index[r];
+        const double a = network_.propensity(r, block.state.data());
+        block.a0 += a - block.propensities[k];
+        block.propensities[k] = a;
+    }
+
+    drawNextTime(block);
+    saveState(block);
+}
+
+void TimeWarpSimulator::processLocalEvent(Block& block) {
+    block.lvt = block.next_time;
+
+    double target = std::uniform_real_distribution<double>(0.0, block.a0)(block.generator);
+    size_t k = 0;
+    for (; k + 1 < block.reactions.size() && target >= block.propensities[k]; ++k) {
+        target -= block.propensities[k];
+    }
+    const auto r = block.reactions[k];
+
+    if (network_.canFire(r, block.state.data())) {
+        const auto species = network_.changedSpecies(r);
+        const auto deltas = network_.changeDeltas(r);
+        for (size_t i = 0; i < species.size(); ++i) {
+            if (owner_[species[i]] == block.id || owner_[species[i]] == SINK) {
+                block.state[species[i]] += deltas[i];
+            } else {
+                send(block, block.lvt, species[i], deltas[i]);
+            }
+        }
+        for (auto d : network_.dependents(r)) {
+            if (reaction_block_[d] == block.id) {
+                const auto j = block.local_index[d];
+                const double a = network_.propensity(d, block.state.data());
+                block.a0 += a - block.propensities[j];
+                block.propensities[j] = a;
+            }
+        }
+        ++block.events;
+    }
+
+    drawNextTime(block);
+    saveState(block);
+}
+
+void TimeWarpSimulator::advance(Block& block, double horizon) {
+    // Resum once per round so the incrementally updated a0 does not drift, e.g. to a small positive value after every
+    // propensity has dropped to 0, which would keep the block drawing events that cannot happen
+    block.a0 = std::accumulate(block.propensities.begin(), block.propensities.end(), 0.0);
+    if (block.a0 <= 0) {
+        block.next_time = INF;
+    }
+
+    for (size_t step = 0; step < options_.gvt_interval; ++step) {
+        drain(block);
+
+        const double input = block.pending.empty() ? INF : block.pending.begin()->time;
+        const double t = std::min(input, block.next_time);
+        if (t > end_time_ || t > horizon) {
+            break;
+        }
+
+        if (input <= block.next_time) {
+            processInput(block);
+        } else {
+            processLocalEvent(block);
+        }
+    }
+}
+
+double TimeWarpSimulator::lowerBound(const Block& block) const {
+    double t = block.next_time;
+    if (!block.pending.empty()) {
+        t = std::min(t, block.pending.begin()->time);
+    }
+    return std::min(t, block.mailbox.earliest());
+}
+
+void TimeWarpSimulator::collectFossils(Block& block, double gvt) {
+    while (block.snapshots.size() > 1 && block.snapshots[1].time < gvt) {
+        block.snapshots.pop_front();
+    }
+    const auto& oldest = block.snapshots.front();
+    while (block.processed_base < oldest.processed) {
+        block.processed.pop_front();
+        ++block.processed_base;
+    }
+    while (block.sent_base < oldest.sent) {
+        block.sent.pop_front();
+        ++block.sent_base;
+    }
+}
+
+// Global state just before the last GVT: every block's oldest remaining snapshot after fossil collection
+std::vector<int> TimeWarpSimulator::committedState() const {
+    const auto& initial = network_.initialState();
+    std::vector<int> global = initial;
+
+    for (const auto& block : blocks_) {
+        const auto& snapshot = block->snapshots.front();
+        for (size_t i = 0; i < block->saved_species.size(); ++i) {
+            const auto s = block->saved_species[i];
+            if (owner_[s] == SINK) {
+                global[s] += snapshot.values[i] - initial[s];
+            } else {
+                global[s] = snapshot.values[i];
+            }
+        }
+    }
+    return global;
+}
+
+void TimeWarpSimulator::simulate(StateMonitor& monitor) {
+    for (auto& block : blocks_) {
+        block->state = network_.initialState();
+        block->lvt = 0;
+        recomputePropensities(*block);
+        drawNextTime(*block);
+        saveState(*block);
+    }
+
+    double gvt = 0;
+    double window = std::min(options_.optimism_window, end_time_);
+    double horizon = window;
+    bool done = false;
+    size_t committed = 0, wasted = 0;
+
+    // Runs in one thread while all blocks wait, so it may read every block's state
+    auto on_round = [&, this]() noexcept {
+        double bound = INF;
+        for (const auto& block : blocks_) {
+            bound = std::min(bound, lowerBound(*block));
+        }
+        gvt = bound;
+
+        const double cut = std::min(gvt, end_time_);
+        for (auto& block : blocks_) {
+            collectFossils(*block, cut);
+        }
+        monitor(network_, committedState(), cut);
+
+        // Throttle optimism: narrow the window after a round that undid more than it committed, widen it otherwise
+        size_t now_committed = 0, now_wasted = 0;
+        for (const auto& block : blocks_) {
+            now_committed += block->snapshots.front().events;
+            now_wasted += block->rolled_back;
+        }
+        window = now_wasted - wasted > now_committed - committed
+                ? window / 2
+                : std::min(window * 1.25, options_.optimism_window);
+        committed = now_committed;
+        wasted = now_wasted;
+        horizon = gvt + window;
+
+        ++stats_.gvt_rounds;
+        done = gvt > end_time_;
+    };
+
+    std::barrier round(static_cast<std::ptrdiff_t>(blocks_.size()), on_round);
+    std::vector<std::future<void>> futures;
+    for (auto& block : blocks_) {
+        futures.emplace_back(thread_pool_.enqueue([this, &block, &round, &horizon, &done] {
+            while (!done) {
+                advance(*block, horizon);
+                round.arrive_and_wait();
+            }
+        }));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    stats_.blocks = blocks_.size();
+    for (const auto& block : blocks_) {
+        stats_.committed_events += block->events;
+        stats_.rolled_back_events += block->rolled_back;
+        stats_.rollbacks += block->rollbacks;
+        stats_.messages += block->messages;
+        stats_.anti_messages += block->anti_messages;
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef TIME_WARP_SIMULATOR_H
+#define TIME_WARP_SIMULATOR_H
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../compiled_network.h"
+#include "../thread_pool.h"
+#include "../monitor/monitor.h"
+
+struct TimeWarpOptions {
+    size_t gvt_interval = 2000;  // events per block between GVT rounds
+    // Upper bound on how far a block may run ahead of GVT. The window actually used starts there, is halved after
+    // a GVT round that rolled back more events than it committed and grows back by 25% after the others.
+    double optimism_window = std::numeric_limits<double>::infinity();
+    // Optional locality hint: species with the same key are kept in one block (e.g. the region of `S@3`). Without
+    // it only reactants of a common reaction are grouped, which can place tightly coupled species apart.
+    std::function<std::string(const std::string&)> locality;
+};
+
+struct TimeWarpStats {
+    size_t blocks = 0;
+    size_t committed_events = 0;
+    size_t rolled_back_events = 0;
+    size_t rollbacks = 0;
+    size_t messages = 0, anti_messages = 0;
+    size_t gvt_rounds = 0;
+};
+
+// EXPERIMENTAL: optimistic parallel discrete-event simulation (Time Warp, Jefferson 1985) of one trajectory.
+//
+// Species are grouped so that every reaction's reactants lie in one group, and the groups are spread over
+// `num_blocks` blocks (one thread each). A block then owns the reactions that read its species and runs them as
+// an exact SSA with its own clock. A reaction that produces a species owned by another block sends a timestamped
+// increment through that block's lock-free mailbox. A receiver that has already simulated past the timestamp (a
+// straggler) restores the last saved state before it, re-queues later inputs and cancels the messages it sent in
+// the meantime with anti-messages. Species that no reaction reads (e.g. `environment`) are kept as per-block
+// partial counts instead, so degradation does not cross blocks.
+//
+// Every `gvt_interval` events all blocks meet at a barrier, global virtual time (the earliest time any block can
+// still roll back to) is computed, saved state and message logs older than it are fossil-collected, and the
+// monitor is called with the committed global state at GVT. Speedup depends on the coupling: blocks that exchange
+// few messages per event run nearly independently, strongly coupled ones mostly roll back.
+class TimeWarpSimulator {
+public:
+    TimeWarpSimulator(const CompiledNetwork& network, double end_time, unsigned seed, size_t num_blocks,
+                      TimeWarpOptions options = {});
+    ~TimeWarpSimulator();
+
+    void simulate(StateMonitor& monitor);
+
+    [[nodiscard]] const TimeWarpStats& stats() const { return stats_; }
+    // Owning block per species, as chosen by the partitioner
+    [[nodiscard]] const std::vector<uint32_t>& owners() const { return owner_; }
+
+private:
+    struct Block;
+
+    const CompiledNetwork& network_;
+    double end_time_;
+    TimeWarpOptions options_;
+    std::vector<uint32_t> owner_;           // per species; UINT32_MAX for unread (sink) species
+    std::vector<uint32_t> reaction_block_;  // per reaction
+    std::vector<std::unique_ptr<Block>> blocks_;
+    TimeWarpStats stats_;
+    ThreadPool thread_pool_;  // one slot per block, since blocks wait for each other at the GVT barrier
+
+    void partition(size_t num_blocks, unsigned seed);
+    // Processes up to `gvt_interval` inputs/events of one block without passing `horizon` (GVT + window)
+    void advance(Block& block, double horizon);
+    void send(Block& from, double t, uint32_t species, int delta);
+    void drain(Block& block);
+    void rollback(Block& block, double t);
+    void processInput(Block& block);
+    void processLocalEvent(Block& block);
+    void drawNextTime(Block& block);
+    void recomputePropensities(Block& block);
+    void saveState(Block& block);
+    double lowerBound(const Block& block) const;
+    void collectFossils(Block& block, double gvt);
+    std::vector<int> committedState() const;
+};
+
+#endif //TIME_WARP_SIMULATOR_H
@@ -0,0 +1,137 @@
+#include "uniformization_simulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+UniformizationSimulator::UniformizationSimulator(const CompiledNetwork& network, double end_time, unsigned seed,
+                                                 double slack, size_t batch_size)
+        : network_(network), end_time_(end_time), slack_(slack), batch_size_(batch_size), generator_(seed),
+          propensities_(network.numReactions()), gaps_(batch_size), selectors_(batch_size) {
+    for (size_t r = 0; r < network.numReactions(); ++r) {
+        rates_.push_back(network.rate(r));
+    }
+}
+
+void UniformizationSimulator::fillBatch(double lambda, size_t count) {
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (size_t i = 0; i < count; ++i) {
+        gaps_[i] = uniform(generator_);
+        selectors_[i] = uniform(generator_);
+    }
+    // Separate pass so the transform has no dependency on the generator state
+    for (size_t i = 0; i < count; ++i) {
+        gaps_[i] = -std::log1p(-gaps_[i]) / lambda;
+        selectors_[i] *= lambda;
+    }
+}
+
+double UniformizationSimulator::applyScheduledEvent(const CompiledNetwork::ScheduledEvent& event, CompiledNetwork::State& state) {
+    double delta = 0;
+    if (!event.injection) {
+        rates_[event.target] = event.value;
+        const double a = rates_[event.target] * network_.massAction(event.target, state.data());
+        delta = a - propensities_[event.target];
+        propensities_[event.target] = a;
+        return delta;
+    }
+
+    state[event.target] = std::max(0, state[event.target] + static_cast<int>(event.value));
+    for (auto d : network_.readers(event.target)) {
+        const double a = rates_[d] * network_.massAction(d, state.data());
+        delta += a - propensities_[d];
+        propensities_[d] = a;
+    }
+    return delta;
+}
+
+void UniformizationSimulator::simulate(StateMonitor& monitor) {
+    auto state = network_.initialState();
+    const auto num_reactions = network_.numReactions();
+    const auto& events = network_.scheduledEvents();
+    size_t next_event = 0;
+
+    for (size_t r = 0; r < num_reactions; ++r) {
+        propensities_[r] = rates_[r] * network_.massAction(r, state.data());
+    }
+    double a0 = std::accumulate(propensities_.begin(), propensities_.end(), 0.0);
+
+    double t = 0;
+    size_t batch = std::min<size_t>(8, batch_size_);
+    while (t <= end_time_) {
+        const double next_event_time = next_event < events.size() ? events[next_event].time : end_time_ + 1;
+
+        if (a0 <= 0) {
+            // Nothing can fire until the next scheduled event (if any) changes the state or a rate
+            if (next_event_time > end_time_) {
+                break;
+            }
+            t = next_event_time;
+            applyScheduledEvent(events[next_event++], state);
+            monitor(network_, state, t);
+            a0 = std::accumulate(propensities_.begin(), propensities_.end(), 0.0);
+            continue;
+        }
+
+        const double lambda = a0 * (1.0 + slack_);
+        fillBatch(lambda, batch);
+
+        bool refresh = false;
+        size_t i = 0;
+        for (; i < batch && !refresh; ++i) {
+            if (t + gaps_[i] >= next_event_time && next_event_time <= end_time_) {
+                t = next_event_time;
+                a0 += applyScheduledEvent(events[next_event++], state);
+                monitor(network_, state, t);
+                refresh = true;
+                break;
+            }
+
+            t += gaps_[i];
+            if (t > end_time_) {
+                break;
+            }
+
+            double target = selectors_[i];
+            if (target >= a0) {
+                ++rejected_;
+                continue;
+            }
+
+            // a0 is updated incrementally within a batch and can drift above the actual sum; a selector in between
+            // is a thinned candidate like one above a0, never a pick of the last reaction whatever its propensity
+            size_t r = 0;
+            for (; r < num_reactions && target >= propensities_[r]; ++r) {
+                target -= propensities_[r];
+            }
+            if (r == num_reactions) {
+                ++rejected_;
+                continue;
+            }
+
+            if (!network_.canFire(r, state.data())) {
+                continue;
+            }
+
+            network_.fire(r, state.data());
+            for (auto d : network_.dependents(r)) {
+                const double a = rates_[d] * network_.massAction(d, state.data());
+                a0 += a - propensities_[d];
+                propensities_[d] = a;
+            }
+            ++accepted_;
+            monitor(network_, state, t);
+
+            refresh = a0 > lambda || a0 * (1.0 + slack_) * (1.0 + slack_) < lambda;
+        }
+
+        if (!refresh) {
+            batch = std::min(batch * 2, batch_size_);
+        } else if (i < batch / 4) {
+            batch = std::max<size_t>(batch / 2, std::min<size_t>(8, batch_size_));
+        }
+
+        // Resum on every refresh so the incrementally updated a0 does not drift
+        a0 = std::accumulate(propensities_.begin(), propensities_.end(), 0.0);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef UNIFORMIZATION_SIMULATOR_H
+#define UNIFORMIZATION_SIMULATOR_H
+
+#include <random>
+#include <vector>
+
+#include "../compiled_network.h"
+#include "../monitor/monitor.h"
+
+// Exact SSA by uniformization (thinning). Candidate events come from a Poisson process with a constant rate Λ that
+// bounds the total propensity a0; a candidate is accepted with probability a0/Λ, and the same uniform then picks the
+// reaction. Candidate gaps and uniforms are drawn in batches, so the event loop is a tight pass over plain arrays.
+// Since a0 only changes at accepted events, the bound is checked there: when a0 outgrows Λ (or drops far enough
+// below it to waste candidates), Λ is reset and the rest of the batch is discarded, which memorylessness allows.
+// The batch length adapts between 8 and `batch_size` so stiff networks that refresh often do not pay for
+// candidates they never use. Scheduled rate changes and injections are handled the same way: the clock jumps to
+// the breakpoint, only the affected propensities are updated, and the batch is redrawn.
+class UniformizationSimulator {
+public:
+    UniformizationSimulator(const CompiledNetwork& network, double end_time, unsigned seed,
+                            double slack = 0.25, size_t batch_size = 256);
+
+    void simulate(StateMonitor& monitor);
+
+    [[nodiscard]] size_t acceptedEvents() const { return accepted_; }
+    [[nodiscard]] size_t rejectedEvents() const { return rejected_; }
+
+private:
+    const CompiledNetwork& network_;
+    double end_time_;
+    double slack_;
+    size_t batch_size_;
+    std::mt19937_64 generator_;
+
+    std::vector<double> rates_, propensities_;
+    std::vector<double> gaps_, selectors_;
+    size_t accepted_ = 0, rejected_ = 0;
+
+    void fillBatch(double lambda, size_t count);
+    // Applies a scheduled event and returns the change in a0
+    double applyScheduledEvent(const CompiledNetwork::ScheduledEvent& event, CompiledNetwork::State& state);
+
+};
+
+#endif //UNIFORMIZATION_SIMULATOR_H
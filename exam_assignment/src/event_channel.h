@@ -0,0 +1,207 @@
+#ifndef EVENT_CHANNEL_H
+#define EVENT_CHANNEL_H
+
+// A bounded buffer between a producing coroutine (a simulation, see `Simulator::stream`) and a consuming thread. The
+// producer `co_await`s `push`, which suspends it while the buffer is full instead of blocking its thread; the consumer
+// `pop`s, blocking while the buffer is empty, and whenever it frees a slot for a suspended producer it hands the
+// producer to the channel's scheduler. So a slow consumer holds the producer back by at most `capacity` values, and
+// trajectories are analysed or written while they are produced instead of being stored first.
+//
+// By default the scheduler resumes the producer right away on the consumer's thread, which runs the two in turns of
+// up to `capacity` values. To run them in parallel, resume on another thread:
+//
+//     EventChannel<Sample> channel(256, [&pool](std::coroutine_handle<> producer) {
+//         pool.enqueue([producer] { producer.resume(); });
+//     });
+//     simulator.stream(channel, [](const SimulationEvent& event) { return Sample(event); });
+//     for (const auto& sample : channel.values()) { ... }
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "generator.h"
+
+// A coroutine that is started by whoever it is handed to and destroys itself when it returns, for producers whose
+// only output goes through a channel
+class StreamTask {
+public:
+    struct promise_type {
+        StreamTask get_return_object() { return StreamTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        // Producers catch what they can forward to their consumer; anything else has nowhere to go
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    StreamTask(StreamTask&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    StreamTask(const StreamTask&) = delete;
+    StreamTask& operator=(const StreamTask&) = delete;
+    ~StreamTask() {
+        if (handle_) {
+            handle_.destroy();  // never started
+        }
+    }
+
+    // Gives up ownership; the coroutine is destroyed when it runs to its end
+    [[nodiscard]] std::coroutine_handle<> release() { return std::exchange(handle_, {}); }
+
+private:
+    explicit StreamTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template<typename T>
+class EventChannel {
+public:
+    using Scheduler = std::function<void(std::coroutine_handle<>)>;
+
+    explicit EventChannel(size_t capacity, Scheduler scheduler = [](std::coroutine_handle<> h) { h.resume(); })
+            : capacity_(capacity > 0 ? capacity : 1)
+            , scheduler_(std::move(scheduler))
+    {}
+    EventChannel(const EventChannel&) = delete;
+    EventChannel& operator=(const EventChannel&) = delete;
+
+    // Cancels the producer, if one is still running, and waits until it has let go of the channel
+    ~EventChannel() {
+        cancel();
+        std::unique_lock lock(mutex_);
+        cv_.wait(lock, [this] { return !attached_; });
+    }
+
+    // Starts `producer`, through the scheduler. It must `close` the channel when it stops, whatever the reason, and
+    // touch the channel no more after that. One producer per channel.
+    void attach(StreamTask producer) {
+        {
+            std::lock_guard lock(mutex_);
+            attached_ = true;
+        }
+        scheduler_(producer.release());
+    }
+
+    // Producer side: `co_await channel.push(value)` adds `value`, suspending while the buffer is full. Resumes with
+    // false, having dropped `value`, once the consumer has cancelled; the producer should then close and stop.
+    [[nodiscard]] auto push(T value) {
+        struct Awaiter {
+            EventChannel& channel;
+            T value;
+            bool accepted = true;
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> producer) {
+                std::lock_guard lock(channel.mutex_);
+                if (channel.cancelled_) {
+                    accepted = false;
+                    return false;
+                }
+                if (channel.buffer_.size() < channel.capacity_) {
+                    channel.buffer_.push_back(std::move(value));
+                    channel.cv_.notify_all();
+                    return false;
+                }
+                ++channel.suspensions_;
+                channel.waiting_ = producer;
+                channel.pending_ = &value;
+                channel.pending_accepted_ = &accepted;
+                return true;
+            }
+            bool await_resume() const noexcept { return accepted; }
+        };
+        return Awaiter{*this, std::move(value)};
+    }
+
+    // Producer side: no more values. With `error`, the consumer rethrows it once it has taken the values before it.
+    void close(std::exception_ptr error = nullptr) {
+        std::lock_guard lock(mutex_);
+        closed_ = true;
+        attached_ = false;
+        error_ = std::move(error);
+        cv_.notify_all();  // under the lock: the consumer may destroy the channel as soon as it is released
+    }
+
+    // Consumer side: the next value, or nothing once the producer has closed the channel and every value is taken
+    std::optional<T> pop() {
+        std::coroutine_handle<> resume;
+        std::optional<T> value;
+        {
+            std::unique_lock lock(mutex_);
+            cv_.wait(lock, [this] { return !buffer_.empty() || closed_; });
+            if (buffer_.empty()) {
+                if (error_) {
+                    std::rethrow_exception(std::exchange(error_, {}));
+                }
+                return std::nullopt;
+            }
+            value.emplace(std::move(buffer_.front()));
+            buffer_.pop_front();
+            if (waiting_) {
+                buffer_.push_back(std::move(*pending_));
+                resume = std::exchange(waiting_, {});
+            }
+        }
+        if (resume) {
+            scheduler_(resume);
+        }
+        return value;
+    }
+
+    // Consumer side: `pop` until the channel is drained
+    Generator<T> values() {
+        while (auto value = pop()) {
+            co_yield *value;
+        }
+    }
+
+    // Consumer side: drops what is buffered and makes the producer's next (or current) `push` return false
+    void cancel() {
+        std::coroutine_handle<> resume;
+        {
+            std::lock_guard lock(mutex_);
+            cancelled_ = true;
+            buffer_.clear();
+            if (waiting_) {
+                resume = std::exchange(waiting_, {});
+                *pending_accepted_ = false;
+            }
+        }
+        if (resume) {
+            scheduler_(resume);
+        }
+    }
+
+    [[nodiscard]] size_t capacity() const { return capacity_; }
+    // Values buffered right now
+    [[nodiscard]] size_t size() const {
+        std::lock_guard lock(mutex_);
+        return buffer_.size();
+    }
+    // How often the producer found the buffer full and was suspended
+    [[nodiscard]] size_t suspensions() const {
+        std::lock_guard lock(mutex_);
+        return suspensions_;
+    }
+
+private:
+    size_t capacity_;
+    Scheduler scheduler_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<T> buffer_;
+    std::coroutine_handle<> waiting_;  // producer suspended on a full buffer
+    T* pending_ = nullptr;             // the value it is pushing, in its awaiter
+    bool* pending_accepted_ = nullptr;
+    bool attached_ = false, closed_ = false, cancelled_ = false;
+    std::exception_ptr error_;
+    size_t suspensions_ = 0;
+};
+
+#endif //EVENT_CHANNEL_H
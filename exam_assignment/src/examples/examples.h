@@ -5,6 +5,8 @@
 
 System simple();
 System seihr(uint32_t N);
+// SEIHR where contacts (the infection rate) drop by `contact_reduction` between the two lockdown dates
+System seihr_lockdown(uint32_t N, double lockdown_start, double lockdown_end, double contact_reduction);
 System circadian_oscillator();
 
 #endif //EXAMPLES_H
@@ -28,5 +28,17 @@ System seihr(uint32_t N)
     v(I >>= H, kappa); // infectious becomes hospitalized
     v(H >>= R, tau); // hospitalized becomes removed
 
+    return v;
+}
+
+System seihr_lockdown(uint32_t N, double lockdown_start, double lockdown_end, double contact_reduction)
+{
+    auto v = seihr(N);
+
+    // seihr() adds the infection reaction S+I -> E+I first
+    const auto infection = v.getReactions().front();
+    v.schedule(infection, lockdown_start, infection.rate() * (1.0 - contact_reduction));
+    v.schedule(infection, lockdown_end, infection.rate());
+
     return v;
 }
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "static_examples.h"
+#include <cmath>
+
+static_seihr::Model seihr_static(uint32_t N)
+{
+    // Same parameters as seihr()
+    const auto eps = 0.0009;
+    const auto I0 = int(std::round(eps*N));
+    const auto E0 = int(std::round(eps*N*15));
+    const auto S0 = int(N)-I0-E0;
+    const auto R0 = 2.4;
+    const auto alpha = 1.0 / 5.1;
+    const auto gamma = 1.0 / 3.1;
+    const auto beta = R0 * gamma;
+    const auto P_H = 0.9e-3;
+    const auto kappa = gamma * P_H*(1.0-P_H);
+    const auto tau = 1.0/10.12;
+
+    // Rates in the order of the reactions in static_seihr::Model, amounts in species index order
+    return {{beta/N, alpha, gamma, kappa, tau}, {S0, E0, I0, 0, 0}};
+}
+
+static_circadian::Model circadian_oscillator_static()
+{
+    // Same parameters as circadian_oscillator()
+    auto alphaA = 50.0;
+    auto alpha_A = 500.0;
+    auto alphaR = 0.01;
+    auto alpha_R = 50.0;
+    auto betaA = 50.0;
+    auto betaR = 5.0;
+    auto gammaA = 1.0;
+    auto gammaR = 1.0;
+    auto gammaC = 2.0;
+    auto deltaA = 1.0;
+    auto deltaR = 0.2;
+    auto deltaMA = 10.0;
+    auto deltaMR = 0.5;
+    auto thetaA = 50.0;
+    auto thetaR = 100.0;
+
+    return {{gammaA, thetaA, gammaR, thetaR, alpha_A, alphaA, alpha_R, alphaR,
+             betaA, betaR, gammaC, deltaA, deltaA, deltaR, deltaMA, deltaMR},
+            {1, 0, 1, 0, 0, 0, 0, 0, 0, 0}};
+}
@@ -0,0 +1,40 @@
+#ifndef STATIC_EXAMPLES_H
+#define STATIC_EXAMPLES_H
+
+#include <cstdint>
+#include "../static_network.h"
+
+// `seihr` and `circadian_oscillator` in the compile-time DSL, with the same rates and initial amounts.
+namespace static_seihr {
+    inline constexpr static_network::Species<0> S;
+    inline constexpr static_network::Species<1> E;
+    inline constexpr static_network::Species<2> I;
+    inline constexpr static_network::Species<3> H;
+    inline constexpr static_network::Species<4> R;
+
+    using Model = decltype(static_network::kernel(S + I >>= E + I, E >>= I, I >>= R, I >>= H, H >>= R));
+}
+
+namespace static_circadian {
+    inline constexpr static_network::Species<0> DA;
+    inline constexpr static_network::Species<1> D_A;
+    inline constexpr static_network::Species<2> DR;
+    inline constexpr static_network::Species<3> D_R;
+    inline constexpr static_network::Species<4> MA;
+    inline constexpr static_network::Species<5> MR;
+    inline constexpr static_network::Species<6> A;
+    inline constexpr static_network::Species<7> R;
+    inline constexpr static_network::Species<8> C;
+    inline constexpr static_network::Species<9> env;
+
+    using Model = decltype(static_network::kernel(
+            A + DA >>= D_A, D_A >>= DA + A, A + DR >>= D_R, D_R >>= DR + A,
+            D_A >>= MA + D_A, DA >>= MA + DA, D_R >>= MR + D_R, DR >>= MR + DR,
+            MA >>= MA + A, MR >>= MR + R, A + R >>= C, C >>= R,
+            A >>= env, R >>= env, MA >>= env, MR >>= env));
+}
+
+static_seihr::Model seihr_static(uint32_t N);
+static_circadian::Model circadian_oscillator_static();
+
+#endif //STATIC_EXAMPLES_H
@@ -0,0 +1,37 @@
+#include "adaptive_seihr.h"
+
+#include <chrono>
+#include <iostream>
+#include "../examples/examples.h"
+#include "../engines/adaptive_simulator.h"
+#include "../engines/uniformization_simulator.h"
+#include "../monitor/species_peak_monitor.h"
+
+void simulate_adaptive_seihr(size_t N) {
+    const CompiledNetwork network(seihr(N));
+
+    auto begin = std::chrono::steady_clock::now();
+    SpeciesPeakMonitor adaptive_peak("H");
+    AdaptiveSimulator adaptive(network, 100, 42);
+    adaptive.simulate(adaptive_peak);
+    auto end = std::chrono::steady_clock::now();
+
+    const auto& metadata = adaptive.metadata();
+    std::cout << "Adaptive SEIHR (N = " << N << "): H peak " << *adaptive_peak.speciesPeak << " in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms, "
+              << metadata.exact_events << " exact events, " << metadata.leaps << " leaps covering "
+              << metadata.leaped_firings << " firings (" << metadata.rejected_leaps << " rejected)" << std::endl;
+    for (const auto& decision : metadata.decisions) {
+        std::cout << "  " << decision << std::endl;
+    }
+
+    begin = std::chrono::steady_clock::now();
+    SpeciesPeakMonitor exact_peak("H");
+    UniformizationSimulator exact(network, 100, 42);
+    exact.simulate(exact_peak);
+    end = std::chrono::steady_clock::now();
+
+    std::cout << "Exact SEIHR (N = " << N << "): H peak " << *exact_peak.speciesPeak << " in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms, "
+              << exact.acceptedEvents() << " events" << std::endl;
+}
@@ -0,0 +1,9 @@
+#ifndef ADAPTIVE_SEIHR_H
+#define ADAPTIVE_SEIHR_H
+
+#include <cstddef>
+
+// One SEIHR trajectory with automatic engine selection, printing the engine decisions next to an exact run.
+void simulate_adaptive_seihr(size_t N);
+
+#endif //ADAPTIVE_SEIHR_H
@@ -1,4 +1,13 @@
 #include "benchmark.h"
+#include "../engines/uniformization_simulator.h"
+#include "../engines/adaptive_simulator.h"
+#include "../engines/generated_simulator.h"
+#include "../examples/static_examples.h"
+#include "../scaling_harness.h"
+#include "../perf_counters.h"
+#include "../monitor/species_peak_monitor.h"
+#include <fstream>
+#include <thread>
 
 BenchmarkPlotter::BenchmarkPlotter(const std::string& title, const std::string& xlabel, const std::string& ylabel, int width, int height)
         : plot_(title, xlabel, ylabel, width, height) {}
@@ -19,6 +28,10 @@ void BenchmarkPlotter::addLine(const LevelSimulationsMap& data) {
     }
 }
 
+void BenchmarkPlotter::addLine(const std::string& name, const std::vector<double>& x, const std::vector<double>& y) {
+    plot_.lines(name, x, y);
+}
+
 void BenchmarkPlotter::save(const std::string& filename) {
     plot_.process();
     plot_.save_to_png(filename);
@@ -84,16 +97,23 @@ Results Benchmark::performSimulations(size_t concurrency_level, size_t num_simul
 }
 
 void Benchmark::performSimulationsAndStoreResults(size_t concurrency_level, size_t num_simulation) {
+    // Opened before the thread pools are started, so their workers are counted too
+    PerfCounters perf;
+    perf.start();
     auto begin_total = std::chrono::steady_clock::now();
 
     Results results = performSimulations(concurrency_level, num_simulation);
+    const auto counters = perf.stop();
     double average = calculateAverage(results);
     addResultToMap(concurrency_level, num_simulation, average, average_runtimes);
     std::cout << "Average time" << " for " << num_simulation << " w. CL " << concurrency_level << " = " << average << "ms" << std::endl;
 
-    auto total = (std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin_total).count() / numRepeats_) / 1000;
+    auto total = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_total).count() / numRepeats_;
     addResultToMap(concurrency_level, num_simulation, total, average_total_runtimes);
     std::cout << "Total time" << " for " << num_simulation << " w. CL " << concurrency_level << " = " << total << "s" << std::endl;
+    if (perf.available()) {
+        std::cout << "Per simulation: " << counters.per(static_cast<double>(num_simulation * numRepeats_)) << std::endl;
+    }
 }
 
 double Benchmark::calculateAverage(const Results& results) {
@@ -128,4 +148,163 @@ void do_benchmarks() {
         plotTotal.addLine(benchmark.GetTotalRuntimes());
         plotTotal.save("total_sim_benchmark_results.png");
     }
+}
+
+void do_scaling_benchmarks() {
+    std::vector<size_t> threads{1};
+    for (size_t t = 2; t <= std::max(1u, std::thread::hardware_concurrency()); t *= 2) {
+        threads.push_back(t);
+    }
+
+    // Pinning only changes anything with more than one socket; single-node machines measure the default placement
+    std::vector<Placement> placements{Placement::None};
+    if (CpuTopology::detect().numa()) {
+        placements.insert(placements.end(), {Placement::Cores, Placement::Sockets});
+    }
+
+    for (auto placement : placements) {
+        ScalingHarness<SpeciesPeakMonitor> harness(
+                [] { return seihr(10000); },
+                [] { return std::make_unique<SpeciesPeakMonitor>("H"); },
+                100, {.threads = threads, .repeats = 10, .placement = placement});
+
+        const std::vector<std::pair<ScalingMode, std::vector<ScalingPoint>>> sweeps{
+                {ScalingMode::Strong, harness.strong(64)},
+                {ScalingMode::Weak, harness.weak(8)}};
+
+        for (const auto& [mode, points] : sweeps) {
+            std::string name = mode == ScalingMode::Strong ? "strong" : "weak";
+            if (placement != Placement::None) {
+                name += "_" + std::string(to_string(placement));
+            }
+            std::ofstream csv("scaling_" + name + ".csv");
+            write_scaling_csv(csv, points);
+            std::ofstream json("scaling_" + name + ".json");
+            write_scaling_json(json, "SEIHR (N=10000), placement " + std::string(to_string(placement)), mode, points);
+
+            std::vector<double> x, speedup, efficiency;
+            for (const auto& point : points) {
+                std::cout << name << " scaling, " << point.threads << " threads, " << point.replicas << " replicas: median "
+                          << point.time.median << "s (IQR " << point.time.iqr() << "s), speedup " << point.speedup
+                          << " [" << point.speedup_ci_low << ", " << point.speedup_ci_high << "], efficiency "
+                          << point.efficiency << ", Karp-Flatt " << point.karp_flatt << std::endl;
+                x.push_back(static_cast<double>(point.threads));
+                speedup.push_back(point.speedup);
+                efficiency.push_back(point.efficiency);
+            }
+
+            BenchmarkPlotter plot("Scaling (" + name + ") - SEIHR", "Threads", "Speedup / efficiency", 1920, 1080);
+            plot.addLine("Ideal speedup", x, x);
+            plot.addLine("Speedup (median)", x, speedup);
+            plot.addLine("Efficiency", x, efficiency);
+            plot.save("scaling_" + name + ".png");
+        }
+    }
+}
+
+namespace {
+    struct EventCounter : StateMonitor {
+        size_t events = 0;
+        void operator()(const CompiledNetwork&, std::span<const int>, double) override { ++events; }
+    };
+
+    template <typename Run>
+    void time_engine(const std::string& name, const std::string& model, int runs, Run run) {
+        PerfCounters perf;
+        size_t events = 0;
+        perf.start();
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; ++i) {
+            events += run(static_cast<unsigned>(i));
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        const auto counters = perf.stop();
+
+        std::cout << model << " / " << name << ": " << seconds * 1000 / runs << "ms per run, "
+                  << events / seconds << " events/s" << std::endl;
+        if (perf.available()) {
+            std::cout << "    per event: " << counters.per(static_cast<double>(events)) << std::endl;
+        } else {
+            static bool warned = false;
+            if (!warned) {
+                std::cout << "    hardware counters unavailable: " << perf.why() << std::endl;
+                warned = true;
+            }
+        }
+    }
+}
+
+void do_exact_engine_benchmarks() {
+    const int runs = 5;
+    std::vector<std::pair<std::string, System>> models{{"SEIHR (N=10000)", seihr(10000)}, {"Circadian", circadian_oscillator()}};
+
+    for (const auto& [model, system] : models) {
+        CompiledNetwork network(system);
+
+        time_engine("first reaction (Simulator)", model, runs, [&](unsigned) {
+            size_t events = 0;
+            auto counter = [&events](const auto&, const auto&) { ++events; };
+            Simulator simulator(system, 100);
+            simulator.simulate(counter);
+            return events;
+        });
+
+        time_engine("uniformization", model, runs, [&](unsigned seed) {
+            EventCounter counter;
+            UniformizationSimulator simulator(network, 100, seed);
+            simulator.simulate(counter);
+            return counter.events;
+        });
+    }
+}
+
+void do_static_kernel_benchmarks() {
+    const int runs = 5;
+    const auto seihr_system = seihr(10000);
+    const auto circadian_system = circadian_oscillator();
+    const CompiledNetwork seihr_network(seihr_system), circadian_network(circadian_system);
+    const auto seihr_kernel = seihr_static(10000);
+    const auto circadian_kernel = circadian_oscillator_static();
+    // Compiled (or loaded from the cache) up front, so the timings below do not include the compiler
+    const GeneratedKernel seihr_generated(seihr_network), circadian_generated(circadian_network);
+
+    auto direct = [](const CompiledNetwork& network) {
+        return [&network](unsigned seed) {
+            EventCounter counter;
+            AdaptiveSimulator simulator(network, 100, seed, {.engine = EngineKind::Direct});
+            simulator.simulate(counter);
+            return counter.events;
+        };
+    };
+    auto runtime = [](const System& system) {
+        return [&system](unsigned) {
+            size_t events = 0;
+            auto counter = [&events](const auto&, const auto&) { ++events; };
+            Simulator simulator(system, 100);
+            simulator.simulate(counter);
+            return events;
+        };
+    };
+    auto generated = [](const GeneratedKernel& kernel) {
+        return [&kernel](unsigned seed) {
+            EventCounter counter;
+            GeneratedSimulator simulator(kernel, 100, seed);
+            simulator.simulate(counter);
+            return counter.events;
+        };
+    };
+
+    time_engine("runtime DSL (Simulator)", "SEIHR (N=10000)", runs, runtime(seihr_system));
+    time_engine("direct method (CompiledNetwork)", "SEIHR (N=10000)", runs, direct(seihr_network));
+    time_engine("direct method (static kernel)", "SEIHR (N=10000)", runs, [&](unsigned seed) {
+        return seihr_kernel.simulate(100, seed, [](const auto&, double) {});
+    });
+    time_engine("direct method (generated .so)", "SEIHR (N=10000)", runs, generated(seihr_generated));
+
+    time_engine("runtime DSL (Simulator)", "Circadian", runs, runtime(circadian_system));
+    time_engine("direct method (CompiledNetwork)", "Circadian", runs, direct(circadian_network));
+    time_engine("direct method (static kernel)", "Circadian", runs, [&](unsigned seed) {
+        return circadian_kernel.simulate(100, seed, [](const auto&, double) {});
+    });
+    time_engine("direct method (generated .so)", "Circadian", runs, generated(circadian_generated));
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../examples/examples.h"
 #include "../plot/plot.hpp"
 #include "../stochastic_simulator.h"
+#include "../compiled_network.h"
 #include "../thread_pool.h"
 #include <chrono>
 #include <vector>
@@ -19,6 +20,7 @@ class BenchmarkPlotter {
 public:
     BenchmarkPlotter(const std::string& title, const std::string& xlabel, const std::string& ylabel, int width, int height);
     void addLine(const LevelSimulationsMap& data);
+    void addLine(const std::string& name, const std::vector<double>& x, const std::vector<double>& y);
     void save(const std::string& filename);
 
 private:
@@ -56,4 +58,14 @@ private:
 
 void do_benchmarks();
 
+// Strong and weak scaling of ParallelSimulator on SEIHR, written to scaling_{strong,weak}.{csv,json} and plotted.
+void do_scaling_benchmarks();
+
+// Compares the exact engines on SEIHR and the circadian oscillator by wall time and events per second.
+void do_exact_engine_benchmarks();
+
+// Compares the runtime DSL, the compiled network, the compile-time kernels and the generated shared-library kernels
+// on the same direct method.
+void do_static_kernel_benchmarks();
+
 #endif //BENCHMARK_H
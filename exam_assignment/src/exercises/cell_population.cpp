@@ -0,0 +1,47 @@
+#include "cell_population.h"
+
+#include <chrono>
+#include <iostream>
+#include "../examples/examples.h"
+#include "../engines/replicated_simulator.h"
+
+namespace {
+    class NullMonitor : public StateMonitor {
+    public:
+        void operator()(const CompiledNetwork&, std::span<const int>, double) override {}
+    };
+}
+
+ReplicatedNetwork circadian_population(size_t cells, double coupling_rate) {
+    ReplicatedNetwork population(circadian_oscillator(), cells);
+    for (size_t i = 0; i < cells; ++i) {
+        const auto next = (i + 1) % cells;
+        population.addCoupling({population.site(i, "A")}, {population.site(next, "A")}, coupling_rate);
+        population.addCoupling({population.site(next, "A")}, {population.site(i, "A")}, coupling_rate);
+    }
+    return population;
+}
+
+void simulate_cell_population() {
+    for (size_t cells : {100, 1000, 10000}) {
+        const auto population = circadian_population(cells, 0.1);
+        // Roughly the same number of events per run
+        const double end_time = 300.0 / static_cast<double>(cells);
+
+        auto begin = std::chrono::steady_clock::now();
+        NullMonitor monitor;
+        ReplicatedSimulator simulator(population, end_time, 42);
+        simulator.simulate(monitor);
+        auto end = std::chrono::steady_clock::now();
+
+        const auto events = simulator.events() + simulator.couplingEvents();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        const auto bytes_per_cell = population.cell().numSpecies() * sizeof(int)  // state slice
+                + 2 * sizeof(double)                                           // instance leaf and its parent
+                + 2 * sizeof(ReplicatedNetwork::Coupling);                     // its couplings
+        std::cout << "Circadian population of " << cells << " cells: " << events << " events ("
+                  << simulator.couplingEvents() << " coupling) in " << ns / 1000000 << "ms, "
+                  << static_cast<double>(ns) / static_cast<double>(events) << "ns per event, ~"
+                  << bytes_per_cell << " bytes per cell" << std::endl;
+    }
+}
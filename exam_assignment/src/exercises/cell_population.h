@@ -0,0 +1,14 @@
+#ifndef CELL_POPULATION_H
+#define CELL_POPULATION_H
+
+#include <cstddef>
+#include "../replicated_network.h"
+
+// `cells` circadian oscillators on a ring, exchanging the activator A with both neighbours at `coupling_rate`.
+ReplicatedNetwork circadian_population(size_t cells, double coupling_rate);
+
+// Simulates growing populations with the hierarchical engine and reports the cost per event and the memory
+// held per cell, both of which should stay flat as the population grows.
+void simulate_cell_population();
+
+#endif //CELL_POPULATION_H
@@ -0,0 +1,22 @@
+#include "fsp_simple.h"
+
+#include <chrono>
+#include <iostream>
+#include "../examples/examples.h"
+#include "../engines/fsp_solver.h"
+
+void solve_simple_fsp() {
+    auto begin = std::chrono::steady_clock::now();
+
+    FspSolver fsp(simple());
+    std::cout << "FSP of Simple enumerated " << fsp.numStates() << " states" << std::endl;
+
+    for (double t : {1000.0, 5000.0, 10000.0, 50000.0}) {
+        auto result = fsp.solve(t);
+        std::cout << "t = " << t << ": E[A] = " << fsp.mean(result, "A") << ", E[B] = " << fsp.mean(result, "B")
+                  << ", truncation error = " << result.truncation_error << std::endl;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Time elapsed for FSP = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms" << std::endl;
+}
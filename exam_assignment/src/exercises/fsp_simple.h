@@ -0,0 +1,7 @@
+#ifndef FSP_SIMPLE_H
+#define FSP_SIMPLE_H
+
+// Computes the exact distribution of the simple example with Finite State Projection instead of sampling.
+void solve_simple_fsp();
+
+#endif //FSP_SIMPLE_H
@@ -0,0 +1,32 @@
+#include "mlmc_seihr.h"
+
+#include <chrono>
+#include <iostream>
+#include "../examples/examples.h"
+#include "../multilevel_monte_carlo.h"
+#include "../monitor/species_peak_monitor.h"
+
+void estimate_seihr_peak_mlmc(size_t N, double target_rmse, size_t concurrency_level) {
+    auto begin = std::chrono::steady_clock::now();
+
+    MultilevelOptions options;
+    options.target_rmse = target_rmse;
+    options.num_threads = concurrency_level;
+
+    MultilevelMonteCarlo<SpeciesPeakMonitor> mlmc(
+            seihr(N),
+            [] { return std::make_unique<SpeciesPeakMonitor>("H"); },
+            [](const SpeciesPeakMonitor& monitor) { return *monitor.speciesPeak; },
+            options);
+
+    auto result = mlmc.run();
+
+    for (const auto& level : result.levels) {
+        std::cout << level.description << ": " << level.samples << " samples, mean " << level.mean
+                  << ", variance " << level.variance << ", " << level.cost * 1000 << "ms/sample" << std::endl;
+    }
+    std::cout << "MLMC mean peak of Hospitalized: " << result.estimate << " ± " << result.standard_error << std::endl;
+
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Time elapsed for MLMC w. CL " << concurrency_level << " = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms" << std::endl;
+}
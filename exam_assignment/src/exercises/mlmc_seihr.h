@@ -0,0 +1,9 @@
+#ifndef MLMC_SEIHR_H
+#define MLMC_SEIHR_H
+
+#include <cstddef>
+
+// Estimates the mean peak of hospitalized agents in SEIHR with multilevel Monte Carlo instead of plain SSA ensembles.
+void estimate_seihr_peak_mlmc(size_t N, double target_rmse, size_t concurrency_level);
+
+#endif //MLMC_SEIHR_H
@@ -17,7 +17,9 @@ void perform_parallel_simulations(const size_t N, const size_t num_simulations,
     auto system_factory = [&N]() { return seihr(N); };
     auto monitor_factory = []() { return std::make_unique<SpeciesPeakMonitor>("H"); };
 
-    ParallelSimulator<SpeciesPeakMonitor> parallel_simulator(system_factory, monitor_factory, 100, num_simulations, concurrency_level);
+    // Progress of long ensembles (Denmark takes minutes), also scrapeable from stochastic_simulator.prom
+    Telemetry telemetry(concurrency_level, {.metrics_file = "stochastic_simulator.prom", .interval = std::chrono::seconds(5), .console = &std::cout});
+    ParallelSimulator<SpeciesPeakMonitor> parallel_simulator(system_factory, monitor_factory, 100, num_simulations, concurrency_level, &telemetry);
 
     parallel_simulator.simulate();
 
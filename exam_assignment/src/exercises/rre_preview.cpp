@@ -0,0 +1,18 @@
+#include "rre_preview.h"
+
+#include <chrono>
+#include <iostream>
+#include "../examples/examples.h"
+#include "../engines/rre_solver.h"
+
+void preview_seihr_rre(size_t N) {
+    auto begin = std::chrono::steady_clock::now();
+
+    RreSolver rre(seihr(N));
+    auto trajectory = rre.solve(100, 0.1);
+
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "RRE peak of Hospitalized for N = " << N << ": " << trajectory.peak("H") << " ("
+              << trajectory.accepted_steps << " steps, " << trajectory.rejected_steps << " rejected, "
+              << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "us)" << std::endl;
+}
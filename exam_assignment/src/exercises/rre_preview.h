@@ -0,0 +1,9 @@
+#ifndef RRE_PREVIEW_H
+#define RRE_PREVIEW_H
+
+#include <cstddef>
+
+// Deterministic (reaction rate equation) preview of the SEIHR hospitalized peak, for comparison with the ensembles.
+void preview_seihr_rre(size_t N);
+
+#endif //RRE_PREVIEW_H
@@ -0,0 +1,48 @@
+#include "spatial_seihr.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../examples/examples.h"
+#include "../monitor/species_peak_monitor.h"
+
+Metapopulation seihr_regions(size_t regions, uint32_t N, double travel_rate) {
+    Metapopulation model(seihr(N), regions);
+    for (size_t i = 1; i < regions; ++i) {
+        model.setAmount(i, "S", static_cast<int>(N));
+        model.setAmount(i, "E", 0);
+        model.setAmount(i, "I", 0);
+    }
+
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<size_t> anywhere(0, regions - 1);
+    for (size_t i = 0; i < regions; ++i) {
+        const size_t far = anywhere(generator);
+        for (const auto* species : {"S", "E", "I", "R"}) {
+            model.addMigration(i, (i + 1) % regions, species, travel_rate);
+            model.addMigration(i, (i + regions - 1) % regions, species, travel_rate);
+            if (far != i) {
+                model.addMigration(i, far, species, travel_rate);
+            }
+        }
+    }
+
+    return model;
+}
+
+void simulate_spatial_seihr(size_t regions, uint32_t N, size_t concurrency_level) {
+    const auto model = seihr_regions(regions, N, 0.01);
+
+    for (size_t threads : {size_t{1}, concurrency_level}) {
+        auto begin = std::chrono::steady_clock::now();
+
+        SpeciesPeakMonitor monitor("H");
+        SpatialSimulator simulator(model, 100, 42, threads);
+        simulator.simulate(monitor);
+
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "Regional SEIHR (" << regions << " x " << N << ", " << threads << " threads): national H peak "
+                  << *monitor.speciesPeak << ", " << simulator.events() << " events in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms" << std::endl;
+    }
+}
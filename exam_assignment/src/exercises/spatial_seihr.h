@@ -0,0 +1,15 @@
+#ifndef SPATIAL_SEIHR_H
+#define SPATIAL_SEIHR_H
+
+#include <cstddef>
+#include <cstdint>
+#include "../engines/spatial_simulator.h"
+
+// `regions` municipalities of `N` agents each, connected in a ring plus one long-range link per municipality.
+// Only municipality 0 starts with infections; everyone but the hospitalized travels at `travel_rate`.
+Metapopulation seihr_regions(size_t regions, uint32_t N, double travel_rate);
+
+// Simulates regional SEIHR with the next subvolume method and reports the national hospitalized peak.
+void simulate_spatial_seihr(size_t regions, uint32_t N, size_t concurrency_level);
+
+#endif //SPATIAL_SEIHR_H
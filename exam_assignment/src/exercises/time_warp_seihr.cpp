@@ -0,0 +1,122 @@
+#include "time_warp_seihr.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include "spatial_seihr.h"
+#include "../engines/time_warp_simulator.h"
+#include "../monitor/species_peak_monitor.h"
+
+namespace {
+    // Peak of a species summed over all regions of a flattened model
+    class RegionalPeakMonitor : public StateMonitor {
+    public:
+        RegionalPeakMonitor(const CompiledNetwork& network, const std::string& species) {
+            const auto prefix = species + "@";
+            for (size_t s = 0; s < network.numSpecies(); ++s) {
+                if (network.speciesNames()[s].starts_with(prefix)) {
+                    indices_.push_back(s);
+                }
+            }
+        }
+
+        void operator()(const CompiledNetwork&, std::span<const int> state, double) override {
+            int total = 0;
+            for (auto s : indices_) {
+                total += state[s];
+            }
+            peak = std::max(peak, total);
+        }
+
+        int peak = 0;
+
+    private:
+        std::vector<size_t> indices_;
+    };
+}
+
+System flatten(const Metapopulation& model) {
+    const auto& local = model.local();
+    const auto num_species = local.numSpecies();
+
+    System system;
+    std::vector<Species> species;
+    for (size_t region = 0; region < model.numRegions(); ++region) {
+        for (size_t s = 0; s < num_species; ++s) {
+            species.push_back(system(local.speciesNames()[s] + "@" + std::to_string(region),
+                                     model.initialState()[region * num_species + s]));
+        }
+    }
+
+    for (size_t region = 0; region < model.numRegions(); ++region) {
+        const auto* in = species.data() + region * num_species;
+        for (size_t r = 0; r < local.numReactions(); ++r) {
+            // Products are the reactants plus the net change, so catalysts survive the round trip
+            std::map<uint32_t, int> products;
+            std::vector<Species> reactants;
+            for (auto s : local.reactants(r)) {
+                reactants.push_back(in[s]);
+                ++products[s];
+            }
+            const auto changed = local.changedSpecies(r);
+            const auto deltas = local.changeDeltas(r);
+            for (size_t i = 0; i < changed.size(); ++i) {
+                products[changed[i]] += deltas[i];
+            }
+
+            std::vector<Species> out;
+            for (const auto& [s, count] : products) {
+                out.insert(out.end(), std::max(count, 0), in[s]);
+            }
+            system(Reaction(std::move(reactants), std::move(out)), local.rate(r));
+        }
+    }
+
+    for (const auto& migration : model.migrations()) {
+        system(species[migration.from * num_species + migration.species] >>= species[migration.to * num_species + migration.species],
+               migration.rate);
+    }
+
+    return system;
+}
+
+void simulate_time_warp_seihr(size_t regions, uint32_t N, size_t concurrency_level) {
+    constexpr double end_time = 100;
+
+    for (double travel_rate : {0.001, 0.01}) {
+        const auto model = seihr_regions(regions, N, travel_rate);
+
+        auto begin = std::chrono::steady_clock::now();
+        SpeciesPeakMonitor reference("H");
+        SpatialSimulator sequential(model, end_time, 42);
+        sequential.simulate(reference);
+        const auto sequential_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        std::cout << "Time Warp SEIHR (" << regions << " x " << N << ", travel rate " << travel_rate
+                  << "): sequential NSM H peak " << *reference.speciesPeak << ", " << sequential.events() << " events in "
+                  << sequential_ms << "ms" << std::endl;
+
+        const CompiledNetwork network(flatten(model));
+        TimeWarpOptions options;
+        options.locality = [](const std::string& species) { return species.substr(species.find('@') + 1); };
+        std::vector<size_t> block_counts{1, 2, 4, concurrency_level};
+        std::sort(block_counts.begin(), block_counts.end());
+        block_counts.erase(std::unique(block_counts.begin(), block_counts.end()), block_counts.end());
+
+        for (size_t blocks : block_counts) {
+            begin = std::chrono::steady_clock::now();
+            RegionalPeakMonitor monitor(network, "H");
+            TimeWarpSimulator simulator(network, end_time, 42, blocks, options);
+            simulator.simulate(monitor);
+            const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+            const auto& stats = simulator.stats();
+            std::cout << "  " << blocks << " blocks: H peak " << monitor.peak << " (at GVT rounds), "
+                      << stats.committed_events << " events in " << ms << "ms, speedup " << sequential_ms / ms
+                      << ", " << stats.rolled_back_events << " rolled back in " << stats.rollbacks << " rollbacks, "
+                      << stats.messages << " messages, " << stats.anti_messages << " anti-messages, "
+                      << stats.gvt_rounds << " GVT rounds" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef TIME_WARP_SEIHR_H
+#define TIME_WARP_SEIHR_H
+
+#include <cstddef>
+#include <cstdint>
+#include "../engines/spatial_simulator.h"
+
+// The metapopulation as one flat `System`: species `X@i` per region and one first-order reaction `X@i -> X@j` per
+// migration edge, which is the form a general-purpose engine such as Time Warp works on.
+System flatten(const Metapopulation& model);
+
+// Simulates regional SEIHR as a single large trajectory with Time Warp at several block counts and compares the
+// national hospitalized peak and runtime with the sequential next subvolume method.
+void simulate_time_warp_seihr(size_t regions, uint32_t N, size_t concurrency_level);
+
+#endif //TIME_WARP_SEIHR_H
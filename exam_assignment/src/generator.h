@@ -0,0 +1,105 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+// A lazily produced sequence, written as a coroutine that `co_yield`s its elements, until std::generator (C++23) is
+// available. Each element is produced when the consumer advances to it, and the consumer sees the yielded object
+// itself, not a copy, so it is only valid until the next increment. An exception thrown in the coroutine is rethrown
+// from `begin()` or `++`.
+//
+//     Generator<int> naturals() { for (int i = 0;; ++i) co_yield i; }
+//     for (int i : naturals()) { if (i > 9) break; }
+template<typename T>
+class Generator {
+public:
+    struct promise_type {
+        const T* value = nullptr;
+        std::exception_ptr exception;
+
+        Generator get_return_object() { return Generator(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        // The operand lives until the coroutine resumes, so pointing at it is enough
+        std::suspend_always yield_value(const T& yielded) noexcept {
+            value = std::addressof(yielded);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() { exception = std::current_exception(); }
+        // Only `co_yield`: awaiting anything else would suspend the consumer's loop on something it cannot see
+        template<typename U>
+        std::suspend_never await_transform(U&&) = delete;
+    };
+
+    class iterator {
+    public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        const T& operator*() const { return *handle_.promise().value; }
+        const T* operator->() const { return handle_.promise().value; }
+
+        iterator& operator++() {
+            advance(handle_);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) { return it.handle_.done(); }
+
+    private:
+        friend class Generator;
+        explicit iterator(typename Generator::Handle handle) : handle_(handle) {}
+
+        typename Generator::Handle handle_;
+    };
+
+    Generator(Generator&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Generator& operator=(Generator&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+    ~Generator() { reset(); }
+
+    // Runs the coroutine to its first element; call once
+    iterator begin() {
+        advance(handle_);
+        return iterator(handle_);
+    }
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Generator(Handle handle) : handle_(handle) {}
+
+    static void advance(Handle handle) {
+        handle.resume();
+        if (handle.promise().exception) {
+            std::rethrow_exception(std::exchange(handle.promise().exception, {}));
+        }
+    }
+
+    void reset() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    Handle handle_;
+};
+
+#endif //GENERATOR_H
@@ -0,0 +1,78 @@
+#ifndef INDEXED_PRIORITY_QUEUE_H
+#define INDEXED_PRIORITY_QUEUE_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Binary min-heap over the fixed index set 0..n-1 with a position map, so the key of any index can be changed in
+// O(log n). This is the queue behind next-reaction style engines: the indices are reactions (or subvolumes) and
+// the keys are their next firing times.
+class IndexedPriorityQueue {
+public:
+    explicit IndexedPriorityQueue(size_t n = 0)
+            : keys_(n, std::numeric_limits<double>::infinity()), heap_(n), position_(n) {
+        for (uint32_t i = 0; i < n; ++i) {
+            heap_[i] = i;
+            position_[i] = i;
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return heap_.size(); }
+    [[nodiscard]] size_t top() const { return heap_.front(); }
+    [[nodiscard]] double topKey() const { return keys_[heap_.front()]; }
+    [[nodiscard]] double key(size_t i) const { return keys_[i]; }
+
+    void update(size_t i, double key) {
+        const double old = keys_[i];
+        keys_[i] = key;
+        if (key < old) {
+            siftUp(position_[i]);
+        } else {
+            siftDown(position_[i]);
+        }
+    }
+
+private:
+    std::vector<double> keys_;
+    std::vector<uint32_t> heap_;      // heap position -> index
+    std::vector<uint32_t> position_;  // index -> heap position
+
+    void swap(size_t a, size_t b) {
+        std::swap(heap_[a], heap_[b]);
+        position_[heap_[a]] = static_cast<uint32_t>(a);
+        position_[heap_[b]] = static_cast<uint32_t>(b);
+    }
+
+    void siftUp(size_t p) {
+        while (p > 0) {
+            const size_t parent = (p - 1) / 2;
+            if (keys_[heap_[parent]] <= keys_[heap_[p]]) {
+                break;
+            }
+            swap(p, parent);
+            p = parent;
+        }
+    }
+
+    void siftDown(size_t p) {
+        const size_t n = heap_.size();
+        while (true) {
+            size_t smallest = p;
+            const size_t left = 2 * p + 1, right = 2 * p + 2;
+            if (left < n && keys_[heap_[left]] < keys_[heap_[smallest]]) {
+                smallest = left;
+            }
+            if (right < n && keys_[heap_[right]] < keys_[heap_[smallest]]) {
+                smallest = right;
+            }
+            if (smallest == p) {
+                break;
+            }
+            swap(p, smallest);
+            p = smallest;
+        }
+    }
+};
+
+#endif //INDEXED_PRIORITY_QUEUE_H
@@ -0,0 +1,116 @@
+#include "instrumentation.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace instrumentation {
+    namespace {
+        std::atomic<ThreadCounters*> threads{nullptr};
+
+        // Start of the tick/steady_clock calibration, taken when the program starts
+        struct Epoch {
+            uint64_t ticks = instrumentation::ticks();
+            std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+        };
+        const Epoch epoch;
+
+        double ns_per_tick() {
+            const uint64_t elapsed_ticks = ticks() - epoch.ticks;
+            const double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - epoch.time).count();
+            return elapsed_ticks > 0 ? elapsed_ns / static_cast<double>(elapsed_ticks) : 1.0;
+        }
+    }
+
+    std::string_view to_string(Phase phase) {
+        switch (phase) {
+            case Phase::PropensityUpdate: return "propensity update";
+            case Phase::Selection: return "selection";
+            case Phase::StateUpdate: return "state update";
+            case Phase::MonitorCallback: return "monitor callbacks";
+            default: return "unknown";
+        }
+    }
+
+    std::string_view to_string(Counter counter) {
+        switch (counter) {
+            case Counter::Events: return "events";
+            case Counter::Rejected: return "rejected steps";
+            case Counter::HeapOperations: return "heap operations";
+            default: return "unknown";
+        }
+    }
+
+    double Snapshot::nanoseconds(Phase phase) const {
+        const auto p = static_cast<size_t>(phase);
+        if (samples[p] == 0) {
+            return 0;
+        }
+        return static_cast<double>(ticks[p]) / static_cast<double>(samples[p]) * static_cast<double>(entries[p]) * ns_per_tick;
+    }
+
+    ThreadCounters& register_thread() {
+        auto* counters = new ThreadCounters;
+        counters->next = threads.load(std::memory_order_relaxed);
+        while (!threads.compare_exchange_weak(counters->next, counters, std::memory_order_release, std::memory_order_relaxed)) {}
+        return *counters;
+    }
+
+    Snapshot snapshot() {
+        Snapshot total;
+        total.ns_per_tick = ns_per_tick();
+        for (auto* counters = threads.load(std::memory_order_acquire); counters != nullptr; counters = counters->next) {
+            ++total.threads;
+            for (size_t p = 0; p < num_phases; ++p) {
+                total.entries[p] += counters->entries[p].load(std::memory_order_relaxed);
+                total.samples[p] += counters->samples[p].load(std::memory_order_relaxed);
+                total.ticks[p] += counters->ticks[p].load(std::memory_order_relaxed);
+            }
+            for (size_t c = 0; c < num_counters; ++c) {
+                total.counts[c] += counters->counts[c].load(std::memory_order_relaxed);
+            }
+        }
+        return total;
+    }
+
+    void reset() {
+        for (auto* counters = threads.load(std::memory_order_acquire); counters != nullptr; counters = counters->next) {
+            for (size_t p = 0; p < num_phases; ++p) {
+                counters->entries[p].store(0, std::memory_order_relaxed);
+                counters->samples[p].store(0, std::memory_order_relaxed);
+                counters->ticks[p].store(0, std::memory_order_relaxed);
+            }
+            for (auto& count : counters->counts) {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void report(std::ostream& os) {
+        if (!enabled) {
+            os << "Instrumentation is disabled, rebuild with -DINSTRUMENTATION=ON" << std::endl;
+            return;
+        }
+
+        const auto total = snapshot();
+        double total_ns = 0;
+        for (size_t p = 0; p < num_phases; ++p) {
+            total_ns += total.nanoseconds(static_cast<Phase>(p));
+        }
+
+        // Formatted apart, so the caller's stream keeps its own flags, precision and adjustment
+        std::ostringstream out;
+        out << "Hot-path phases over " << total.threads << " thread(s), 1 in " << sample_period << " entries timed:\n";
+        for (size_t p = 0; p < num_phases; ++p) {
+            const auto phase = static_cast<Phase>(p);
+            const double ns = total.nanoseconds(phase);
+            out << "  " << std::left << std::setw(20) << to_string(phase) << std::right << std::setw(14) << total.entries[p]
+                << " entries " << std::setw(12) << std::fixed << std::setprecision(3) << ns * 1e-6 << " ms "
+                << std::setw(6) << std::setprecision(1) << (total_ns > 0 ? 100 * ns / total_ns : 0.0) << "%\n";
+        }
+        for (size_t c = 0; c < num_counters; ++c) {
+            out << "  " << std::left << std::setw(20) << to_string(static_cast<Counter>(c)) << std::right
+                << std::setw(14) << total.counts[c] << '\n';
+        }
+        os << out.str() << std::flush;
+    }
+}
@@ -0,0 +1,144 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+// Per-phase counters for the simulation hot paths, switched on at compile time with
+// -DSTOCHASTIC_SIMULATOR_INSTRUMENTATION (CMake option INSTRUMENTATION). When it is off, `ScopedPhase` and `count`
+// are empty inline functions and the engines compile to the same code as without them.
+//
+// When it is on, every thread counts into its own block of relaxed atomics, so the hot path never shares a cache
+// line or takes a lock; `snapshot()` sums the blocks of all threads that ever counted. Phase entries are all
+// counted, but only one in `sample_period` is timed (with the TSC where available, otherwise steady_clock), and the
+// phase time is extrapolated from the samples. That keeps the cost to an increment and a branch per phase.
+//
+//     {
+//         instrumentation::ScopedPhase phase(instrumentation::Phase::Selection);
+//         next = find_min_delay_reaction(reactions);
+//     }
+//     instrumentation::count(instrumentation::Counter::Rejected);
+//     ...
+//     instrumentation::report(std::cout);
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+#if defined(STOCHASTIC_SIMULATOR_INSTRUMENTATION) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+#include "cache_line.h"
+
+namespace instrumentation {
+
+#ifdef STOCHASTIC_SIMULATOR_INSTRUMENTATION
+    inline constexpr bool enabled = true;
+#else
+    inline constexpr bool enabled = false;
+#endif
+
+    enum class Phase { PropensityUpdate, Selection, StateUpdate, MonitorCallback, Count };
+    // Events are fired reactions, Rejected the selected reactions that could not fire, HeapOperations the updates of
+    // the next reaction method's priority queue
+    enum class Counter { Events, Rejected, HeapOperations, Count };
+
+    inline constexpr size_t num_phases = static_cast<size_t>(Phase::Count);
+    inline constexpr size_t num_counters = static_cast<size_t>(Counter::Count);
+    inline constexpr uint64_t sample_period = 64;  // power of two
+
+    std::string_view to_string(Phase phase);
+    std::string_view to_string(Counter counter);
+
+    struct Snapshot {
+        std::array<uint64_t, num_phases> entries{};   // times each phase was entered
+        std::array<uint64_t, num_phases> samples{};   // entries that were timed
+        std::array<uint64_t, num_phases> ticks{};     // ticks spent in the timed entries
+        std::array<uint64_t, num_counters> counts{};
+        size_t threads = 0;                           // threads that have counted
+        double ns_per_tick = 1;
+
+        // Estimated total time in `phase`, over all threads
+        double nanoseconds(Phase phase) const;
+        uint64_t count(Counter counter) const { return counts[static_cast<size_t>(counter)]; }
+    };
+
+    // Sums the counters of all threads. Reads are relaxed, so counts taken while threads are running are close to,
+    // but not exactly, a single point in time.
+    Snapshot snapshot();
+    // Zeroes all counters. Only exact when no thread is counting.
+    void reset();
+    // Text report of `snapshot()`: per phase the entries, estimated time and its share, then the counters
+    void report(std::ostream& os);
+
+    // Counters of one thread, written only by that thread
+    struct ThreadCounters {
+        std::array<std::atomic<uint64_t>, num_phases> entries{};
+        std::array<std::atomic<uint64_t>, num_phases> samples{};
+        std::array<std::atomic<uint64_t>, num_phases> ticks{};
+        std::array<std::atomic<uint64_t>, num_counters> counts{};
+        ThreadCounters* next = nullptr;
+    };
+
+    // Registers a block for the calling thread; blocks outlive their threads, so their counts stay in the totals
+    ThreadCounters& register_thread();
+
+    // A constant-initialized pointer rather than a dynamically initialized reference, so access needs no TLS guard
+    inline ThreadCounters& local() {
+        thread_local ThreadCounters* counters = nullptr;
+        if (counters == nullptr) [[unlikely]] {
+            counters = &register_thread();
+        }
+        return *counters;
+    }
+
+    inline uint64_t ticks() {
+#if defined(STOCHASTIC_SIMULATOR_INSTRUMENTATION) && (defined(__x86_64__) || defined(__i386__))
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+#ifdef STOCHASTIC_SIMULATOR_INSTRUMENTATION
+    inline void count(Counter counter, uint64_t n = 1) {
+        bump(local().counts[static_cast<size_t>(counter)], n);
+    }
+
+    class ScopedPhase {
+    public:
+        explicit ScopedPhase(Phase phase) : phase_(static_cast<size_t>(phase)), counters_(local()) {
+            const uint64_t entries = counters_.entries[phase_].load(std::memory_order_relaxed) + 1;
+            counters_.entries[phase_].store(entries, std::memory_order_relaxed);
+            if ((entries & (sample_period - 1)) == 0) {
+                begin_ = ticks();
+            }
+        }
+
+        ~ScopedPhase() {
+            if (begin_ != 0) {
+                bump(counters_.ticks[phase_], ticks() - begin_);
+                bump(counters_.samples[phase_], 1);
+            }
+        }
+
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    private:
+        size_t phase_;
+        ThreadCounters& counters_;
+        uint64_t begin_ = 0;
+    };
+#else
+    inline void count(Counter, uint64_t = 1) {}
+
+    class ScopedPhase {
+    public:
+        explicit ScopedPhase(Phase) {}
+    };
+#endif
+}
+
+#endif //INSTRUMENTATION_H
@@ -1,7 +1,9 @@
 #ifndef MONITOR_H
 #define MONITOR_H
 
+#include <span>
 #include "../types.h"
+#include "../compiled_network.h"
 
 // Part-solution to requirement 7: Implement a generic support for the state monitor in the stochastic simulation algorithm.
 class Monitor {
@@ -11,4 +13,12 @@ public:
     virtual void operator()(const System& system, double t) = 0;
 };
 
+// Counterpart of `Monitor` for the engines that run on a `CompiledNetwork` state vector instead of a `System`.
+class StateMonitor {
+public:
+    virtual ~StateMonitor() = default;
+
+    virtual void operator()(const CompiledNetwork& network, std::span<const int> state, double t) = 0;
+};
+
 #endif //MONITOR_H
@@ -12,3 +12,13 @@ void SpeciesPeakMonitor::operator()(const System& system, double t) {
         }
     }
 }
+
+void SpeciesPeakMonitor::operator()(const CompiledNetwork& network, std::span<const int> state, double t) {
+    if (targetIndex == SIZE_MAX) {
+        targetIndex = network.speciesIndex(targetSpeciesName);
+    }
+
+    if (state[targetIndex] > *speciesPeak) {
+        *speciesPeak = state[targetIndex];
+    }
+}
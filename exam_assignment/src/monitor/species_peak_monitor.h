@@ -3,19 +3,23 @@
 
 #include <string>
 #include <memory>
+#include <cstdint>
 #include "monitor.h"
 #include "../types.h"
 
-class SpeciesPeakMonitor : public Monitor {
+class SpeciesPeakMonitor : public Monitor, public StateMonitor {
 public:
     std::shared_ptr<double> speciesPeak;
 
     explicit SpeciesPeakMonitor(std::string targetSpeciesName);
 
     void operator()(const System& system, double t) override;
+    void operator()(const CompiledNetwork& network, std::span<const int> state, double t) override;
 
 private:
     std::string targetSpeciesName;
+    // Index of the target species in the compiled network, resolved on the first state callback
+    size_t targetIndex = SIZE_MAX;
 };
 
 #endif  // SPECIES_PEAK_MONITOR_H
@@ -1,23 +1,49 @@
 #include "species_trajectory_monitor.h"
 
-SpeciesTrajectoryMonitor::SpeciesTrajectoryMonitor()
-        : timePoints(std::make_shared<std::vector<double>>()),
-          speciesQuantities(std::make_shared<std::map<Species, std::vector<double>>>()) {}
+#include <memory>
+#include <stdexcept>
+
+SpeciesTrajectoryMonitor::SpeciesTrajectoryMonitor(std::pmr::memory_resource* resource)
+        : timePoints_(resource), rows_(resource) {}
+
+void SpeciesTrajectoryMonitor::useMemoryResource(std::pmr::memory_resource* resource) {
+    if (!timePoints_.empty()) {
+        throw std::logic_error("SpeciesTrajectoryMonitor: the memory resource can only change before the first event");
+    }
+    // A pmr container keeps its resource on assignment, so the vectors are rebuilt in place
+    std::destroy_at(&timePoints_);
+    std::construct_at(&timePoints_, resource);
+    std::destroy_at(&rows_);
+    std::construct_at(&rows_, resource);
+}
 
 void SpeciesTrajectoryMonitor::operator()(const System& system, double t) {
     const auto& allSpecies = system.getSpecies();
 
-    timePoints->push_back(t);
+    if (timePoints_.empty()) {
+        species_.clear();
+        for (const auto& [species, quantity] : allSpecies) {
+            species_.push_back(species);
+        }
+    } else if (allSpecies.size() != species_.size()) {
+        throw std::logic_error("SpeciesTrajectoryMonitor: the system's species changed between events");
+    }
 
+    timePoints_.push_back(t);
+
+    const size_t row = rows_.size();
+    rows_.resize(row + species_.size());
+    double* amounts = rows_.data() + row;
     for (const auto& [species, quantity] : allSpecies) {
-        (*speciesQuantities)[species].push_back(quantity);
+        *amounts++ = quantity;
     }
 }
 
-std::shared_ptr<std::vector<double>> SpeciesTrajectoryMonitor::getTimePoints() {
-    return timePoints;
-}
-
-std::shared_ptr<std::map<Species, std::vector<double>>> SpeciesTrajectoryMonitor::getSpeciesQuantities() {
-    return speciesQuantities;
+std::vector<double> SpeciesTrajectoryMonitor::quantities(size_t index) const {
+    std::vector<double> column;
+    column.reserve(timePoints_.size());
+    for (size_t i = index; i < rows_.size(); i += species_.size()) {
+        column.push_back(rows_[i]);
+    }
+    return column;
 }
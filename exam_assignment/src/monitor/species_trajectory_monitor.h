@@ -1,23 +1,33 @@
 #ifndef SPECIES_TRAJECTORY_MONITOR_H
 #define SPECIES_TRAJECTORY_MONITOR_H
 
-#include <memory>
+#include <memory_resource>
 #include <vector>
-#include <map>
 #include "monitor.h"
 #include "../types.h"
 
+// Records every species' amount at every event. The species are taken from the system on the first call, in the
+// system's (name) order, and each later call appends one row of amounts in that order to a single flat buffer, so an
+// event costs one append per species and no lookups. The buffers are polymorphic allocator vectors, so a replica run
+// by ParallelSimulator keeps its trajectory in the replica's results arena (see `ArenaMonitor`).
 class SpeciesTrajectoryMonitor : public Monitor {
 public:
-    SpeciesTrajectoryMonitor();
+    explicit SpeciesTrajectoryMonitor(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Moves the (still empty) buffers to `resource`
+    void useMemoryResource(std::pmr::memory_resource* resource);
 
     void operator()(const System& system, double t) override;
 
-    std::shared_ptr<std::vector<double>> getTimePoints();
-    std::shared_ptr<std::map<Species, std::vector<double>>> getSpeciesQuantities();
+    [[nodiscard]] const std::vector<Species>& species() const { return species_; }
+    [[nodiscard]] const std::pmr::vector<double>& timePoints() const { return timePoints_; }
+    // Amounts of `species()[index]` at each of the time points
+    [[nodiscard]] std::vector<double> quantities(size_t index) const;
 
-    std::shared_ptr<std::vector<double>> timePoints;
-    std::shared_ptr<std::map<Species, std::vector<double>>> speciesQuantities;
+private:
+    std::vector<Species> species_;
+    std::pmr::vector<double> timePoints_;
+    std::pmr::vector<double> rows_;  // one row of species().size() amounts per time point
 };
 
 #endif //SPECIES_TRAJECTORY_MONITOR_H
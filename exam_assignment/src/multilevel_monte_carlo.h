@@ -0,0 +1,221 @@
+#ifndef MULTILEVEL_MONTE_CARLO_H
+#define MULTILEVEL_MONTE_CARLO_H
+
+// Multilevel Monte Carlo (Giles, 2008; Anderson & Higham, 2012) estimate of E[Q] for a path functional Q, e.g.
+// the peak of hospitalized agents in SEIHR. Level 0 is plain tau-leaping with step h0, level l pairs tau-leap paths
+// with steps h0/M^l and h0/M^(l-1), and the last level pairs the finest tau-leap path with an exact SSA path, so the
+// telescoping sum of the level means is an unbiased estimate of the exact-SSA expectation.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "compiled_network.h"
+#include "thread_pool.h"
+#include "engines/tau_leaping.h"
+#include "monitor/monitor.h"
+
+struct MultilevelOptions {
+    double end_time = 100;
+    double coarsest_step = 1.0;   // h0
+    size_t refinement = 4;        // M, step ratio between consecutive tau-leap levels
+    size_t tau_levels = 3;        // tau-leap levels before the exact correction level
+    size_t pilot_samples = 32;    // samples per level used to estimate variance and cost
+    double target_rmse = 1.0;     // ε, the root-mean-square error we allocate samples for
+    size_t num_threads = 12;
+    unsigned seed = 42;
+};
+
+struct LevelSummary {
+    std::string description;
+    size_t samples = 0;
+    double mean = 0;
+    double variance = 0;
+    double cost = 0;   // seconds per sample
+};
+
+struct MultilevelResult {
+    double estimate = 0;
+    double standard_error = 0;
+    std::vector<LevelSummary> levels;
+};
+
+template<typename MonitorType>
+class MultilevelMonteCarlo {
+public:
+    using MonitorFactory = std::function<std::unique_ptr<MonitorType>()>;
+    using Quantity = std::function<double(const MonitorType&)>;
+
+    MultilevelMonteCarlo(const System& system, MonitorFactory monitor_factory, Quantity quantity, MultilevelOptions options);
+
+    MultilevelResult run();
+
+private:
+    struct LevelStats {
+        size_t n = 0;
+        double sum = 0, sum_sq = 0, seconds = 0;
+
+        double mean() const { return n > 0 ? sum / n : 0.0; }
+        double variance() const { return n > 1 ? std::max(0.0, (sum_sq - sum * sum / n) / (n - 1)) : 0.0; }
+        double cost() const { return n > 0 ? seconds / n : 0.0; }
+    };
+
+    CompiledNetwork network_;
+    MonitorFactory monitor_factory_;
+    Quantity quantity_;
+    MultilevelOptions options_;
+    ThreadPool thread_pool_;
+    std::vector<LevelStats> stats_;
+    size_t batches_ = 0;
+
+    size_t numLevels() const { return options_.tau_levels + 1; }
+    double stepOf(size_t tau_level) const;
+    double sampleLevel(size_t level, unsigned seed);
+    void addSamples(size_t level, size_t count);
+    std::vector<size_t> optimalSamples() const;
+};
+
+template<typename MonitorType>
+MultilevelMonteCarlo<MonitorType>::MultilevelMonteCarlo(const System& system, MonitorFactory monitor_factory, Quantity quantity, MultilevelOptions options)
+        : network_(system), monitor_factory_(std::move(monitor_factory)), quantity_(std::move(quantity)),
+          options_(options), thread_pool_(options.num_threads), stats_(options.tau_levels + 1) {
+    network_.requireNoScheduledEvents("Multilevel Monte Carlo");
+}
+
+template<typename MonitorType>
+double MultilevelMonteCarlo<MonitorType>::stepOf(size_t tau_level) const {
+    return options_.coarsest_step / std::pow(static_cast<double>(options_.refinement), static_cast<double>(tau_level));
+}
+
+// One sample of the level-`level` correction Q_l - Q_(l-1) (or Q_0 on the coarsest level).
+template<typename MonitorType>
+double MultilevelMonteCarlo<MonitorType>::sampleLevel(size_t level, unsigned seed) {
+    auto fine = monitor_factory_();
+
+    if (level == 0) {
+        TauLeapSimulator simulator(network_, options_.end_time, stepOf(0), seed);
+        simulator.simulate(*fine);
+        return quantity_(*fine);
+    }
+
+    auto coarse = monitor_factory_();
+    if (level < options_.tau_levels) {
+        TauLeapSimulator simulator(network_, options_.end_time, stepOf(level), seed);
+        simulator.simulateCoupled(options_.refinement, *fine, *coarse);
+    } else {
+        TauLeapSimulator simulator(network_, options_.end_time, stepOf(level - 1), seed);
+        simulator.simulateCoupledExact(*fine, *coarse);
+    }
+
+    return quantity_(*fine) - quantity_(*coarse);
+}
+
+// Runs `count` more samples on `level`, split into one batch per thread so each pool task is long-lived.
+template<typename MonitorType>
+void MultilevelMonteCarlo<MonitorType>::addSamples(size_t level, size_t count) {
+    const size_t num_batches = std::min(count, options_.num_threads);
+    std::vector<std::future<LevelStats>> futures;
+
+    for (size_t b = 0; b < num_batches; ++b) {
+        const size_t batch_size = count / num_batches + (b < count % num_batches ? 1 : 0);
+        std::seed_seq seq{options_.seed, static_cast<unsigned>(level), static_cast<unsigned>(batches_++)};
+        unsigned batch_seed;
+        seq.generate(&batch_seed, &batch_seed + 1);
+
+        futures.emplace_back(thread_pool_.enqueue([this, level, batch_size, batch_seed] {
+            LevelStats batch;
+            std::mt19937 seeds(batch_seed);
+            auto begin = std::chrono::steady_clock::now();
+
+            for (size_t i = 0; i < batch_size; ++i) {
+                const double y = sampleLevel(level, static_cast<unsigned>(seeds()));
+                ++batch.n;
+                batch.sum += y;
+                batch.sum_sq += y * y;
+            }
+
+            batch.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            return batch;
+        }));
+    }
+
+    for (auto& future : futures) {
+        auto batch = future.get();
+        stats_[level].n += batch.n;
+        stats_[level].sum += batch.sum;
+        stats_[level].sum_sq += batch.sum_sq;
+        stats_[level].seconds += batch.seconds;
+    }
+}
+
+// N_l = ceil(2 ε^-2 sqrt(V_l / C_l) Σ_k sqrt(V_k C_k)), which minimizes total cost subject to Σ V_l / N_l <= ε²/2.
+template<typename MonitorType>
+std::vector<size_t> MultilevelMonteCarlo<MonitorType>::optimalSamples() const {
+    double sum = 0;
+    for (const auto& s : stats_) {
+        sum += std::sqrt(s.variance() * s.cost());
+    }
+
+    const double eps2 = options_.target_rmse * options_.target_rmse;
+    std::vector<size_t> samples;
+    for (const auto& s : stats_) {
+        const double cost = std::max(s.cost(), 1e-9);
+        samples.push_back(static_cast<size_t>(std::ceil(2.0 / eps2 * std::sqrt(s.variance() / cost) * sum)));
+    }
+    return samples;
+}
+
+template<typename MonitorType>
+MultilevelResult MultilevelMonteCarlo<MonitorType>::run() {
+    for (size_t level = 0; level < numLevels(); ++level) {
+        addSamples(level, options_.pilot_samples);
+    }
+
+    // Variance and cost estimates improve as samples arrive, so re-allocate until every level has enough
+    for (int pass = 0; pass < 3; ++pass) {
+        auto wanted = optimalSamples();
+        bool done = true;
+        for (size_t level = 0; level < numLevels(); ++level) {
+            if (wanted[level] > stats_[level].n) {
+                addSamples(level, wanted[level] - stats_[level].n);
+                done = false;
+            }
+        }
+        if (done) {
+            break;
+        }
+    }
+
+    MultilevelResult result;
+    double variance = 0;
+    for (size_t level = 0; level < numLevels(); ++level) {
+        const auto& s = stats_[level];
+        LevelSummary summary;
+        if (level == 0) {
+            summary.description = "tau h=" + std::to_string(stepOf(0));
+        } else if (level < options_.tau_levels) {
+            summary.description = "tau h=" + std::to_string(stepOf(level)) + " - tau h=" + std::to_string(stepOf(level - 1));
+        } else {
+            summary.description = "SSA - tau h=" + std::to_string(stepOf(level - 1));
+        }
+        summary.samples = s.n;
+        summary.mean = s.mean();
+        summary.variance = s.variance();
+        summary.cost = s.cost();
+
+        result.estimate += summary.mean;
+        variance += summary.variance / std::max<size_t>(s.n, 1);
+        result.levels.push_back(summary);
+    }
+    result.standard_error = std::sqrt(variance);
+
+    return result;
+}
+
+#endif //MULTILEVEL_MONTE_CARLO_H
@@ -0,0 +1,433 @@
+#include "network_format.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+NetworkParseError::NetworkParseError(size_t line, size_t column, const std::string& message, const std::string& source)
+        : std::runtime_error((source.empty() ? "" : source + ":") + std::to_string(line) + ":" + std::to_string(column)
+                             + ": " + message),
+          line_(line), column_(column), message_(message) {}
+
+namespace {
+    bool is_name_start(char c) {
+        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+    }
+
+    bool is_name_char(char c) {
+        return is_name_start(c) || (c >= '0' && c <= '9');
+    }
+
+    // Open-addressing table from names to their position in `names`, the declaration-ordered views into the
+    // parsed text. Slots hold only part of the hash and the position, so the table stays small and a lookup costs
+    // about one cache miss in the table plus one in `names`, which is usually near the previous lookup.
+    class NameTable {
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        explicit NameTable(const std::vector<std::string_view>& names) : names_(names) {}
+
+        // Sizes the table for `count` names up front, so it does not have to rehash as they are inserted
+        void reserve(size_t count) {
+            while (slots_.size() < count * 2) {
+                grow();
+            }
+        }
+
+        // Returns the position of `key`, or NONE
+        [[nodiscard]] uint32_t find(std::string_view key) const {
+            if (slots_.empty()) {
+                return NONE;
+            }
+            const uint64_t h = hash(key);
+            for (size_t i = h & mask_;; i = (i + 1) & mask_) {
+                const auto& slot = slots_[i];
+                if (slot.index == NONE) {
+                    return NONE;
+                }
+                if (slot.tag == tag(h) && names_[slot.index] == key) {
+                    return slot.index;
+                }
+            }
+        }
+
+        // Adds `names[index]`; returns false if the name is already present
+        bool insert(uint32_t index) {
+            if ((size_ + 1) * 2 > slots_.size()) {
+                grow();
+            }
+            const uint64_t h = hash(names_[index]);
+            hashes_.push_back(h);
+            size_t i = h & mask_;
+            for (; slots_[i].index != NONE; i = (i + 1) & mask_) {
+                if (slots_[i].tag == tag(h) && names_[slots_[i].index] == names_[index]) {
+                    return false;
+                }
+            }
+            slots_[i] = {tag(h), index};
+            ++size_;
+            return true;
+        }
+
+    private:
+        struct Slot {
+            uint32_t tag = 0;
+            uint32_t index = NONE;
+        };
+        const std::vector<std::string_view>& names_;
+        std::vector<uint64_t> hashes_;  // per position in `names`, for rehashing
+        std::vector<Slot> slots_;
+        size_t size_ = 0, mask_ = 0;
+
+        static uint64_t hash(std::string_view key) {
+            uint64_t h = 14695981039346656037ull;
+            for (unsigned char c : key) {
+                h = (h ^ c) * 1099511628211ull;
+            }
+            // FNV's low bits only depend on the low bits of the input, so finish with a full avalanche (fmix64)
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ull;
+            return h ^ (h >> 33);
+        }
+
+        static uint32_t tag(uint64_t h) {
+            return static_cast<uint32_t>(h >> 32);
+        }
+
+        void grow() {
+            std::vector<Slot> old(std::max<size_t>(16, slots_.size() * 2));
+            old.swap(slots_);
+            mask_ = slots_.size() - 1;
+            for (const auto& slot : old) {
+                if (slot.index != NONE) {
+                    size_t i = hashes_[slot.index] & mask_;
+                    while (slots_[i].index != NONE) {
+                        i = (i + 1) & mask_;
+                    }
+                    slots_[i] = slot;
+                }
+            }
+        }
+    };
+
+    class Parser {
+    public:
+        explicit Parser(std::string_view text) : text_(text) {}
+
+        CompiledNetwork::Definition parse() {
+            // Lines bound the number of reactions and typically the number of species, so size for them once
+            const size_t lines = std::count(text_.begin(), text_.end(), '\n') + 1;
+            species_.reserve(lines);
+            definition_.rates.reserve(lines);
+            definition_.reactant_offsets.reserve(lines + 1);
+            definition_.product_offsets.reserve(lines + 1);
+            while (pos_ < text_.size()) {
+                skipBlanks();
+                if (atEndOfStatement()) {
+                    nextLine();
+                    continue;
+                }
+
+                const size_t start = pos_;
+                const auto word = is_name_start(text_[pos_]) ? name() : std::string_view();
+                skipBlanks();
+                if (word == "param" && pos_ < text_.size() && is_name_start(text_[pos_])) {
+                    parameter();
+                } else if (word == "species" && pos_ < text_.size() && is_name_start(text_[pos_])) {
+                    species();
+                } else {
+                    pos_ = start;
+                    reaction();
+                }
+                endStatement();
+            }
+            return finish();
+        }
+
+    private:
+        std::string_view text_;
+        size_t pos_ = 0, line_ = 1, line_start_ = 0;
+
+        std::vector<std::string_view> names_, param_names_;
+        std::vector<double> param_values_;
+        NameTable species_{names_}, params_{param_names_};
+        CompiledNetwork::Definition definition_;
+
+        [[noreturn]] void fail(size_t at, const std::string& message) const {
+            throw NetworkParseError(line_, at - line_start_ + 1, message);
+        }
+
+        void skipBlanks() {
+            while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\r')) {
+                ++pos_;
+            }
+        }
+
+        [[nodiscard]] bool atEndOfStatement() const {
+            return pos_ >= text_.size() || text_[pos_] == '\n' || text_[pos_] == '#';
+        }
+
+        void nextLine() {
+            while (pos_ < text_.size() && text_[pos_] != '\n') {
+                ++pos_;
+            }
+            if (pos_ < text_.size()) {
+                ++pos_;
+                ++line_;
+                line_start_ = pos_;
+            }
+        }
+
+        void endStatement() {
+            skipBlanks();
+            if (!atEndOfStatement()) {
+                fail(pos_, "unexpected '" + std::string(1, text_[pos_]) + "'");
+            }
+            nextLine();
+        }
+
+        bool accept(char c) {
+            skipBlanks();
+            if (pos_ < text_.size() && text_[pos_] == c) {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(std::string_view token) {
+            skipBlanks();
+            if (text_.substr(pos_, token.size()) != token) {
+                fail(pos_, "expected '" + std::string(token) + "'");
+            }
+            pos_ += token.size();
+        }
+
+        // Identifier, optionally with a region suffix (`S@3`)
+        std::string_view name() {
+            skipBlanks();
+            const size_t start = pos_;
+            if (pos_ >= text_.size() || !is_name_start(text_[pos_])) {
+                fail(pos_, "expected a name");
+            }
+            while (pos_ < text_.size() && is_name_char(text_[pos_])) {
+                ++pos_;
+            }
+            if (pos_ + 1 < text_.size() && text_[pos_] == '@' && is_name_char(text_[pos_ + 1])) {
+                ++pos_;
+                while (pos_ < text_.size() && is_name_char(text_[pos_])) {
+                    ++pos_;
+                }
+            }
+            return text_.substr(start, pos_ - start);
+        }
+
+        double expression() {
+            double value = term();
+            while (true) {
+                if (accept('+')) {
+                    value += term();
+                } else if (accept('-')) {
+                    value -= term();
+                } else {
+                    return value;
+                }
+            }
+        }
+
+        double term() {
+            double value = factor();
+            while (true) {
+                if (accept('*')) {
+                    value *= factor();
+                } else if (accept('/')) {
+                    value /= factor();
+                } else {
+                    return value;
+                }
+            }
+        }
+
+        double factor() {
+            skipBlanks();
+            if (accept('-')) {
+                return -factor();
+            }
+            if (accept('(')) {
+                const double value = expression();
+                expect(")");
+                return value;
+            }
+            if (pos_ < text_.size() && is_name_start(text_[pos_])) {
+                const size_t start = pos_;
+                const auto key = name();
+                const uint32_t index = params_.find(key);
+                if (index == NameTable::NONE) {
+                    fail(start, "unknown parameter '" + std::string(key) + "'");
+                }
+                return param_values_[index];
+            }
+
+            double value = 0;
+            const auto [end, error] = std::from_chars(text_.data() + pos_, text_.data() + text_.size(), value);
+            if (error != std::errc()) {
+                fail(pos_, "expected a number, a parameter or '('");
+            }
+            pos_ = end - text_.data();
+            return value;
+        }
+
+        void parameter() {
+            const size_t start = pos_;
+            const auto key = name();
+            expect("=");
+            const double value = expression();
+            param_names_.push_back(key);
+            if (!params_.insert(static_cast<uint32_t>(param_names_.size() - 1))) {
+                fail(start, "parameter '" + std::string(key) + "' is already defined");
+            }
+            param_values_.push_back(value);
+        }
+
+        void species() {
+            do {
+                skipBlanks();
+                const size_t start = pos_;
+                const auto key = name();
+                int amount = 0;
+                if (accept('=')) {
+                    skipBlanks();
+                    const size_t at = pos_;
+                    const double value = expression();
+                    if (!(value >= 0 && value <= std::numeric_limits<int>::max()) || value != std::round(value)) {
+                        fail(at, "initial amount of '" + std::string(key) + "' must be a non-negative integer");
+                    }
+                    amount = static_cast<int>(value);
+                }
+                names_.push_back(key);
+                if (!species_.insert(static_cast<uint32_t>(names_.size() - 1))) {
+                    fail(start, "species '" + std::string(key) + "' is already declared");
+                }
+                definition_.initial_state.push_back(amount);
+            } while (accept(','));
+        }
+
+        // `0` on its own is the empty complex, the reactants of a source or the products of a sink reaction
+        void complex(std::vector<uint32_t>& out) {
+            skipBlanks();
+            const bool empty = pos_ < text_.size() && text_[pos_] == '0';
+            if (empty && (pos_ + 1 == text_.size() || !is_name_char(text_[pos_ + 1]))) {
+                ++pos_;
+                return;
+            }
+            do {
+                skipBlanks();
+                const size_t start = pos_;
+                const auto key = name();
+                const uint32_t index = species_.find(key);
+                if (index == NameTable::NONE) {
+                    fail(start, "unknown species '" + std::string(key) + "'");
+                }
+                out.push_back(index);
+            } while (accept('+'));
+        }
+
+        void reaction() {
+            complex(definition_.reactants);
+            definition_.reactant_offsets.push_back(static_cast<uint32_t>(definition_.reactants.size()));
+            expect("->");
+            complex(definition_.products);
+            definition_.product_offsets.push_back(static_cast<uint32_t>(definition_.products.size()));
+
+            expect("@");
+            if (pos_ < text_.size() && text_[pos_] != ' ' && text_[pos_] != '\t') {
+                fail(pos_, "expected whitespace after '@'");
+            }
+            skipBlanks();
+            const size_t at = pos_;
+            const double rate = expression();
+            if (!(rate >= 0) || std::isinf(rate)) {
+                fail(at, "rate must be finite and non-negative");
+            }
+            definition_.rates.push_back(rate);
+        }
+
+        CompiledNetwork::Definition finish() {
+            definition_.species_names.assign(names_.begin(), names_.end());
+            return std::move(definition_);
+        }
+    };
+}
+
+CompiledNetwork parse_network(std::string_view text) {
+    return CompiledNetwork(Parser(text).parse());
+}
+
+CompiledNetwork load_network(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open network file " + path.string());
+    }
+    std::string text(std::filesystem::file_size(path), '\0');
+    in.read(text.data(), static_cast<std::streamsize>(text.size()));
+    try {
+        return parse_network(text);
+    } catch (const NetworkParseError& e) {
+        throw NetworkParseError(e.line(), e.column(), e.message(), path.string());
+    }
+}
+
+void write_network(std::ostream& os, const CompiledNetwork& network) {
+    const auto& names = network.speciesNames();
+    for (size_t s = 0; s < network.numSpecies(); ++s) {
+        os << "species " << names[s] << " = " << network.initialState()[s] << '\n';
+    }
+
+    // Products are the reactants plus the net change, listed per species in index order
+    std::vector<int> count(network.numSpecies(), 0);
+    const auto precision = os.precision(std::numeric_limits<double>::max_digits10);
+    for (size_t r = 0; r < network.numReactions(); ++r) {
+        const auto reactants = network.reactants(r);
+        const auto species = network.changedSpecies(r);
+        const auto deltas = network.changeDeltas(r);
+        for (auto s : reactants) {
+            ++count[s];
+        }
+        for (size_t i = 0; i < species.size(); ++i) {
+            count[species[i]] += deltas[i];
+        }
+
+        const char* separator = "";
+        for (auto s : reactants) {
+            os << separator << names[s];
+            separator = " + ";
+        }
+        if (reactants.empty()) {
+            os << '0';
+        }
+        os << " ->";
+        separator = " ";
+        auto product = [&](uint32_t s) {
+            for (; count[s] > 0; --count[s]) {
+                os << separator << names[s];
+                separator = " + ";
+            }
+            count[s] = 0;
+        };
+        for (auto s : reactants) {
+            product(s);
+        }
+        for (auto s : species) {
+            product(s);
+        }
+        if (std::string_view(separator) == " ") {  // nothing was produced
+            os << " 0";
+        }
+        os << " @ " << network.rate(r) << '\n';
+    }
+    os.precision(precision);
+}
@@ -0,0 +1,51 @@
+#ifndef NETWORK_FORMAT_H
+#define NETWORK_FORMAT_H
+
+#include <filesystem>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "compiled_network.h"
+
+// Plain-text reaction networks, in the notation of the `System` DSL:
+//
+//     # SEIHR, see examples/seihr.cpp
+//     param N = 10000
+//     param gamma = 1 / 3.1
+//     species S = N - 144, E = 135, I = 9
+//     species H, R                      # amount defaults to 0
+//     S + I -> E + I @ 2.4 * gamma / N
+//     E -> I @ 1 / 5.1
+//
+// One statement per line, `#` starts a comment. `param` defines a named constant and `species` declares species
+// with their initial amounts; both take arithmetic expressions (+ - * / and parentheses) over numbers and
+// earlier params. A reaction lists its reactants and products with `+`, one entry per occurrence, and its rate
+// after `@`; `0` stands for no reactants or no products (`0 -> S @ 5`, `S -> 0 @ 0.1`). Names may carry a region
+// suffix such as `S@3`, so the rate `@` must be followed by whitespace.
+//
+// Species are numbered in declaration order and reactions in file order. `write_network` declares the species in
+// index order, so a network written out and loaded again is the same network.
+class NetworkParseError : public std::runtime_error {
+public:
+    // `what()` reads "source:line:column: message", without the source for in-memory text
+    NetworkParseError(size_t line, size_t column, const std::string& message, const std::string& source = "");
+
+    [[nodiscard]] size_t line() const { return line_; }
+    [[nodiscard]] size_t column() const { return column_; }
+    [[nodiscard]] const std::string& message() const { return message_; }
+
+private:
+    size_t line_, column_;
+    std::string message_;
+};
+
+// Single pass over the text straight into the index form; names are resolved as string views into `text`.
+CompiledNetwork parse_network(std::string_view text);
+CompiledNetwork load_network(const std::filesystem::path& path);
+
+// Writes `network` back in the text format, with rates printed exactly. Scheduled events are not part of the format.
+void write_network(std::ostream& os, const CompiledNetwork& network);
+
+#endif //NETWORK_FORMAT_H
@@ -0,0 +1,143 @@
+#include "network_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace {
+    // Appends one reaction to a definition under construction
+    void add_reaction(CompiledNetwork::Definition& definition, std::initializer_list<uint32_t> reactants,
+                      std::initializer_list<uint32_t> products, double rate) {
+        definition.reactants.insert(definition.reactants.end(), reactants);
+        definition.reactant_offsets.push_back(static_cast<uint32_t>(definition.reactants.size()));
+        definition.products.insert(definition.products.end(), products);
+        definition.product_offsets.push_back(static_cast<uint32_t>(definition.products.size()));
+        definition.rates.push_back(rate);
+    }
+
+    uint32_t add_species(CompiledNetwork::Definition& definition, std::string name, int amount) {
+        definition.species_names.push_back(std::move(name));
+        definition.initial_state.push_back(amount);
+        return static_cast<uint32_t>(definition.species_names.size() - 1);
+    }
+
+    // 10^(-spread * u), u uniform on [0, 1)
+    double spread_factor(std::mt19937_64& generator, double spread) {
+        return std::pow(10.0, -spread * std::uniform_real_distribution<double>(0.0, 1.0)(generator));
+    }
+}
+
+CompiledNetwork scale_free_network(const NetworkShape& shape) {
+    std::mt19937_64 generator(shape.seed);
+    CompiledNetwork::Definition definition;
+    const size_t num_species = std::max<size_t>(shape.species, 2);
+    for (size_t s = 0; s < num_species; ++s) {
+        add_species(definition, "X" + std::to_string(s), shape.initial_amount);
+    }
+
+    // Every species appears degree + 1 times, so a uniform pick is preferential attachment
+    std::vector<uint32_t> attachment(num_species);
+    for (uint32_t s = 0; s < num_species; ++s) {
+        attachment[s] = s;
+    }
+    auto pick = [&generator, &attachment] {
+        return attachment[std::uniform_int_distribution<size_t>(0, attachment.size() - 1)(generator)];
+    };
+    auto pick_other = [&pick](uint32_t other) {
+        uint32_t s = pick();
+        while (s == other) {
+            s = pick();
+        }
+        return s;
+    };
+
+    // Bimolecular rates are scaled down by the amount so both kinds have comparable propensities
+    const double bimolecular = 1.0 / std::max(shape.initial_amount, 1);
+    std::bernoulli_distribution is_exchange(0.5);
+    for (size_t r = 0; r < shape.reactions; ++r) {
+        const double spread = spread_factor(generator, shape.rate_spread);
+        if (is_exchange(generator)) {
+            const uint32_t a = pick(), b = pick_other(a), c = pick(), d = pick_other(c);
+            add_reaction(definition, {a, b}, {c, d}, bimolecular * spread);
+            attachment.insert(attachment.end(), {a, b, c, d});
+        } else {
+            const uint32_t a = pick(), b = pick_other(a);
+            add_reaction(definition, {a}, {b}, spread);
+            attachment.insert(attachment.end(), {a, b});
+        }
+    }
+    return CompiledNetwork(std::move(definition));
+}
+
+CompiledNetwork metapopulation_seihr(size_t regions, uint32_t population, double travel_rate, unsigned seed) {
+    // The parameters of examples/seihr.cpp
+    const double eps = 0.0009;
+    const int I0 = static_cast<int>(std::round(eps * population));
+    const int E0 = static_cast<int>(std::round(eps * population * 15));
+    const double gamma = 1.0 / 3.1, alpha = 1.0 / 5.1, beta = 2.4 * gamma;
+    const double P_H = 0.9e-3, kappa = gamma * P_H * (1.0 - P_H), tau = 1.0 / 10.12;
+
+    std::mt19937_64 generator(seed);
+    CompiledNetwork::Definition definition;
+    enum { S, E, I, H, R };
+    auto species = [](size_t region, int compartment) {
+        return static_cast<uint32_t>(region * 5 + compartment);
+    };
+    for (size_t k = 0; k < regions; ++k) {
+        const auto suffix = "@" + std::to_string(k);
+        add_species(definition, "S" + suffix, static_cast<int>(population) - I0 - E0);
+        add_species(definition, "E" + suffix, E0);
+        add_species(definition, "I" + suffix, I0);
+        add_species(definition, "H" + suffix, 0);
+        add_species(definition, "R" + suffix, 0);
+    }
+
+    for (size_t k = 0; k < regions; ++k) {
+        add_reaction(definition, {species(k, S), species(k, I)}, {species(k, E), species(k, I)}, beta / population);
+        add_reaction(definition, {species(k, E)}, {species(k, I)}, alpha);
+        add_reaction(definition, {species(k, I)}, {species(k, R)}, gamma);
+        add_reaction(definition, {species(k, I)}, {species(k, H)}, kappa);
+        add_reaction(definition, {species(k, H)}, {species(k, R)}, tau);
+
+        const size_t next = (k + 1) % regions;
+        const size_t far = std::uniform_int_distribution<size_t>(0, regions - 1)(generator);
+        for (const int compartment : {S, E, I, R}) {
+            add_reaction(definition, {species(k, compartment)}, {species(next, compartment)}, travel_rate);
+            add_reaction(definition, {species(k, compartment)}, {species(far, compartment)}, travel_rate);
+        }
+    }
+    return CompiledNetwork(std::move(definition));
+}
+
+CompiledNetwork gene_cascade(size_t genes, double rate_spread, unsigned seed) {
+    std::mt19937_64 generator(seed);
+    CompiledNetwork::Definition definition;
+    const uint32_t environment = add_species(definition, "environment", 0);
+
+    uint32_t previous_protein = 0;
+    for (size_t i = 0; i < genes; ++i) {
+        const auto suffix = std::to_string(i);
+        const uint32_t gene = add_species(definition, "G" + suffix, i == 0 ? 0 : 1);
+        const uint32_t active = add_species(definition, "Ga" + suffix, i == 0 ? 1 : 0);
+        const uint32_t mrna = add_species(definition, "M" + suffix, 0);
+        const uint32_t protein = add_species(definition, "P" + suffix, 0);
+
+        // Rates in the range of the circadian oscillator, scaled per gene
+        const double scale = spread_factor(generator, rate_spread);
+        if (i == 0) {
+            // Nothing activates gene 0, and it never switches off
+            add_reaction(definition, {gene}, {active}, 0);
+            add_reaction(definition, {active}, {gene}, 0);
+        } else {
+            add_reaction(definition, {previous_protein, gene}, {active}, 1.0 * scale);
+            add_reaction(definition, {active}, {gene, previous_protein}, 50.0 * scale);
+        }
+        add_reaction(definition, {active}, {active, mrna}, 50.0 * scale);
+        add_reaction(definition, {mrna}, {mrna, protein}, 10.0 * scale);
+        add_reaction(definition, {mrna}, {environment}, 10.0 * scale);
+        add_reaction(definition, {protein}, {environment}, 1.0 * scale);
+        previous_protein = protein;
+    }
+    return CompiledNetwork(std::move(definition));
+}
@@ -0,0 +1,38 @@
+#ifndef NETWORK_GENERATOR_H
+#define NETWORK_GENERATOR_H
+
+#include <cstdint>
+
+#include "compiled_network.h"
+
+// Synthetic mass-action networks for validating the engines at scale. The generators build the index form
+// directly, so networks with millions of reactions take about a second, and all of them are deterministic in the
+// seed.
+
+struct NetworkShape {
+    size_t species = 1000;
+    size_t reactions = 10000;
+    double rate_spread = 0;    // rate constants are log-uniform over this many decades below their base value
+    int initial_amount = 100;  // per species
+    unsigned seed = 1;
+};
+
+// Random reaction graph with a scale-free degree distribution: reactants and products are picked by preferential
+// attachment, so a few hub species take part in many reactions (as ATP or NADH do in metabolic networks) and most
+// in one or two. Reactions are conversions `A -> B` and exchanges `A + B -> C + D`, which conserve the number of
+// molecules, so the network stays active for any simulated time.
+CompiledNetwork scale_free_network(const NetworkShape& shape);
+
+// SEIHR (as in examples/seihr.cpp) in `regions` regions of `population` each, seeded in every region. Regions lie
+// on a ring and each also has one random long-range link; S, E, I and R travel along both at `travel_rate`.
+// Names carry the region as a suffix (`S@3`). 5 species and 13 reactions per region.
+CompiledNetwork metapopulation_seihr(size_t regions, uint32_t population, double travel_rate, unsigned seed);
+
+// Chain of `genes` genes where each protein activates the next gene's promoter:
+//     P(i-1) + G(i) -> Ga(i),  Ga(i) -> G(i) + P(i-1),  Ga(i) -> Ga(i) + M(i),  M(i) -> M(i) + P(i),
+//     M(i) -> environment,  P(i) -> environment
+// Gene 0 is always active. Per-gene rates are log-uniform over `rate_spread` decades, which spreads the
+// propensities of the cascade over that many orders of magnitude. 4 species and 6 reactions per gene.
+CompiledNetwork gene_cascade(size_t genes, double rate_spread, unsigned seed);
+
+#endif //NETWORK_GENERATOR_H
@@ -0,0 +1,233 @@
+#include "compiled_network.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Image layout (native byte order, all offsets relative to the start of the file):
+//
+//     Header                       magic, version, byte order mark, counts, offset and size of every section
+//     names          char[]        species names back to back, without terminators
+//     name_offsets   uint64[S+1]   start of each name in `names`
+//     initial_state  int32[S]
+//     rates          double[R]
+//     reactant_offsets, reactant_species, change_offsets, change_species, change_deltas,
+//     dependent_offsets, dependent_reactions, reader_offsets, reader_reactions
+//                                  the CSR arrays exactly as CompiledNetwork holds them
+//     events         PackedEvent[E]
+//
+// Every section starts on a 64-byte boundary, so the arrays can be used in place from a page-aligned mapping.
+namespace {
+    constexpr char MAGIC[8] = {'S', 'S', 'A', 'N', 'E', 'T', '\0', '\0'};
+    constexpr uint32_t VERSION = 1;
+    constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    constexpr uint64_t ALIGNMENT = 64;
+
+    enum Section : uint32_t {
+        Names, NameOffsets, InitialState, Rates,
+        ReactantOffsets, ReactantSpecies, ChangeOffsets, ChangeSpecies, ChangeDeltas,
+        DependentOffsets, DependentReactions, ReaderOffsets, ReaderReactions,
+        Events, NUM_SECTIONS
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t num_species, num_reactions, num_events;
+        struct {
+            uint64_t offset, size;  // in bytes
+        } sections[NUM_SECTIONS];
+    };
+
+    // ScheduledEvent without padding, so images are byte-for-byte reproducible
+    struct PackedEvent {
+        double time;
+        double value;
+        uint32_t target;
+        uint32_t injection;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header> && sizeof(PackedEvent) == 24);
+
+    uint64_t align(uint64_t offset) {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    [[noreturn]] void fail(const std::filesystem::path& path, const std::string& message) {
+        throw std::runtime_error("Network image " + path.string() + ": " + message);
+    }
+
+    struct ImageReader {
+        const std::filesystem::path& path;
+        const char* base;
+        size_t length;
+        const Header& header;
+
+        // Checks a section against the file and the expected element count, and views it in place. The count is
+        // bounded by the file before it is multiplied, so a corrupt count cannot wrap around to a small size.
+        template <typename T>
+        std::span<const T> section(Section id, uint64_t count) const {
+            const auto& [offset, size] = header.sections[id];
+            if (offset % ALIGNMENT != 0 || offset > length || count > (length - offset) / sizeof(T)
+                    || size > length - offset || size != count * sizeof(T)) {
+                fail(path, "section " + std::to_string(id) + " does not match the header");
+            }
+            return {reinterpret_cast<const T*>(base + offset), static_cast<size_t>(count)};
+        }
+
+        // CSR offsets for `rows` rows, which must start at 0 and never decrease, and the indices they delimit, which
+        // must all be below `limit`; their last offset is the length of the index array. Checked once here in
+        // O(rows + indices), so the engines can index with them unchecked.
+        std::pair<std::span<const uint32_t>, std::span<const uint32_t>> csr(Section offsets_id, Section values_id,
+                                                                            uint64_t rows, uint64_t limit) const {
+            const auto offsets = section<uint32_t>(offsets_id, rows + 1);
+            if (offsets.front() != 0 || !std::ranges::is_sorted(offsets)) {
+                fail(path, "section " + std::to_string(offsets_id) + " is not a valid offset table");
+            }
+            const auto values = section<uint32_t>(values_id, offsets.back());
+            if (std::ranges::any_of(values, [limit](uint32_t index) { return index >= limit; })) {
+                fail(path, "section " + std::to_string(values_id) + " refers to an index out of range");
+            }
+            return {offsets, values};
+        }
+    };
+}
+
+void CompiledNetwork::saveImage(const std::filesystem::path& path) const {
+    std::string names;
+    std::vector<uint64_t> name_offsets{0};
+    for (const auto& name : species_names_) {
+        names += name;
+        name_offsets.push_back(names.size());
+    }
+    std::vector<PackedEvent> events;
+    for (const auto& event : scheduled_events_) {
+        events.push_back({event.time, event.value, event.target, event.injection ? 1u : 0u});
+    }
+
+    const std::pair<const void*, uint64_t> contents[NUM_SECTIONS] = {
+        {names.data(), names.size()},
+        {name_offsets.data(), name_offsets.size() * sizeof(uint64_t)},
+        {initial_state_.data(), initial_state_.size() * sizeof(int)},
+        {rates_.data(), rates_.size_bytes()},
+        {reactant_offsets_.data(), reactant_offsets_.size_bytes()},
+        {reactant_species_.data(), reactant_species_.size_bytes()},
+        {change_offsets_.data(), change_offsets_.size_bytes()},
+        {change_species_.data(), change_species_.size_bytes()},
+        {change_deltas_.data(), change_deltas_.size_bytes()},
+        {dependent_offsets_.data(), dependent_offsets_.size_bytes()},
+        {dependent_reactions_.data(), dependent_reactions_.size_bytes()},
+        {reader_offsets_.data(), reader_offsets_.size_bytes()},
+        {reader_reactions_.data(), reader_reactions_.size_bytes()},
+        {events.data(), events.size() * sizeof(PackedEvent)},
+    };
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.num_species = numSpecies();
+    header.num_reactions = numReactions();
+    header.num_events = events.size();
+    uint64_t offset = align(sizeof(Header));
+    for (uint32_t i = 0; i < NUM_SECTIONS; ++i) {
+        header.sections[i] = {offset, contents[i].second};
+        offset = align(offset + contents[i].second);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        fail(path, "cannot open for writing");
+    }
+    const char padding[ALIGNMENT] = {};
+    uint64_t written = 0;
+    auto write = [&](const void* data, uint64_t size) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        written += size;
+        out.write(padding, static_cast<std::streamsize>(align(written) - written));
+        written = align(written);
+    };
+    write(&header, sizeof(Header));
+    for (const auto& [data, size] : contents) {
+        write(data, size);
+    }
+    if (!out) {
+        fail(path, "write failed");
+    }
+}
+
+CompiledNetwork CompiledNetwork::mapImage(const std::filesystem::path& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        fail(path, "cannot open");
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        fail(path, "too small to be a network image");
+    }
+    const auto length = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        fail(path, "mmap failed");
+    }
+
+    CompiledNetwork network;
+    network.image_ = std::shared_ptr<const void>(address, [length](const void* p) {
+        munmap(const_cast<void*>(p), length);
+    });
+    const auto* base = static_cast<const char*>(address);
+    const auto& header = *reinterpret_cast<const Header*>(base);
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+        fail(path, "not a network image of version " + std::to_string(VERSION));
+    }
+    if (header.byte_order != BYTE_ORDER_MARK) {
+        fail(path, "written with a different byte order");
+    }
+
+    // Species and reactions are indexed with uint32_t, which also keeps `S + 1` and `R + 1` from wrapping
+    const uint64_t S = header.num_species, R = header.num_reactions;
+    if (S >= UINT32_MAX || R >= UINT32_MAX) {
+        fail(path, "species or reaction count out of range");
+    }
+    const ImageReader image{path, base, length, header};
+
+    const auto name_offsets = image.section<uint64_t>(NameOffsets, S + 1);
+    const auto names = image.section<char>(Names, name_offsets.back());
+    network.species_names_.reserve(S);
+    for (uint64_t s = 0; s < S; ++s) {
+        if (name_offsets[s] > name_offsets[s + 1] || name_offsets[s + 1] > names.size()) {
+            fail(path, "corrupt species names");
+        }
+        network.species_names_.emplace_back(names.data() + name_offsets[s], name_offsets[s + 1] - name_offsets[s]);
+    }
+    const auto initial_state = image.section<int>(InitialState, S);
+    network.initial_state_.assign(initial_state.begin(), initial_state.end());
+
+    network.rates_ = image.section<double>(Rates, R);
+    std::tie(network.reactant_offsets_, network.reactant_species_) = image.csr(ReactantOffsets, ReactantSpecies, R, S);
+    std::tie(network.change_offsets_, network.change_species_) = image.csr(ChangeOffsets, ChangeSpecies, R, S);
+    network.change_deltas_ = image.section<int>(ChangeDeltas, network.change_species_.size());
+    std::tie(network.dependent_offsets_, network.dependent_reactions_) = image.csr(DependentOffsets, DependentReactions, R, R);
+    std::tie(network.reader_offsets_, network.reader_reactions_) = image.csr(ReaderOffsets, ReaderReactions, S, R);
+
+    for (const auto& event : image.section<PackedEvent>(Events, header.num_events)) {
+        if (event.target >= (event.injection != 0 ? S : R) || !std::isfinite(event.time) || !std::isfinite(event.value)) {
+            fail(path, "scheduled event out of range");
+        }
+        network.scheduled_events_.push_back({event.time, event.target, event.injection != 0, event.value});
+    }
+    return network;
+}
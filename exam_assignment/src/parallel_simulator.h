@@ -4,60 +4,201 @@
 // Part-solution to requirement 8: Implement support for multiple computer cores by parallelizing the computation of
 // several simulations at the same time.
 
+#include <chrono>
+#include <concepts>
+#include <exception>
+#include <stop_token>
 #include <vector>
 #include <functional>
 #include <memory>
+#include <memory_resource>
+#include <optional>
+#include "arena.h"
 #include "stochastic_simulator.h"
 #include "thread_pool.h"
+#include "telemetry.h"
 #include "monitor/monitor.h"
 
+struct JobOptions {
+    Priority priority = Priority::Batch;
+    // Cancels the job: running replicas stop at their next check, and those not started yet never start
+    std::stop_token stop;
+    // Wall-clock budget of the whole job, counted from the `simulate()` call; stops it as a cancellation would
+    std::optional<std::chrono::steady_clock::duration> deadline;
+};
+
+// How the replicas of a job ended. Replicas that were stopped keep the partial results in their monitor.
+struct JobReport {
+    size_t completed = 0, cancelled = 0, expired = 0;
+    size_t not_started = 0;   // these have no monitor
+
+    [[nodiscard]] bool finished() const { return cancelled == 0 && expired == 0 && not_started == 0; }
+};
+
+// Monitors that keep growing buffers can take them from the replica's results arena, which lives until the next
+// `simulate()` call. Called on the worker, before the replica runs.
+template<typename MonitorType>
+concept ArenaMonitor = requires(MonitorType& monitor, std::pmr::memory_resource* resource) {
+    monitor.useMemoryResource(resource);
+};
+
+// Every replica runs with a leased pair of arenas (see arena.h): the simulator's working storage comes from the
+// scratch arena, and `ArenaMonitor`s allocate from the results arena.
+//
+// Replicas are dealt out to the NUMA nodes round-robin and run on a pool slot of their own node while one is free
+// (see ThreadPool). Since they are enqueued in index order, every node gets work from the start, and a job that
+// stops early has used all nodes rather than only the first ones. With a placement that pins the workers, a
+// replica's system is built by its worker, so its memory is first touched on that worker's node; the system factory
+// must then be safe to call concurrently.
+//
+// Simulators that share a pool compete for its slots by the priority of their jobs, so an interactive job started
+// while a batch sweep runs gets the next slots that free up.
 template<typename MonitorType>
 class ParallelSimulator {
 public:
     using SystemFactory = std::function<System()>;
     using MonitorFactory = std::function<std::unique_ptr<MonitorType>()>;
 
-    ParallelSimulator(SystemFactory system_factory, MonitorFactory monitor_factory, double end_time, size_t num_sims, size_t num_threads);
+    // With `telemetry`, every replica reports its events and progress there, counted against the pool slot that
+    // runs it
+    ParallelSimulator(SystemFactory system_factory, MonitorFactory monitor_factory, double end_time, size_t num_sims, size_t num_threads,
+                      Telemetry* telemetry = nullptr, PoolOptions pool_options = {});
+    // Runs on a pool shared with other simulators, with one worker slot per pool slot
+    ParallelSimulator(SystemFactory system_factory, MonitorFactory monitor_factory, double end_time, size_t num_sims,
+                      std::shared_ptr<ThreadPool> pool, Telemetry* telemetry = nullptr);
 
-    void simulate();
+    JobReport simulate(const JobOptions& job = {});
 
+    // One per started replica, in replica order, with how it ended alongside
     const std::vector<std::unique_ptr<MonitorType>>& getMonitors() const;
+    const std::vector<RunStatus>& getStatuses() const { return statuses_; }
+
+    // Heap allocations the arenas could not serve; stops growing once the arenas have reached their high-water marks
+    [[nodiscard]] size_t arenaOverflows() const { return arenas_.overflows(); }
 
 private:
     SystemFactory system_factory_;
     MonitorFactory monitor_factory_;
     double end_time_;
     size_t num_sims_;
-    ThreadPool thread_pool_;
+    size_t num_threads_;
+    Telemetry* telemetry_;
+    std::shared_ptr<ThreadPool> thread_pool_;
+    // Before the monitors, which may hold memory from the results arenas
+    ArenaPool arenas_;
     std::vector<std::unique_ptr<MonitorType>> monitors_;
+    std::vector<RunStatus> statuses_;
 };
 
 template<typename MonitorType>
-ParallelSimulator<MonitorType>::ParallelSimulator(SystemFactory system_factory, MonitorFactory monitor_factory, double end_time, size_t num_sims, size_t num_threads)
-        : system_factory_(std::move(system_factory)), monitor_factory_(std::move(monitor_factory)), end_time_(end_time), num_sims_(num_sims), thread_pool_(num_threads) {
+ParallelSimulator<MonitorType>::ParallelSimulator(SystemFactory system_factory, MonitorFactory monitor_factory, double end_time, size_t num_sims, size_t num_threads,
+                                                  Telemetry* telemetry, PoolOptions pool_options)
+        : system_factory_(std::move(system_factory)), monitor_factory_(std::move(monitor_factory)), end_time_(end_time), num_sims_(num_sims),
+          num_threads_(num_threads), telemetry_(telemetry),
+          thread_pool_(std::make_shared<ThreadPool>(num_threads, std::move(pool_options))), arenas_(num_threads) {
             monitors_.reserve(num_sims);
         }
 
 template<typename MonitorType>
-void ParallelSimulator<MonitorType>::simulate() {
+ParallelSimulator<MonitorType>::ParallelSimulator(SystemFactory system_factory, MonitorFactory monitor_factory, double end_time, size_t num_sims,
+                                                  std::shared_ptr<ThreadPool> pool, Telemetry* telemetry)
+        : system_factory_(std::move(system_factory)), monitor_factory_(std::move(monitor_factory)), end_time_(end_time), num_sims_(num_sims),
+          num_threads_(pool->concurrency()), telemetry_(telemetry), thread_pool_(std::move(pool)), arenas_(num_threads_) {
+            monitors_.reserve(num_sims);
+        }
+
+template<typename MonitorType>
+JobReport ParallelSimulator<MonitorType>::simulate(const JobOptions& job) {
     std::vector<std::future<void>> futures;
     monitors_.clear();
+    arenas_.resetResults();
+    // Sized up front: the workers write their own entry while later replicas are still being enqueued
+    statuses_.assign(num_sims_, RunStatus::Completed);
+    if (telemetry_) {
+        telemetry_->expectReplicas(num_sims_);
+    }
+
+    RunLimits limits{job.stop};
+    if (job.deadline) {
+        limits.deadline = RunLimits::Clock::now() + *job.deadline;
+    }
 
-    for (size_t i = 0; i < num_sims_; ++i) {
-        monitors_.emplace_back(monitor_factory_());
+    JobReport report;
+    size_t started = 0;
+    // Every task refers to `limits` and `statuses_` in this frame, so an error (from a factory, an enqueue or a
+    // replica) is only rethrown once all the tasks that did start have finished
+    std::exception_ptr error;
+    try {
+        for (; started < num_sims_; ++started) {
+            // Checked before every enqueue, which waits for a free slot, so a stopped job gives its slots back at the
+            // next task boundary
+            if (limits.expired() != RunStatus::Completed) {
+                break;
+            }
+            const size_t i = started;
+            monitors_.emplace_back(monitor_factory_());
 
-        System system = system_factory_();
+            std::optional<System> system;
+            if (!thread_pool_->pinned()) {
+                system = system_factory_();
+            }
 
-        auto monitor = monitors_.back().get();
-        futures.emplace_back(thread_pool_.enqueue([this, system = std::move(system), monitor] {
-            Simulator simulator(std::move(system), end_time_);
-            simulator.simulate(*monitor);
-        }));
+            auto monitor = monitors_.back().get();
+            const size_t node = i % thread_pool_->nodes();
+            futures.emplace_back(thread_pool_->enqueue_on(node, job.priority, [this, system = std::move(system), monitor, &limits, i]() mutable {
+                if (telemetry_) {
+                    telemetry_->replicaStarted();
+                }
+                // A replica stopped while it waited for its slot does not run at all
+                statuses_[i] = limits.expired();
+                if (statuses_[i] == RunStatus::Completed) {
+                    auto arenas = arenas_.acquire(ThreadPool::current_slot());
+                    if constexpr (ArenaMonitor<MonitorType>) {
+                        monitor->useMemoryResource(arenas.results());
+                    }
+                    Simulator simulator(system ? std::move(*system) : system_factory_(), end_time_,
+                                        Simulator::clock_seed(), arenas.scratch());
+                    // Counted against the slot that runs the replica, which is not tied to `i`
+                    const size_t worker = ThreadPool::current_slot();
+                    // The monitor itself, not a copy, keeps the results
+                    statuses_[i] = telemetry_ ? simulator.simulate(count_events(*telemetry_, worker, *monitor), limits)
+                                              : simulator.simulate(std::ref(*monitor), limits);
+                }
+                if (telemetry_) {
+                    telemetry_->replicaCompleted();
+                }
+            }));
+        }
+    } catch (...) {
+        error = std::current_exception();
     }
 
     for (auto& future : futures) {
-        future.get();
+        try {
+            future.get();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    statuses_.resize(started);
+    report.not_started = num_sims_ - started;
+    if (telemetry_ && report.not_started > 0) {
+        telemetry_->dropReplicas(report.not_started);
+    }
+    for (auto status : statuses_) {
+        switch (status) {
+            case RunStatus::Completed: ++report.completed; break;
+            case RunStatus::Cancelled: ++report.cancelled; break;
+            default: ++report.expired;
+        }
     }
+    return report;
 }
 
 template<typename MonitorType>
@@ -0,0 +1,149 @@
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstdint>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::string_view to_string(PerfEvent event) {
+    switch (event) {
+        case PerfEvent::Cycles: return "cycles";
+        case PerfEvent::Instructions: return "instructions";
+        case PerfEvent::LlcMisses: return "LLC misses";
+        case PerfEvent::BranchMisses: return "branch misses";
+        case PerfEvent::DtlbMisses: return "dTLB misses";
+        default: return "unknown";
+    }
+}
+
+PerfSample PerfSample::per(double n) const {
+    PerfSample sample;
+    std::transform(values.begin(), values.end(), sample.values.begin(), [n](double x) { return x / n; });
+    return sample;
+}
+
+std::ostream& operator<<(std::ostream& os, const PerfSample& sample) {
+    for (size_t i = 0; i < num_perf_events; ++i) {
+        const auto event = static_cast<PerfEvent>(i);
+        os << (i > 0 ? ", " : "") << to_string(event) << ' ';
+        if (std::isnan(sample.values[i])) {
+            os << "n/a";
+        } else {
+            os << sample.values[i];
+        }
+        if (event == PerfEvent::Instructions && !std::isnan(sample.ipc())) {
+            os << " (IPC " << sample.ipc() << ')';
+        }
+    }
+    return os;
+}
+
+#ifdef __linux__
+namespace {
+    perf_event_attr attributes(PerfEvent event) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.inherit = 1;          // count the threads started while the counters are open
+        attr.exclude_kernel = 1;   // allowed at perf_event_paranoid 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        auto cache = [](uint64_t cache, uint64_t op, uint64_t result) { return cache | op << 8 | result << 16; };
+        switch (event) {
+            case PerfEvent::Cycles:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PerfEvent::Instructions:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PerfEvent::LlcMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            case PerfEvent::BranchMisses:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            case PerfEvent::DtlbMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            default:
+                break;
+        }
+        return attr;
+    }
+}
+
+PerfCounters::PerfCounters() {
+    fds_.fill(-1);
+    for (size_t i = 0; i < num_perf_events; ++i) {
+        auto attr = attributes(static_cast<PerfEvent>(i));
+        fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fds_[i] < 0 && why_.empty()) {
+            why_ = std::string("perf_event_open(") + std::string(to_string(static_cast<PerfEvent>(i))) + "): " + std::strerror(errno);
+        }
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+void PerfCounters::start() {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+PerfSample PerfCounters::stop() {
+    PerfSample sample;
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (size_t i = 0; i < num_perf_events; ++i) {
+        // value, time enabled, time running
+        uint64_t data[3] = {};
+        if (fds_[i] < 0 || read(fds_[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+            continue;
+        }
+        sample.values[i] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+    }
+    return sample;
+}
+#else
+PerfCounters::PerfCounters() : why_("hardware counters need Linux perf_event_open") {
+    fds_.fill(-1);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+void PerfCounters::start() {}
+
+PerfSample PerfCounters::stop() {
+    return {};
+}
+#endif
+
+bool PerfCounters::available() const {
+    return std::any_of(fds_.begin(), fds_.end(), [](int fd) { return fd >= 0; });
+}
@@ -0,0 +1,63 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// Hardware performance counters (Linux perf_event_open) around a region of code, to tell cache-bound engines from
+// branch-bound ones. Counters are per process: they follow the calling thread and the threads it starts while they
+// are open, e.g. a ThreadPool built inside the region, but not threads that already exist.
+//
+// Collection is best effort. Without Linux, in containers, under `perf_event_paranoid` > 2 or on virtual machines
+// without a PMU the events cannot be opened; `available()` is then false, `why()` tells why, and samples hold NaN,
+// which prints as "n/a". Events that can be opened are kept even if others fail.
+//
+//     PerfCounters counters;
+//     counters.start();
+//     run();
+//     const auto sample = counters.stop();
+//     std::cout << sample << std::endl;
+
+#include <array>
+#include <cmath>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+enum class PerfEvent { Cycles, Instructions, LlcMisses, BranchMisses, DtlbMisses, Count };
+
+inline constexpr size_t num_perf_events = static_cast<size_t>(PerfEvent::Count);
+
+std::string_view to_string(PerfEvent event);
+
+struct PerfSample {
+    std::array<double, num_perf_events> values{NAN, NAN, NAN, NAN, NAN};
+
+    double operator[](PerfEvent event) const { return values[static_cast<size_t>(event)]; }
+    double ipc() const { return (*this)[PerfEvent::Instructions] / (*this)[PerfEvent::Cycles]; }
+    // Every value divided by `n`, e.g. the number of events simulated
+    PerfSample per(double n) const;
+};
+
+// "cycles 1.2e+09, instructions 2.3e+09 (IPC 1.9), LLC misses n/a, ..."
+std::ostream& operator<<(std::ostream& os, const PerfSample& sample);
+
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // True if at least one event could be opened
+    [[nodiscard]] bool available() const;
+    [[nodiscard]] const std::string& why() const { return why_; }
+
+    // Zeroes and enables the counters
+    void start();
+    // Disables the counters and returns their values since `start()`, scaled up if the kernel multiplexed them
+    PerfSample stop();
+
+private:
+    std::array<int, num_perf_events> fds_;
+    std::string why_;
+};
+
+#endif //PERF_COUNTERS_H
@@ -0,0 +1,34 @@
+#include "replicated_network.h"
+
+#include <stdexcept>
+
+ReplicatedNetwork::ReplicatedNetwork(const System& cell, size_t num_instances)
+        : cell_(cell), num_instances_(num_instances) {
+    initial_.reserve(num_instances * cell_.numSpecies());
+    for (size_t i = 0; i < num_instances; ++i) {
+        initial_.insert(initial_.end(), cell_.initialState().begin(), cell_.initialState().end());
+    }
+}
+
+ReplicatedNetwork::Site ReplicatedNetwork::site(size_t instance, const std::string& species) const {
+    if (instance >= num_instances_) {
+        throw std::runtime_error("Instance " + std::to_string(instance) + " does not exist");
+    }
+    return {static_cast<uint32_t>(instance), static_cast<uint32_t>(cell_.speciesIndex(species))};
+}
+
+void ReplicatedNetwork::setAmount(size_t instance, const std::string& species, int amount) {
+    const auto [i, s] = site(instance, species);
+    initial_[i * cell_.numSpecies() + s] = amount;
+}
+
+void ReplicatedNetwork::addCoupling(std::vector<Site> reactants, std::vector<Site> products, double rate) {
+    for (const auto& sites : {reactants, products}) {
+        for (const auto& site : sites) {
+            if (site.instance >= num_instances_ || site.species >= cell_.numSpecies()) {
+                throw std::runtime_error("Coupling refers to a site outside the population");
+            }
+        }
+    }
+    couplings_.push_back({std::move(reactants), std::move(products), rate});
+}
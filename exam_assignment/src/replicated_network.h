@@ -0,0 +1,46 @@
+#ifndef REPLICATED_NETWORK_H
+#define REPLICATED_NETWORK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "compiled_network.h"
+
+// A population of `numInstances()` copies of one template network (e.g. cells each running
+// `circadian_oscillator()`), plus coupling reactions between species of specific instances. The template is
+// compiled once and shared; an instance is only its slice of the instance-major state vector, so memory grows
+// by numSpecies() ints per instance instead of a copy of every reaction and species name.
+class ReplicatedNetwork {
+public:
+    // Species `species` of the template in instance `instance`
+    struct Site {
+        uint32_t instance, species;
+    };
+
+    struct Coupling {
+        std::vector<Site> reactants, products;
+        double rate;
+    };
+
+    ReplicatedNetwork(const System& cell, size_t num_instances);
+
+    [[nodiscard]] const CompiledNetwork& cell() const { return cell_; }
+    [[nodiscard]] size_t numInstances() const { return num_instances_; }
+    [[nodiscard]] const std::vector<int>& initialState() const { return initial_; }
+    [[nodiscard]] const std::vector<Coupling>& couplings() const { return couplings_; }
+
+    [[nodiscard]] Site site(size_t instance, const std::string& species) const;
+    void setAmount(size_t instance, const std::string& species, int amount);
+
+    // Mass-action reaction across instances, e.g. {site(i, "A")} -> {site(j, "A")} for transport from i to j
+    void addCoupling(std::vector<Site> reactants, std::vector<Site> products, double rate);
+
+private:
+    CompiledNetwork cell_;
+    size_t num_instances_;
+    std::vector<int> initial_;
+    std::vector<Coupling> couplings_;
+};
+
+#endif //REPLICATED_NETWORK_H
@@ -0,0 +1,43 @@
+#include "result_sink.h"
+
+#include <numeric>
+#include <stdexcept>
+
+#include "telemetry.h"
+
+size_t SinkStats::buffered() const {
+    return std::accumulate(occupancy.begin(), occupancy.end(), size_t{0});
+}
+
+void SinkStats::writeExposition(std::ostream& os, const SinkStats& stats) {
+    using prometheus::metric;
+    using prometheus::prefix;
+
+    metric(os, "sink_records_pushed_total", "counter", "Result records accepted from the producers.");
+    os << prefix << "sink_records_pushed_total " << stats.pushed << '\n';
+    metric(os, "sink_records_dropped_total", "counter", "Result records dropped on a full ring or a failed write.");
+    os << prefix << "sink_records_dropped_total " << stats.dropped << '\n';
+    metric(os, "sink_producer_waits_total", "counter", "Pushes that found their ring full and waited for the writer.");
+    os << prefix << "sink_producer_waits_total " << stats.waits << '\n';
+    metric(os, "sink_records_written_total", "counter", "Result records handed to the writer.");
+    os << prefix << "sink_records_written_total " << stats.written << '\n';
+    metric(os, "sink_batches_total", "counter", "Batches handed to the writer.");
+    os << prefix << "sink_batches_total " << stats.batches << '\n';
+    metric(os, "sink_ring_occupancy", "gauge", "Result records waiting for the writer, per producer.");
+    for (size_t p = 0; p < stats.occupancy.size(); ++p) {
+        os << prefix << "sink_ring_occupancy{producer=\"" << p << "\"} " << stats.occupancy[p] << '\n';
+    }
+    metric(os, "sink_ring_capacity", "gauge", "Result records each producer's ring holds.");
+    os << prefix << "sink_ring_capacity " << stats.capacity << '\n';
+}
+
+RecordFile::RecordFile(const std::filesystem::path& path)
+        : path_(path), out_(path, std::ios::binary | std::ios::trunc) {
+    if (!out_) {
+        fail();
+    }
+}
+
+void RecordFile::fail() const {
+    throw std::runtime_error("Cannot write record file " + path_.string());
+}
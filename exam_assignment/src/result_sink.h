@@ -0,0 +1,261 @@
+#ifndef RESULT_SINK_H
+#define RESULT_SINK_H
+
+// Persisting results off the simulation threads. Each producer (a ThreadPool slot) pushes fixed-size records into a
+// ring buffer of its own, which only it writes and only the sink's writer thread reads, so a push is a copy and a
+// release store: no lock, no allocation and no cache line shared with another producer. The writer drains all rings
+// round-robin into batches of up to `batch` records and hands each batch to the writer function, e.g. a `RecordFile`
+// or an aggregator, so disk latency shows up in the writer thread and not in the simulations.
+//
+// When a ring is full the producer either waits for the writer (`Overflow::Block`, backpressure) or drops the record
+// (`Overflow::Drop`). Both are counted, next to the records pushed and written and the current ring occupancy, in
+// `stats()`, which can be written in the Prometheus text format next to the telemetry.
+//
+//     RecordFile file("events.bin");
+//     ResultSink<EventRecord> sink(threads, [&file](std::span<const EventRecord> batch) { file.write(batch); });
+//     // in a pool task:
+//     sink.push(ThreadPool::current_slot(), record);
+//     // after the last task:
+//     sink.close();
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cache_line.h"
+
+enum class Overflow {
+    Block,  // the producer waits until the writer has made room
+    Drop    // the record is dropped and counted
+};
+
+struct SinkOptions {
+    size_t capacity = 4096;  // records per producer ring, rounded up to a power of two
+    size_t batch = 1024;     // most records handed to the writer function at once
+    Overflow overflow = Overflow::Block;
+};
+
+struct SinkStats {
+    uint64_t pushed = 0, dropped = 0;
+    uint64_t waits = 0;                  // pushes that found the ring full and waited (Overflow::Block)
+    uint64_t written = 0, batches = 0;
+    std::vector<size_t> occupancy;       // records in each producer's ring
+    size_t capacity = 0;                 // of each ring
+
+    [[nodiscard]] size_t buffered() const;
+
+    static void writeExposition(std::ostream& os, const SinkStats& stats);
+};
+
+// Appends the raw bytes of record batches to a file
+class RecordFile {
+public:
+    explicit RecordFile(const std::filesystem::path& path);
+
+    template<typename Record>
+    void write(std::span<const Record> records) {
+        static_assert(std::is_trivially_copyable_v<Record>);
+        const auto bytes = std::as_bytes(records);
+        out_.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out_) {
+            fail();
+        }
+    }
+
+    void flush() { out_.flush(); }
+
+private:
+    std::filesystem::path path_;
+    std::ofstream out_;
+
+    [[noreturn]] void fail() const;
+};
+
+template<typename Record>
+class ResultSink {
+    static_assert(std::is_trivially_copyable_v<Record>, "records are copied into and out of the rings as bytes");
+
+public:
+    using Writer = std::function<void(std::span<const Record>)>;
+
+    ResultSink(size_t producers, Writer writer, SinkOptions options = {})
+            : num_rings_(std::max<size_t>(producers, 1))
+            , capacity_(std::bit_ceil(std::max<size_t>(options.capacity, 1)))
+            , batch_size_(std::max<size_t>(options.batch, 1))
+            , overflow_(options.overflow)
+            , rings_(std::make_unique<Ring[]>(num_rings_))
+            , writer_(std::move(writer))
+    {
+        for (size_t i = 0; i < num_rings_; ++i) {
+            rings_[i].slots = std::make_unique<Record[]>(capacity_);
+        }
+        thread_ = std::jthread([this](std::stop_token stop) { drain(stop); });
+    }
+    ResultSink(const ResultSink&) = delete;
+    ResultSink& operator=(const ResultSink&) = delete;
+    // Like `close`, but an exception of the writer function is lost
+    ~ResultSink() = default;
+
+    // Hot path, lock-free. `producer` < `producers`, and no two threads may push as the same producer at once; a
+    // ThreadPool slot satisfies both. Returns false if the record was dropped.
+    bool push(size_t producer, const Record& record) {
+        assert(producer < num_rings_ && "not a producer of this sink; off the pool, current_slot() is SIZE_MAX");
+        auto& ring = rings_[producer];
+        const size_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.cached_tail == capacity_) {
+            ring.cached_tail = ring.tail.load(std::memory_order_acquire);
+            if (head - ring.cached_tail == capacity_) {
+                if (overflow_ == Overflow::Drop) {
+                    bump(ring.dropped);
+                    return false;
+                }
+                bump(ring.waits);
+                for (size_t spins = 0; head - ring.cached_tail == capacity_; ++spins) {
+                    backoff(spins);
+                    ring.cached_tail = ring.tail.load(std::memory_order_acquire);
+                }
+            }
+        }
+        ring.slots[head & (capacity_ - 1)] = record;
+        ring.head.store(head + 1, std::memory_order_release);
+        bump(ring.pushed);
+        return true;
+    }
+
+    // Writes what is still buffered and stops the writer thread. Call it once every producer is done; it rethrows
+    // the first exception of the writer function, after which the records still to write were counted as dropped.
+    void close() {
+        if (thread_.joinable()) {
+            thread_.request_stop();
+            thread_.join();
+        }
+        if (error_) {
+            std::rethrow_exception(std::exchange(error_, {}));
+        }
+    }
+
+    // Counters are read without stopping anything, so they are only consistent with each other once closed
+    [[nodiscard]] SinkStats stats() const {
+        SinkStats stats;
+        stats.capacity = capacity_;
+        for (size_t i = 0; i < num_rings_; ++i) {
+            const auto& ring = rings_[i];
+            stats.pushed += ring.pushed.load(std::memory_order_relaxed);
+            stats.dropped += ring.dropped.load(std::memory_order_relaxed);
+            stats.waits += ring.waits.load(std::memory_order_relaxed);
+            const size_t tail = ring.tail.load(std::memory_order_relaxed);
+            stats.occupancy.push_back(ring.head.load(std::memory_order_relaxed) - tail);
+        }
+        stats.written = written_.load(std::memory_order_relaxed);
+        stats.dropped += failed_.load(std::memory_order_relaxed);
+        stats.batches = batches_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    // The producer's line (head, its copy of the tail and its counters) and the writer's line (tail) apart
+    struct Ring {
+        alignas(CACHE_LINE) std::atomic<size_t> head{0};
+        size_t cached_tail = 0;
+        std::atomic<uint64_t> pushed{0}, dropped{0}, waits{0};
+        std::unique_ptr<Record[]> slots;
+        alignas(CACHE_LINE) std::atomic<size_t> tail{0};
+    };
+
+    size_t num_rings_;
+    size_t capacity_;
+    size_t batch_size_;
+    Overflow overflow_;
+    std::unique_ptr<Ring[]> rings_;
+    Writer writer_;
+    std::exception_ptr error_;  // of the writer function; read after the join
+    alignas(CACHE_LINE) std::atomic<uint64_t> written_{0}, failed_{0}, batches_{0};
+    std::jthread thread_;
+
+    // Spins briefly, then yields, then sleeps, so an idle wait costs next to no CPU
+    static void backoff(size_t spins) {
+        if (spins < 64) {
+            return;
+        }
+        if (spins < 128) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    void drain(const std::stop_token& stop) {
+        std::vector<Record> batch;
+        batch.reserve(batch_size_);
+        for (size_t idle = 0;;) {
+            // Checked before draining, so whatever was pushed before the stop is drained by this round
+            const bool stopping = stop.stop_requested();
+            size_t drained = 0;
+            for (size_t i = 0; i < num_rings_; ++i) {
+                drained += take(rings_[i], batch);
+            }
+            flush(batch);
+            if (drained > 0) {
+                idle = 0;
+            } else if (stopping) {
+                return;
+            } else {
+                backoff(64 + idle++);
+            }
+        }
+    }
+
+    // Moves what `ring` holds into `batch`, flushing whenever it fills up
+    size_t take(Ring& ring, std::vector<Record>& batch) {
+        size_t tail = ring.tail.load(std::memory_order_relaxed);
+        const size_t head = ring.head.load(std::memory_order_acquire);
+        const size_t available = head - tail;
+        while (tail != head) {
+            const size_t n = std::min({head - tail, batch_size_ - batch.size(), capacity_ - (tail & (capacity_ - 1))});
+            const Record* first = &ring.slots[tail & (capacity_ - 1)];
+            batch.insert(batch.end(), first, first + n);
+            tail += n;
+            ring.tail.store(tail, std::memory_order_release);
+            if (batch.size() == batch_size_) {
+                flush(batch);
+            }
+        }
+        return available;
+    }
+
+    void flush(std::vector<Record>& batch) {
+        if (batch.empty()) {
+            return;
+        }
+        if (!error_) {
+            try {
+                writer_(std::span<const Record>(batch));
+                written_.fetch_add(batch.size(), std::memory_order_relaxed);
+                batches_.fetch_add(1, std::memory_order_relaxed);
+            } catch (...) {
+                error_ = std::current_exception();
+            }
+        }
+        if (error_) {
+            failed_.fetch_add(batch.size(), std::memory_order_relaxed);
+        }
+        batch.clear();
+    }
+};
+
+#endif //RESULT_SINK_H
@@ -0,0 +1,48 @@
+#ifndef RUN_LIMITS_H
+#define RUN_LIMITS_H
+
+// Cooperative stopping of a running simulation: a `std::stop_token` for cancellation and a wall-clock deadline. The
+// event loop asks `expired()` every `check_interval` events, so an unlimited run pays one counter decrement per event
+// and a limited one a clock read per interval. A stopped run keeps what its monitor has seen so far.
+
+#include <chrono>
+#include <cstddef>
+#include <stop_token>
+#include <string_view>
+
+enum class RunStatus {
+    Completed,        // reached the end time, or no reaction could fire
+    Cancelled,        // stop requested on the token
+    DeadlineExpired   // wall-clock deadline passed
+};
+
+inline std::string_view to_string(RunStatus status) {
+    switch (status) {
+        case RunStatus::Completed: return "completed";
+        case RunStatus::Cancelled: return "cancelled";
+        case RunStatus::DeadlineExpired: return "deadline expired";
+        default: return "unknown";
+    }
+}
+
+struct RunLimits {
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t check_interval = 256;
+
+    std::stop_token stop;
+    Clock::time_point deadline = Clock::time_point::max();
+
+    // `Completed` while the run may go on
+    [[nodiscard]] RunStatus expired() const {
+        if (stop.stop_requested()) {
+            return RunStatus::Cancelled;
+        }
+        if (deadline != Clock::time_point::max() && Clock::now() >= deadline) {
+            return RunStatus::DeadlineExpired;
+        }
+        return RunStatus::Completed;
+    }
+};
+
+#endif //RUN_LIMITS_H
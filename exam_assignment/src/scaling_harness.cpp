@@ -0,0 +1,141 @@
+#include "scaling_harness.h"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+double quantile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) {
+        throw std::runtime_error("Quantile of an empty sample");
+    }
+    const double position = q * static_cast<double>(sorted.size() - 1);
+    const auto below = static_cast<size_t>(std::floor(position));
+    const size_t above = std::min(below + 1, sorted.size() - 1);
+    return sorted[below] + (position - static_cast<double>(below)) * (sorted[above] - sorted[below]);
+}
+
+namespace {
+    double median_of(std::vector<double>& sample) {
+        std::sort(sample.begin(), sample.end());
+        return quantile(sample, 0.5);
+    }
+
+    // Draws `resample.size()` values from `sample` with replacement
+    void resample_from(const std::vector<double>& sample, std::vector<double>& resample, std::mt19937& generator) {
+        std::uniform_int_distribution<size_t> pick(0, sample.size() - 1);
+        for (auto& x : resample) {
+            x = sample[pick(generator)];
+        }
+    }
+}
+
+SampleSummary summarize(std::vector<double> samples, double confidence, size_t resamples, unsigned seed) {
+    SampleSummary summary;
+    summary.n = samples.size();
+    std::sort(samples.begin(), samples.end());
+    summary.median = quantile(samples, 0.5);
+    summary.q1 = quantile(samples, 0.25);
+    summary.q3 = quantile(samples, 0.75);
+
+    std::mt19937 generator(seed);
+    std::vector<double> resample(samples.size()), medians(resamples);
+    for (auto& median : medians) {
+        resample_from(samples, resample, generator);
+        median = median_of(resample);
+    }
+    std::sort(medians.begin(), medians.end());
+    const double alpha = 1 - confidence;
+    summary.ci_low = resamples > 0 ? quantile(medians, alpha / 2) : summary.median;
+    summary.ci_high = resamples > 0 ? quantile(medians, 1 - alpha / 2) : summary.median;
+    return summary;
+}
+
+double karp_flatt(double speedup, size_t threads) {
+    if (threads < 2 || speedup <= 0) {
+        return NAN;
+    }
+    const double p = static_cast<double>(threads);
+    return (1 / speedup - 1 / p) / (1 - 1 / p);
+}
+
+void analyze_scaling(std::vector<ScalingPoint>& points, ScalingMode mode, const ScalingOptions& options) {
+    if (points.empty()) {
+        return;
+    }
+    for (auto& point : points) {
+        point.time = summarize(point.seconds, options.confidence, options.bootstrap_resamples, options.seed);
+    }
+
+    // The baseline is assumed to scale perfectly up to its own thread count, so a sweep starting at 2 threads
+    // still reports speedups comparable to one starting at 1
+    const auto& base = points.front();
+    auto speedup = [&base, mode](double base_time, double time, size_t threads) {
+        const double ratio = base_time / time * static_cast<double>(base.threads);
+        return mode == ScalingMode::Strong ? ratio : ratio * static_cast<double>(threads) / static_cast<double>(base.threads);
+    };
+
+    // Speedup interval: bootstrap the ratio of medians by resampling the baseline and the point independently
+    std::mt19937 generator(options.seed);
+    std::vector<double> base_resample(base.seconds.size());
+    for (auto& point : points) {
+        point.speedup = speedup(base.time.median, point.time.median, point.threads);
+        point.efficiency = point.speedup / static_cast<double>(point.threads);
+        point.karp_flatt = karp_flatt(point.speedup, point.threads);
+
+        std::vector<double> resample(point.seconds.size()), ratios(options.bootstrap_resamples);
+        for (auto& ratio : ratios) {
+            resample_from(base.seconds, base_resample, generator);
+            resample_from(point.seconds, resample, generator);
+            ratio = speedup(median_of(base_resample), median_of(resample), point.threads);
+        }
+        std::sort(ratios.begin(), ratios.end());
+        const double alpha = 1 - options.confidence;
+        point.speedup_ci_low = ratios.empty() ? point.speedup : quantile(ratios, alpha / 2);
+        point.speedup_ci_high = ratios.empty() ? point.speedup : quantile(ratios, 1 - alpha / 2);
+    }
+}
+
+void write_scaling_csv(std::ostream& os, const std::vector<ScalingPoint>& points) {
+    os << "threads,replicas,repeats,median_s,q1_s,q3_s,iqr_s,ci_low_s,ci_high_s,"
+          "speedup,speedup_ci_low,speedup_ci_high,efficiency,karp_flatt\n";
+    for (const auto& p : points) {
+        os << p.threads << ',' << p.replicas << ',' << p.time.n << ',' << p.time.median << ',' << p.time.q1 << ','
+           << p.time.q3 << ',' << p.time.iqr() << ',' << p.time.ci_low << ',' << p.time.ci_high << ',' << p.speedup
+           << ',' << p.speedup_ci_low << ',' << p.speedup_ci_high << ',' << p.efficiency << ',';
+        // Left empty when undefined, which spreadsheets and pandas read as missing
+        if (!std::isnan(p.karp_flatt)) {
+            os << p.karp_flatt;
+        }
+        os << '\n';
+    }
+}
+
+void write_scaling_json(std::ostream& os, const std::string& name, ScalingMode mode, const std::vector<ScalingPoint>& points) {
+    auto number = [&os](double x) -> std::ostream& {
+        return std::isfinite(x) ? os << x : os << "null";
+    };
+
+    os << "{\"name\": \"" << name << "\", \"mode\": \"" << (mode == ScalingMode::Strong ? "strong" : "weak")
+       << "\", \"points\": [";
+    for (size_t i = 0; i < points.size(); ++i) {
+        const auto& p = points[i];
+        os << (i > 0 ? ", " : "") << "{\"threads\": " << p.threads << ", \"replicas\": " << p.replicas
+           << ", \"seconds\": [";
+        for (size_t j = 0; j < p.seconds.size(); ++j) {
+            os << (j > 0 ? ", " : "");
+            number(p.seconds[j]);
+        }
+        os << "], \"median\": ";
+        number(p.time.median) << ", \"q1\": ";
+        number(p.time.q1) << ", \"q3\": ";
+        number(p.time.q3) << ", \"ci\": [";
+        number(p.time.ci_low) << ", ";
+        number(p.time.ci_high) << "], \"speedup\": ";
+        number(p.speedup) << ", \"speedup_ci\": [";
+        number(p.speedup_ci_low) << ", ";
+        number(p.speedup_ci_high) << "], \"efficiency\": ";
+        number(p.efficiency) << ", \"karp_flatt\": ";
+        number(p.karp_flatt) << "}";
+    }
+    os << "]}\n";
+}
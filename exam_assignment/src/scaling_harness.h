@@ -0,0 +1,131 @@
+#ifndef SCALING_HARNESS_H
+#define SCALING_HARNESS_H
+
+// Strong and weak scaling of ParallelSimulator. Strong scaling keeps the number of replicas fixed while the thread
+// count grows; weak scaling keeps the replicas per thread fixed, so ideal scaling is a constant wall time. Every point
+// is a sample of repeated wall-time measurements on one warm ParallelSimulator (the thread pool is built once per
+// point, not per repeat), summarized by its median, interquartile range and a percentile-bootstrap confidence
+// interval. Speedup, parallel efficiency and the Karp-Flatt serial fraction are taken relative to the smallest
+// thread count.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "parallel_simulator.h"
+
+struct ScalingOptions {
+    std::vector<size_t> threads{1, 2, 4, 8};
+    size_t repeats = 15;           // timed runs per point, after one warm-up run
+    double confidence = 0.95;
+    size_t bootstrap_resamples = 2000;
+    unsigned seed = 42;            // for the bootstrap resampling
+    Placement placement = Placement::None;  // of the worker threads, see ThreadPool
+};
+
+// Median and spread of a sample, with a percentile-bootstrap confidence interval for the median
+struct SampleSummary {
+    size_t n = 0;
+    double median = 0;
+    double q1 = 0, q3 = 0;
+    double ci_low = 0, ci_high = 0;
+
+    double iqr() const { return q3 - q1; }
+};
+
+struct ScalingPoint {
+    size_t threads = 0;
+    size_t replicas = 0;
+    std::vector<double> seconds;   // wall time of each repeat
+    SampleSummary time;
+    // Strong: T(base) / T(p) scaled by the base thread count. Weak: the scaled speedup p * T(base) / T(p).
+    double speedup = 0, speedup_ci_low = 0, speedup_ci_high = 0;
+    double efficiency = 0;         // speedup / threads
+    double karp_flatt = NAN;       // (1/S - 1/p) / (1 - 1/p), undefined for a single thread
+};
+
+enum class ScalingMode { Strong, Weak };
+
+// Quantile with linear interpolation between order statistics, `q` in [0, 1]; `sorted` must be sorted.
+double quantile(const std::vector<double>& sorted, double q);
+SampleSummary summarize(std::vector<double> samples, double confidence, size_t resamples, unsigned seed);
+double karp_flatt(double speedup, size_t threads);
+
+// Fills in the summaries, speedups, efficiencies and Karp-Flatt metrics of points that only carry their samples.
+// The first point, which has the smallest thread count, is the baseline.
+void analyze_scaling(std::vector<ScalingPoint>& points, ScalingMode mode, const ScalingOptions& options);
+
+void write_scaling_csv(std::ostream& os, const std::vector<ScalingPoint>& points);
+void write_scaling_json(std::ostream& os, const std::string& name, ScalingMode mode, const std::vector<ScalingPoint>& points);
+
+template<typename MonitorType>
+class ScalingHarness {
+public:
+    using SystemFactory = typename ParallelSimulator<MonitorType>::SystemFactory;
+    using MonitorFactory = typename ParallelSimulator<MonitorType>::MonitorFactory;
+
+    ScalingHarness(SystemFactory system_factory, MonitorFactory monitor_factory, double end_time, ScalingOptions options);
+
+    // `replicas` simulations at every thread count
+    std::vector<ScalingPoint> strong(size_t replicas);
+    // `replicas_per_thread` simulations per thread at every thread count
+    std::vector<ScalingPoint> weak(size_t replicas_per_thread);
+
+private:
+    SystemFactory system_factory_;
+    MonitorFactory monitor_factory_;
+    double end_time_;
+    ScalingOptions options_;
+
+    ScalingPoint measure(size_t threads, size_t replicas);
+};
+
+template<typename MonitorType>
+ScalingHarness<MonitorType>::ScalingHarness(SystemFactory system_factory, MonitorFactory monitor_factory, double end_time, ScalingOptions options)
+        : system_factory_(std::move(system_factory)), monitor_factory_(std::move(monitor_factory)), end_time_(end_time), options_(std::move(options)) {
+    std::sort(options_.threads.begin(), options_.threads.end());
+}
+
+template<typename MonitorType>
+std::vector<ScalingPoint> ScalingHarness<MonitorType>::strong(size_t replicas) {
+    std::vector<ScalingPoint> points;
+    for (size_t threads : options_.threads) {
+        points.push_back(measure(threads, replicas));
+    }
+    analyze_scaling(points, ScalingMode::Strong, options_);
+    return points;
+}
+
+template<typename MonitorType>
+std::vector<ScalingPoint> ScalingHarness<MonitorType>::weak(size_t replicas_per_thread) {
+    std::vector<ScalingPoint> points;
+    for (size_t threads : options_.threads) {
+        points.push_back(measure(threads, replicas_per_thread * threads));
+    }
+    analyze_scaling(points, ScalingMode::Weak, options_);
+    return points;
+}
+
+template<typename MonitorType>
+ScalingPoint ScalingHarness<MonitorType>::measure(size_t threads, size_t replicas) {
+    ScalingPoint point;
+    point.threads = threads;
+    point.replicas = replicas;
+
+    ParallelSimulator<MonitorType> simulator(system_factory_, monitor_factory_, end_time_, replicas, threads, nullptr,
+                                             {.placement = options_.placement, .topology = std::nullopt});
+    simulator.simulate();  // warm-up: starts the workers and faults in the allocations
+    for (size_t repeat = 0; repeat < options_.repeats; ++repeat) {
+        auto begin = std::chrono::steady_clock::now();
+        simulator.simulate();
+        point.seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+    }
+    return point;
+}
+
+#endif //SCALING_HARNESS_H
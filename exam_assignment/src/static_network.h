@@ -0,0 +1,243 @@
+#ifndef STATIC_NETWORK_H
+#define STATIC_NETWORK_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <utility>
+
+// Compile-time counterpart of the `System` DSL for fixed models. Species are tags carrying their state index and
+// reactions are types, so `S + I >>= E + I` builds no objects at run time:
+//
+//     inline constexpr static_network::Species<0> S;  // likewise E and I
+//     using Model = decltype(kernel(S + I >>= E + I, E >>= I));
+//     Model model({beta / N, alpha}, {S0, E0, I0});
+//     model.simulate(100, seed, [](const Model::State& x, double t) { ... });
+//
+// `Kernel` derives the stoichiometry, the dependency graph and the propensity expressions from the types, and
+// instantiates one firing routine per reaction with the state update and the dependent propensity updates
+// unrolled. The resulting simulation loop uses fixed-size arrays only: no heap, no maps and no string compares.
+namespace static_network {
+    template <size_t I>
+    struct Species {
+        static constexpr size_t index = I;
+    };
+
+    // Multiset of species, one entry per occurrence (`A + A` is Complex<a, a>)
+    template <size_t... Is>
+    struct Complex {};
+
+    inline constexpr Complex<> nothing{};
+
+    template <typename T>
+    struct as_complex;
+    template <size_t I>
+    struct as_complex<Species<I>> { using type = Complex<I>; };
+    template <size_t... Is>
+    struct as_complex<Complex<Is...>> { using type = Complex<Is...>; };
+
+    template <typename T>
+    concept Term = requires { typename as_complex<T>::type; };
+
+    template <size_t... As, size_t... Bs>
+    constexpr Complex<As..., Bs...> join(Complex<As...>, Complex<Bs...>) { return {}; }
+
+    template <Term L, Term R>
+    constexpr auto operator+(L, R) {
+        return join(typename as_complex<L>::type{}, typename as_complex<R>::type{});
+    }
+
+    template <typename Reactants, typename Products>
+    struct Reaction;
+
+    template <size_t... Rs, size_t... Ps>
+    struct Reaction<Complex<Rs...>, Complex<Ps...>> {
+        static constexpr std::array<size_t, sizeof...(Rs)> reactants{Rs...};
+        static constexpr std::array<size_t, sizeof...(Ps)> products{Ps...};
+
+        template <typename State>
+        static constexpr double massAction(const State& x) {
+            return (1.0 * ... * static_cast<double>(x[Rs]));
+        }
+    };
+
+    template <Term L, Term R>
+    constexpr Reaction<typename as_complex<L>::type, typename as_complex<R>::type> operator>>=(L, R) { return {}; }
+
+    template <typename... Reactions>
+    class Kernel {
+    public:
+        static constexpr size_t num_reactions = sizeof...(Reactions);
+        static constexpr size_t num_species = [] {
+            size_t n = 0;
+            auto visit = [&n](const auto& species) {
+                for (auto s : species) {
+                    n = s + 1 > n ? s + 1 : n;
+                }
+            };
+            (visit(Reactions::reactants), ...);
+            (visit(Reactions::products), ...);
+            return n;
+        }();
+
+        using State = std::array<int, num_species>;
+        using Rates = std::array<double, num_reactions>;
+
+        Kernel() = default;
+        Kernel(const Rates& rates, const State& initial) : rates_(rates), initial_(initial) {}
+
+        [[nodiscard]] const State& initialState() const { return initial_; }
+        [[nodiscard]] const Rates& rates() const { return rates_; }
+
+        // Direct method until `end_time`; `monitor(state, t)` is called after every event. Returns the event count.
+        template <typename Monitor>
+        size_t simulate(double end_time, unsigned seed, Monitor&& monitor) const {
+            std::mt19937_64 generator(seed);
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+            State x = initial_;
+            std::array<double, num_reactions> a{};
+            initialize(x, a, std::make_index_sequence<num_reactions>{});
+
+            size_t events = 0;
+            double t = 0;
+            while (true) {
+                double a0 = 0;
+                for (auto ai : a) {
+                    a0 += ai;
+                }
+                if (a0 <= 0) {
+                    break;
+                }
+
+                t += std::exponential_distribution<double>(a0)(generator);
+                if (t > end_time) {
+                    break;
+                }
+
+                // Rounding can carry the target past the last propensity; it then falls to the last reaction that
+                // can fire, never to one with propensity 0
+                double target = uniform(generator) * a0;
+                size_t j = 0;
+                for (size_t i = 0; i < num_reactions; ++i) {
+                    if (a[i] <= 0) {
+                        continue;
+                    }
+                    j = i;
+                    if (target < a[i]) {
+                        break;
+                    }
+                    target -= a[i];
+                }
+
+                if (fire(j, x, a, std::make_index_sequence<num_reactions>{})) {
+                    ++events;
+                    monitor(x, t);
+                }
+            }
+            return events;
+        }
+
+    private:
+        using Types = std::tuple<Reactions...>;
+        template <size_t J>
+        using ReactionAt = std::tuple_element_t<J, Types>;
+
+        // delta[j][s]: net change of species s when reaction j fires
+        static constexpr auto delta = [] {
+            std::array<std::array<int, num_species>, num_reactions> d{};
+            size_t j = 0;
+            auto visit = [&d, &j](const auto& reactants, const auto& products) {
+                for (auto s : reactants) {
+                    --d[j][s];
+                }
+                for (auto s : products) {
+                    ++d[j][s];
+                }
+                ++j;
+            };
+            (visit(Reactions::reactants, Reactions::products), ...);
+            return d;
+        }();
+
+        // need[j][s]: how many copies of s reaction j consumes or reads
+        static constexpr auto need = [] {
+            std::array<std::array<int, num_species>, num_reactions> n{};
+            size_t j = 0;
+            auto visit = [&n, &j](const auto& reactants) {
+                for (auto s : reactants) {
+                    ++n[j][s];
+                }
+                ++j;
+            };
+            (visit(Reactions::reactants), ...);
+            return n;
+        }();
+
+        // affects[j][d]: firing j changes a species that reaction d reads
+        static constexpr auto affects = [] {
+            std::array<std::array<bool, num_reactions>, num_reactions> g{};
+            for (size_t j = 0; j < num_reactions; ++j) {
+                for (size_t d = 0; d < num_reactions; ++d) {
+                    for (size_t s = 0; s < num_species; ++s) {
+                        g[j][d] = g[j][d] || (delta[j][s] != 0 && need[d][s] > 0);
+                    }
+                }
+            }
+            return g;
+        }();
+
+        Rates rates_{};
+        State initial_{};
+
+        template <size_t J>
+        [[nodiscard]] double propensity(const State& x) const {
+            return rates_[J] * ReactionAt<J>::massAction(x);
+        }
+
+        template <size_t... Js>
+        void initialize(const State& x, std::array<double, num_reactions>& a, std::index_sequence<Js...>) const {
+            ((a[Js] = propensity<Js>(x)), ...);
+        }
+
+        template <size_t J, size_t... Ss>
+        static bool canFire(const State& x, std::index_sequence<Ss...>) {
+            return ((need[J][Ss] == 0 || x[Ss] >= need[J][Ss]) && ...);
+        }
+
+        template <size_t J, size_t... Ss>
+        static void apply(State& x, std::index_sequence<Ss...>) {
+            ((delta[J][Ss] != 0 ? void(x[Ss] += delta[J][Ss]) : void()), ...);
+        }
+
+        template <size_t J, size_t... Ds>
+        void update(const State& x, std::array<double, num_reactions>& a, std::index_sequence<Ds...>) const {
+            ((affects[J][Ds] ? void(a[Ds] = propensity<Ds>(x)) : void()), ...);
+        }
+
+        template <size_t J>
+        bool fire(State& x, std::array<double, num_reactions>& a) const {
+            if (!canFire<J>(x, std::make_index_sequence<num_species>{})) {
+                return false;
+            }
+            apply<J>(x, std::make_index_sequence<num_species>{});
+            update<J>(x, a, std::make_index_sequence<num_reactions>{});
+            return true;
+        }
+
+        // Dispatches the run-time index to the instantiation for that reaction
+        template <size_t... Js>
+        bool fire(size_t j, State& x, std::array<double, num_reactions>& a, std::index_sequence<Js...>) const {
+            bool fired = false;
+            ((j == Js ? (fired = fire<Js>(x, a), true) : false) || ...);
+            return fired;
+        }
+    };
+
+    template <typename... Reactions>
+    constexpr Kernel<Reactions...> kernel(Reactions...) { return {}; }
+}
+
+#endif //STATIC_NETWORK_H
@@ -1,5 +1,8 @@
 #include "stochastic_simulator.h"
 
+#include <algorithm>
+#include <cstdint>
+
 // Solves requirement 4: Implement the stochastic simulation (Alg. 1) of the system using the reaction rules.
 
 double Simulator::compute_delay(const Reaction &r) {
@@ -15,13 +18,13 @@ double Simulator::compute_delay(const Reaction &r) {
     return distribution(generator_); // Returns a random number from the distribution, using the generator - which generates uniformly distributed, pseudo-random numbers
 }
 
-std::shared_ptr<Reaction> Simulator::find_min_delay_reaction(const std::vector<Reaction> &reactions) {
+const Reaction* Simulator::find_min_delay_reaction(const std::vector<Reaction> &reactions) {
     double min_delay = std::numeric_limits<double>::max();
-    std::shared_ptr<Reaction> min_reaction = nullptr;
+    const Reaction* min_reaction = nullptr;
 
     for (auto const &reaction : reactions) {
         if (reaction.delay() < min_delay) {
-            min_reaction = std::make_shared<Reaction>(reaction);
+            min_reaction = &reaction;
             min_delay = reaction.delay();
         }
     }
@@ -41,7 +44,7 @@ bool Simulator::can_react(const Reaction &r) {
     return true;
 }
 
-void Simulator::react(Reaction &r) {
+void Simulator::react(const Reaction &r) {
     for (size_t i = 0; i < r.reactants.size(); ++i) {
         // Currently assuming only 1 reactant is consumed
         const double amount = system_.amount(r.reactants[i]) - 1;
@@ -54,3 +57,95 @@ void Simulator::react(Reaction &r) {
         system_.setAmount(r.products[i], amount);
     }
 }
+
+void Simulator::schedule_events() {
+    const auto& reactions = system_.getReactions();
+    for (size_t i = 0; i < reactions.size(); ++i) {
+        for (const auto& breakpoint : reactions[i].schedule) {
+            events_.push({breakpoint.time, i, 0, breakpoint.rate});
+        }
+    }
+
+    const auto& injections = system_.getInjections();
+    for (size_t i = 0; i < injections.size(); ++i) {
+        events_.push({injections[i].time, SIZE_MAX, i, 0.0});
+    }
+}
+
+bool Simulator::apply_next_event() {
+    const auto event = events_.top();
+    events_.pop();
+
+    if (event.reaction != SIZE_MAX) {
+        system_.getReactions()[event.reaction].setRate(event.rate);
+        return false;
+    }
+
+    const auto& injection = system_.getInjections()[event.injection];
+    system_.setAmount(injection.species, std::max(0, system_.amount(injection.species) + injection.amount));
+    return true;
+}
+
+Simulator::Step Simulator::step(double& t, const Reaction*& fired) {
+    using instrumentation::Phase;
+    using instrumentation::ScopedPhase;
+    auto& reactions = system_.getReactions();
+
+    {
+        ScopedPhase phase(Phase::PropensityUpdate);
+        for (auto &r : reactions) {
+            const auto delay = compute_delay(r);
+            r.setDelay(delay);
+        }
+    }
+
+    const Reaction* next_reaction;
+    {
+        ScopedPhase phase(Phase::Selection);
+        next_reaction = find_min_delay_reaction(reactions);
+    }
+
+    // A scheduled event that comes first preempts the reaction. All delays are redrawn next
+    // iteration anyway, so (by memorylessness) the preempted draw is simply discarded.
+    if (!events_.empty() && (!next_reaction || events_.top().time <= t + next_reaction->delay())) {
+        t = events_.top().time;
+        if (t > end_time_) {
+            return Step::Finished;
+        }
+        fired = nullptr;
+        return apply_next_event() ? Step::Changed : Step::Unchanged;
+    }
+
+    if (!next_reaction) {
+        return Step::Finished; // No more reactions can proceed
+    }
+
+    t += next_reaction->delay();
+
+    if (!can_react(*next_reaction)) {
+        instrumentation::count(instrumentation::Counter::Rejected);
+        return Step::Unchanged;
+    }
+
+    {
+        ScopedPhase phase(Phase::StateUpdate);
+        react(*next_reaction);
+    }
+    instrumentation::count(instrumentation::Counter::Events);
+    fired = next_reaction;
+    return Step::Changed;
+}
+
+Generator<SimulationEvent> Simulator::events() {
+    double t = 0;
+    const Reaction* fired = nullptr;
+    while (t <= end_time_) {
+        const auto outcome = step(t, fired);
+        if (outcome == Step::Finished) {
+            break;
+        }
+        if (outcome == Step::Changed) {
+            co_yield SimulationEvent{t, fired, system_};
+        }
+    }
+}
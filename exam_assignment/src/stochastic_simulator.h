@@ -6,56 +6,146 @@
 #include <chrono>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <queue>
+#include <vector>
 
 #include "types.h"
+#include "event_channel.h"
+#include "generator.h"
+#include "instrumentation.h"
+#include "run_limits.h"
 #include "monitor/monitor.h"
 
+// One state change of a run, as the pull API hands it out. `state` is the simulator's own system, so it shows the
+// state after this event only until the run moves on.
+struct SimulationEvent {
+    double time;
+    const Reaction* reaction;  // nullptr for an injection
+    const System& state;
+};
+
 class Simulator {
 public:
-    Simulator(const System& system, double end_time)
-            : system_(system)
+    // The system is taken by value, so a replica that is handed its own system can move it in instead of copying it
+    Simulator(System system, double end_time)
+            : Simulator(std::move(system), end_time, clock_seed())
+    {}
+
+    // Fixed seed, for reproducible runs. The simulator's working storage comes from `resource`, e.g. a replica arena.
+    Simulator(System system, double end_time, unsigned seed,
+              std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : system_(std::move(system))
             , end_time_(end_time)
-            , generator_(std::chrono::system_clock::now().time_since_epoch().count())
+            , generator_(seed)
+            , events_(std::greater<>(), std::pmr::vector<ScheduledEvent>(resource))
     {
+        schedule_events();
+    }
+
+    static unsigned clock_seed() {
+        return static_cast<unsigned>(std::chrono::system_clock::now().time_since_epoch().count());
     }
 
     // Part-solution to requirement 7: Implement a generic support for the state monitor in the stochastic simulation algorithm.
+    // With `limits`, the run stops early when cancelled or past its deadline, and the monitor keeps what it has seen.
     template<typename Monitor>
-    void simulate(Monitor monitor) {
+    RunStatus simulate(Monitor monitor, const RunLimits& limits = {}) {
         double t = 0;
-
-        auto& reactions = system_.getReactions();
+        const Reaction* fired = nullptr;
+        size_t until_check = RunLimits::check_interval;
 
         while (t <= end_time_) {
-            for (auto &r : reactions) {
-                const auto delay = compute_delay(r);
-                r.setDelay(delay);
+            if (--until_check == 0) {
+                until_check = RunLimits::check_interval;
+                if (const auto status = limits.expired(); status != RunStatus::Completed) {
+                    return status;
+                }
             }
 
-            auto next_reaction = find_min_delay_reaction(reactions);
-            if (!next_reaction) {
-                break; // No more reactions can proceed
+            const auto outcome = step(t, fired);
+            if (outcome == Step::Finished) {
+                break;
             }
-
-            t += next_reaction->delay();
-
-            if (!can_react(*next_reaction)) {
-                continue;
+            if (outcome == Step::Changed) {
+                instrumentation::ScopedPhase phase(instrumentation::Phase::MonitorCallback);
+                monitor(system_, t);
             }
-
-            react(*next_reaction);
-            monitor(system_, t);
         }
+        return RunStatus::Completed;
+    }
+
+    // The run as a lazy sequence, pulled one event at a time, e.g. to interleave several runs on one thread or stop
+    // as soon as the consumer has seen enough:
+    //     for (const auto& event : simulator.events()) { ... }
+    // Yields the events `simulate` would pass to a monitor. The simulator must outlive the generator.
+    Generator<SimulationEvent> events();
+
+    // The run pushed into a bounded `channel` as `project(event)` for each event, from a coroutine that is suspended
+    // while the channel is full, so the consumer sets the pace (see event_channel.h). The projection must copy what
+    // it needs out of the event, as the consumer may be on another thread. Closes the channel at the end, also when
+    // the consumer cancels or the projection throws (the consumer then gets the exception). The simulator must
+    // outlive the channel.
+    template<typename T, typename Projection>
+    void stream(EventChannel<T>& channel, Projection project) {
+        channel.attach(produce(channel, std::move(project)));
     }
 
     double compute_delay(const Reaction &r);
-    std::shared_ptr<Reaction> find_min_delay_reaction(const std::vector<Reaction> &reactions);
+    // The reaction with the smallest delay, or nullptr if none can happen. Points into `reactions`, so selecting
+    // costs no copy or allocation.
+    const Reaction* find_min_delay_reaction(const std::vector<Reaction> &reactions);
     bool can_react(const Reaction &r);
-    void react(Reaction &r);
+    void react(const Reaction &r);
 
 private:
+    enum class Step {
+        Changed,    // a reaction fired or an injection changed amounts
+        Unchanged,  // a rate change, or a reaction that could not fire
+        Finished    // past the end time, or nothing can happen any more
+    };
+
+    // Rate changes and injections, ordered by time (earliest on top)
+    struct ScheduledEvent {
+        double time;
+        size_t reaction;   // index into the reactions, or SIZE_MAX for an injection
+        size_t injection;  // index into `System::getInjections()`
+        double rate;
+
+        bool operator>(const ScheduledEvent& other) const { return time > other.time; }
+    };
+
     System system_;
     double end_time_;
     std::default_random_engine generator_;
+    std::priority_queue<ScheduledEvent, std::pmr::vector<ScheduledEvent>, std::greater<>> events_;
+
+    void schedule_events();
+    // Returns true if the event changed species amounts
+    bool apply_next_event();
+    // One iteration of the event loop: advances `t` and, when a reaction fires, sets `fired` to it (nullptr for an
+    // injection)
+    Step step(double& t, const Reaction*& fired);
+
+    template<typename T, typename Projection>
+    StreamTask produce(EventChannel<T>& channel, Projection project) {
+        try {
+            double t = 0;
+            const Reaction* fired = nullptr;
+            while (t <= end_time_) {
+                const auto outcome = step(t, fired);
+                if (outcome == Step::Finished) {
+                    break;
+                }
+                if (outcome == Step::Changed && !co_await channel.push(project(SimulationEvent{t, fired, system_}))) {
+                    break;
+                }
+            }
+        } catch (...) {
+            channel.close(std::current_exception());
+            co_return;
+        }
+        channel.close();
+    }
 };
 #endif
@@ -0,0 +1,52 @@
+#ifndef SUM_TREE_H
+#define SUM_TREE_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Complete binary tree of partial sums over n non-negative weights. Changing a weight and picking an index with
+// probability proportional to its weight both take O(log n), which is what a hierarchical direct method needs
+// at its top level. Every update recomputes the ancestors from their children, so the sums do not drift.
+class SumTree {
+public:
+    explicit SumTree(size_t n = 0) : leaves_(1) {
+        while (leaves_ < n) {
+            leaves_ *= 2;
+        }
+        nodes_.assign(2 * leaves_, 0.0);
+    }
+
+    [[nodiscard]] double total() const { return nodes_[1]; }
+    [[nodiscard]] double weight(size_t i) const { return nodes_[leaves_ + i]; }
+
+    void update(size_t i, double weight) {
+        size_t node = leaves_ + i;
+        nodes_[node] = weight;
+        for (node /= 2; node > 0; node /= 2) {
+            nodes_[node] = nodes_[2 * node] + nodes_[2 * node + 1];
+        }
+    }
+
+    // Index whose cumulative weight range contains `target` in [0, total()), and the offset into that range
+    [[nodiscard]] std::pair<size_t, double> find(double target) const {
+        size_t node = 1;
+        while (node < leaves_) {
+            const double left = nodes_[2 * node];
+            // Never descend into an empty subtree, even when rounding puts the target past the total
+            if ((target < left || nodes_[2 * node + 1] <= 0) && left > 0) {
+                node = 2 * node;
+            } else {
+                target -= left;
+                node = 2 * node + 1;
+            }
+        }
+        return {node - leaves_, target};
+    }
+
+private:
+    size_t leaves_;
+    std::vector<double> nodes_;  // nodes_[1] is the root, leaves start at nodes_[leaves_]
+};
+
+#endif //SUM_TREE_H
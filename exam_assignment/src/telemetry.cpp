@@ -0,0 +1,141 @@
+#include "telemetry.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+using prometheus::metric;
+using prometheus::prefix;
+using prometheus::value;
+
+void prometheus::metric(std::ostream& os, const char* name, const char* type, const char* help) {
+    os << "# HELP " << prefix << name << ' ' << help << '\n' << "# TYPE " << prefix << name << ' ' << type << '\n';
+}
+
+// Prometheus spells the special values NaN and +Inf
+void prometheus::value(std::ostream& os, double x) {
+    if (std::isnan(x)) {
+        os << "NaN";
+    } else if (std::isinf(x)) {
+        os << (x > 0 ? "+Inf" : "-Inf");
+    } else {
+        os << x;
+    }
+}
+
+double TelemetrySnapshot::rate() const {
+    return std::accumulate(worker_rates.begin(), worker_rates.end(), 0.0);
+}
+
+Telemetry::Telemetry(size_t workers, TelemetryOptions options)
+        : num_workers_(std::max<size_t>(workers, 1)), workers_(std::make_unique<WorkerSlot[]>(num_workers_)),
+          options_(std::move(options)), begin_(std::chrono::steady_clock::now()), last_time_(begin_),
+          last_events_(num_workers_, 0) {
+    if (options_.metrics_file.empty() && options_.console == nullptr) {
+        return;  // nothing to report to, so no reporter thread
+    }
+    reporter_ = std::jthread([this](std::stop_token stop) {
+        std::unique_lock<std::mutex> lock(stop_mutex_);
+        while (true) {
+            // Returns early when a stop is requested; the destructor then writes the final snapshot
+            stop_cv_.wait_for(lock, stop, options_.interval, [] { return false; });
+            if (stop.stop_requested()) {
+                return;
+            }
+            lock.unlock();
+            report(sample());
+            lock.lock();
+        }
+    });
+}
+
+Telemetry::~Telemetry() {
+    if (reporter_.joinable()) {
+        reporter_.request_stop();
+        reporter_.join();
+        report(sample());
+    }
+}
+
+TelemetrySnapshot Telemetry::sample() {
+    std::lock_guard<std::mutex> lock(sample_mutex_);
+    const auto now = std::chrono::steady_clock::now();
+    const double since_last = std::chrono::duration<double>(now - last_time_).count();
+
+    TelemetrySnapshot snapshot;
+    snapshot.elapsed = std::chrono::duration<double>(now - begin_).count();
+    snapshot.worker_events.resize(num_workers_);
+    snapshot.worker_rates.resize(num_workers_);
+    for (size_t w = 0; w < num_workers_; ++w) {
+        const uint64_t events = workers_[w].events.load(std::memory_order_relaxed);
+        snapshot.worker_events[w] = events;
+        snapshot.worker_rates[w] = since_last > 0 ? static_cast<double>(events - last_events_[w]) / since_last : 0.0;
+        last_events_[w] = events;
+    }
+    last_time_ = now;
+
+    // Completed before started before total, so a replica moving through is never counted as running twice
+    snapshot.replicas_completed = replicas_completed_.load(std::memory_order_relaxed);
+    snapshot.replicas_started = std::max(replicas_started_.load(std::memory_order_relaxed), snapshot.replicas_completed);
+    snapshot.replicas_total = std::max(replicas_total_.load(std::memory_order_relaxed), snapshot.replicas_started);
+    if (snapshot.replicas_completed > 0) {
+        const double per_replica = snapshot.elapsed / static_cast<double>(snapshot.replicas_completed);
+        snapshot.eta = per_replica * static_cast<double>(snapshot.replicas_total - snapshot.replicas_completed);
+    }
+    return snapshot;
+}
+
+void Telemetry::writeExposition(std::ostream& os, const TelemetrySnapshot& snapshot) {
+    metric(os, "worker_events_total", "counter", "Reactions fired, per worker.");
+    for (size_t w = 0; w < snapshot.worker_events.size(); ++w) {
+        os << prefix << "worker_events_total{worker=\"" << w << "\"} " << snapshot.worker_events[w] << '\n';
+    }
+    metric(os, "worker_events_per_second", "gauge", "Reactions fired per second over the last interval, per worker.");
+    for (size_t w = 0; w < snapshot.worker_rates.size(); ++w) {
+        os << prefix << "worker_events_per_second{worker=\"" << w << "\"} ";
+        value(os, snapshot.worker_rates[w]);
+        os << '\n';
+    }
+    metric(os, "replicas_completed_total", "counter", "Simulations finished.");
+    os << prefix << "replicas_completed_total " << snapshot.replicas_completed << '\n';
+    metric(os, "replicas_running", "gauge", "Simulations in progress.");
+    os << prefix << "replicas_running " << snapshot.running() << '\n';
+    metric(os, "queue_depth", "gauge", "Simulations submitted but not started.");
+    os << prefix << "queue_depth " << snapshot.queueDepth() << '\n';
+    metric(os, "eta_seconds", "gauge", "Estimated seconds until all submitted simulations finish.");
+    os << prefix << "eta_seconds ";
+    value(os, snapshot.eta);
+    os << '\n';
+    metric(os, "elapsed_seconds", "gauge", "Seconds since the telemetry started.");
+    os << prefix << "elapsed_seconds " << snapshot.elapsed << '\n';
+}
+
+void Telemetry::report(const TelemetrySnapshot& snapshot) {
+    if (!options_.metrics_file.empty()) {
+        // Written next to the target and renamed over it, so a scrape never sees a half-written file
+        auto temporary = options_.metrics_file;
+        temporary += ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::trunc);
+            writeExposition(out, snapshot);
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, options_.metrics_file, error);
+    }
+
+    if (options_.console != nullptr) {
+        // Formatted apart and written in one go: the console is usually std::cout, which other threads print to
+        // with their own formatting
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(1) << "[" << snapshot.elapsed << "s] " << snapshot.rate() / 1000
+             << "k events/s, " << snapshot.replicas_completed << "/" << snapshot.replicas_total << " replicas, "
+             << snapshot.running() << " running, " << snapshot.queueDepth() << " queued";
+        if (!std::isnan(snapshot.eta)) {
+            line << ", ETA " << snapshot.eta << "s";
+        }
+        line << '\n';
+        *options_.console << line.str() << std::flush;
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+// Live throughput of running simulations: events per second per worker, replicas completed, replicas still queued
+// and an ETA. The simulation threads only bump relaxed atomics, each worker on its own cache line; a background
+// reporter thread samples them every `interval`, rewrites `metrics_file` in the Prometheus text exposition format
+// (for the node exporter's textfile collector) and optionally prints a one-line summary.
+//
+//     Telemetry telemetry(threads, {.metrics_file = "stochastic_simulator.prom"});
+//     telemetry.expectReplicas(n);
+//     // on a worker:
+//     telemetry.replicaStarted();
+//     simulator.simulate(count_events(telemetry, worker, monitor));
+//     telemetry.replicaCompleted();
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cache_line.h"
+
+struct TelemetryOptions {
+    std::filesystem::path metrics_file;                  // not written if empty
+    std::chrono::milliseconds interval{1000};
+    std::ostream* console = nullptr;                     // one summary line per interval if set
+};
+
+struct TelemetrySnapshot {
+    double elapsed = 0;                                  // seconds since the telemetry was created
+    std::vector<uint64_t> worker_events;
+    std::vector<double> worker_rates;                    // events per second since the previous snapshot
+    uint64_t replicas_total = 0, replicas_started = 0, replicas_completed = 0;
+    double eta = NAN;                                    // seconds, from the mean completion rate so far
+
+    uint64_t queueDepth() const { return replicas_total - replicas_started; }
+    uint64_t running() const { return replicas_started - replicas_completed; }
+    double rate() const;                                 // all workers
+};
+
+class Telemetry {
+public:
+    explicit Telemetry(size_t workers, TelemetryOptions options = {});
+    // Stops the reporter and writes a final snapshot
+    ~Telemetry();
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    // Hot path. Workers beyond `workers` share slots modulo the slot count.
+    void addEvents(size_t worker, uint64_t n = 1) {
+        workers_[worker % num_workers_].events.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void expectReplicas(uint64_t n) { replicas_total_.fetch_add(n, std::memory_order_relaxed); }
+    // Expected replicas that will never start, e.g. those of a cancelled job
+    void dropReplicas(uint64_t n) { replicas_total_.fetch_sub(n, std::memory_order_relaxed); }
+    void replicaStarted() { replicas_started_.fetch_add(1, std::memory_order_relaxed); }
+    void replicaCompleted() { replicas_completed_.fetch_add(1, std::memory_order_relaxed); }
+
+    // Reads the counters; rates are relative to the previous call. Called by the reporter, but usable directly.
+    TelemetrySnapshot sample();
+
+    static void writeExposition(std::ostream& os, const TelemetrySnapshot& snapshot);
+
+private:
+    // Padded to a cache line so workers never share one
+    struct alignas(CACHE_LINE) WorkerSlot {
+        std::atomic<uint64_t> events{0};
+    };
+
+    size_t num_workers_;
+    std::unique_ptr<WorkerSlot[]> workers_;
+    alignas(CACHE_LINE) std::atomic<uint64_t> replicas_total_{0};
+    std::atomic<uint64_t> replicas_started_{0};
+    std::atomic<uint64_t> replicas_completed_{0};
+
+    TelemetryOptions options_;
+    std::chrono::steady_clock::time_point begin_;
+    // State of the previous sample, touched only under `sample_mutex_`
+    std::mutex sample_mutex_;
+    std::chrono::steady_clock::time_point last_time_;
+    std::vector<uint64_t> last_events_;
+
+    std::mutex stop_mutex_;
+    std::condition_variable_any stop_cv_;
+    std::jthread reporter_;
+
+    void report(const TelemetrySnapshot& snapshot);
+};
+
+// The Prometheus text format, for the other exporters of metrics (result_sink.h)
+namespace prometheus {
+    // Metric names, all prefixed with the project
+    inline constexpr const char* prefix = "stochastic_simulator_";
+
+    // The HELP and TYPE lines of metric `name`
+    void metric(std::ostream& os, const char* name, const char* type, const char* help);
+    void value(std::ostream& os, double x);
+}
+
+// Wraps a monitor so every call also counts an event for `worker`. The monitor is held by reference, as the
+// simulators take their monitor by value.
+template <typename Func>
+auto count_events(Telemetry& telemetry, size_t worker, Func& func) {
+    return [&telemetry, worker, &func](auto&&... args) {
+        func(std::forward<decltype(args)>(args)...);
+        telemetry.addEvents(worker);
+    };
+}
+
+#endif //TELEMETRY_H
@@ -7,15 +7,63 @@
 #include <numeric>
 #include <functional>
 #include <memory>
+#include <algorithm>
+#include <array>
 #include <condition_variable>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "cpu_topology.h"
 
+// Tasks of a higher class take every slot that frees up before a waiting task of a lower class gets one. Running tasks
+// are never interrupted, so an interactive job preempts a batch sweep at the sweep's next task boundary.
+enum class Priority { Batch, Interactive, Count };
+
+struct PoolOptions {
+    Placement placement = Placement::None;
+    std::optional<CpuTopology> topology;  // detected if not given
+};
+
+// Every task runs on one of `concurrency_level` slots. The slots are split evenly over the NUMA nodes (sockets), and
+// with a placement other than `None` a task's thread is pinned to its slot's core or socket before it runs.
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t concurrency_level) : available(concurrency_level) {};
+    explicit ThreadPool(size_t concurrency_level, PoolOptions options = {})
+            : concurrency_level(concurrency_level), available(concurrency_level), placement(options.placement) {
+        const auto topology = options.topology ? std::move(*options.topology) : CpuTopology::detect();
+        num_nodes = topology.nodes.size();
+        for (size_t slot = 0; slot < concurrency_level; ++slot) {
+            const size_t node = slot * num_nodes / concurrency_level;
+            const auto& cpus = topology.nodes[node];
+            // Index of the slot among the slots of its node, so the cores of a node are handed out in turn
+            const size_t first_of_node = (node * concurrency_level + num_nodes - 1) / num_nodes;
+            slots.push_back({node, false, {}});
+            if (placement == Placement::Cores) {
+                slots.back().cpus = {cpus[(slot - first_of_node) % cpus.size()]};
+            } else if (placement == Placement::Sockets) {
+                slots.back().cpus = cpus;
+            }
+        }
+    };
+
+    // The worker threads are detached, so they may still be releasing their slot when the last future is ready.
+    // Wait for every slot to be returned before the mutex and condition variable they use are destroyed.
+    ~ThreadPool() {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        cv_available.wait(lock, [this]{ return available == concurrency_level; });
+    }
 
     // Template function which takes fn `f` and parameter pack `args`. You can add tasks here.
     template<typename Function, typename... Args>
     auto enqueue(Function&& f, Args&&... args) -> std::future<decltype(f(args...))> {
+        return enqueue_on(SIZE_MAX, Priority::Batch, std::forward<Function>(f), std::forward<Args>(args)...);
+    }
+
+    // As `enqueue`, but preferring a free slot on `node`. A task only moves to another node when all the slots of its
+    // own node are busy and another node has one free, so replicas partitioned by node stay on their socket. While
+    // every slot is busy it waits behind the tasks of higher `priority`.
+    template<typename Function, typename... Args>
+    auto enqueue_on(size_t node, Priority priority, Function&& f, Args&&... args) -> std::future<decltype(f(args...))> {
         using ReturnType = decltype(f(args...));
 
         // Tasks are packaged into a `std::packaged_task`, allowing us to store a future return value.
@@ -28,36 +76,84 @@ public:
         std::future<ReturnType> result = task->get_future();
 
         // Mutex `queue_mutex` is used with condition_variable `cv_available` to manage access to thread pool
+        size_t slot;
         {
             std::unique_lock<std::mutex> lock(queue_mutex);
 
             // Wait until there's an available slot for a new thread.
             // Causes thread to block if there are no available slots. Unblocked once a thread becomes available, signalled by `cv_available.notify_one()`.
-            cv_available.wait(lock, [this]{ return available > 0; });
+            const auto rank = static_cast<size_t>(priority);
+            ++waiting[rank];
+            cv_available.wait(lock, [this, rank]{
+                return available > 0 && std::all_of(waiting.begin() + rank + 1, waiting.end(), [](size_t n) { return n == 0; });
+            });
+            --waiting[rank];
 
             --available;
+            slot = take_slot(node);
+            if (available > 0) {
+                cv_available.notify_all();  // lower classes held back by this task may take the remaining slots
+            }
         }
 
         // When a thread becomes available, the packaged task is run on a new jthread, and the number of available thread slots is incremented. jthread automatically joins when destructed, but here is immediately detached, so it can run asynchronously (independently).
-        std::jthread([this, task]() {
-            (*task)();
-
-            {
-                std::unique_lock<std::mutex> lock(queue_mutex);
-                ++available;
+        std::jthread([this, task, slot]() {
+            current_slot_ = slot;
+            if (!slots[slot].cpus.empty()) {
+                pin_current_thread(slots[slot].cpus);
             }
+            (*task)();
 
-            // Once we're done executing, we notify the condition variable that a thread is available.
-            cv_available.notify_one();
+            // Once we're done executing, we notify the condition variable that a thread is available. This happens
+            // under the lock, so the pool cannot be destroyed between releasing the slot and notifying.
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            slots[slot].busy = false;
+            ++available;
+            cv_available.notify_all();
         }).detach();
 
         return result;
     }
 
+    // Slot of the calling thread while it runs a pool task, SIZE_MAX on other threads
+    static size_t current_slot() { return current_slot_; }
+    [[nodiscard]] size_t node_of(size_t slot) const { return slots[slot].node; }
+    [[nodiscard]] size_t nodes() const { return num_nodes; }
+    [[nodiscard]] bool pinned() const { return placement != Placement::None; }
+    [[nodiscard]] size_t concurrency() const { return concurrency_level; }
+
 private:
+    struct Slot {
+        size_t node;
+        bool busy;
+        std::vector<int> cpus;  // empty if not pinned
+    };
+
+    static inline thread_local size_t current_slot_ = SIZE_MAX;
+
+    size_t concurrency_level;
     size_t available;
+    std::array<size_t, static_cast<size_t>(Priority::Count)> waiting{};  // blocked in `enqueue`, per priority
+    Placement placement;
+    size_t num_nodes;
+    std::vector<Slot> slots;
     std::mutex queue_mutex;
     std::condition_variable cv_available;
+
+    // A free slot, on `node` if it has one. Called under the lock with `available` > 0.
+    size_t take_slot(size_t node) {
+        size_t chosen = SIZE_MAX;
+        for (size_t slot = 0; slot < slots.size(); ++slot) {
+            if (!slots[slot].busy && (chosen == SIZE_MAX || slots[slot].node == node)) {
+                chosen = slot;
+                if (slots[slot].node == node) {
+                    break;
+                }
+            }
+        }
+        slots[chosen].busy = true;
+        return chosen;
+    }
 };
 
 #endif //THREADPOOL_H
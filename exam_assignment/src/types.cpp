@@ -1,5 +1,7 @@
 #include "types.h"
 
+#include <algorithm>
+
 Species::Species(std::string name) : _name(std::move(name)) {}
 
 const std::string &Species::getName() const {
@@ -15,7 +17,7 @@ std::vector<Species> operator+(const Species &lhs, const Species &rhs) {
 }
 
 Reaction::Reaction(Reaction &&other, double rate) : reactants(std::move(other.reactants)),
-                                                    products(std::move(other.products)), rate_(rate), delta_R(std::move(other.delta_R)), delta_P(std::move(other.delta_P)) {}
+                                                    products(std::move(other.products)), schedule(std::move(other.schedule)), rate_(rate), delta_R(std::move(other.delta_R)), delta_P(std::move(other.delta_P)) {}
 
 Reaction::Reaction(std::vector<Species> &&reactants, std::vector<Species> &&products) : reactants(std::move(reactants)), products(std::move(products)) {}
 
@@ -27,6 +29,10 @@ double Reaction::delay() const {
     return delay_;
 }
 
+void Reaction::setRate(double rate) {
+    rate_ = rate;
+}
+
 void Reaction::setDelay(double delay) {
     delay_ = delay;
 }
@@ -92,6 +98,10 @@ std::vector<Reaction> &System::getReactions() {
     return reactions;
 }
 
+const std::vector<Reaction> &System::getReactions() const {
+    return reactions;
+}
+
 Species System::operator()(const std::string &name, double amount) {
     if (species.contains(Species(name))) {
         throw std::runtime_error("Species already exists");
@@ -128,3 +138,31 @@ void System::setAmount(const Species &s, int amount) {
     }
     species[s] = amount;
 }
+
+void System::schedule(const Reaction &r, double time, double rate) {
+    auto it = std::find(reactions.begin(), reactions.end(), r);
+    if (it == reactions.end()) {
+        throw std::runtime_error("Reaction does not exist");
+    }
+
+    auto at = std::upper_bound(it->schedule.begin(), it->schedule.end(), time,
+                               [](double t, const RateBreakpoint &b) { return t < b.time; });
+    it->schedule.insert(at, {time, rate});
+}
+
+void System::schedule(const Reaction &r, const std::function<double(double)> &rate, double from, double to, double step) {
+    for (double t = from; t < to; t += step) {
+        schedule(r, t, rate(t));
+    }
+}
+
+void System::inject(const Species &s, double time, int amount) {
+    if (!species.contains(s)) {
+        throw std::runtime_error("Species does not exist");
+    }
+    injections.push_back({time, s, amount});
+}
+
+const std::vector<Injection> &System::getInjections() const {
+    return injections;
+}
@@ -7,6 +7,7 @@
 #include <map>
 #include <stdexcept>
 #include <iostream>
+#include <functional>
 
 class Species {
 public:
@@ -22,14 +23,23 @@ private:
 
 std::vector<Species> operator+(const Species &lhs, const Species &rhs);
 
+// Piecewise-constant rate schedule entry: `rate` applies from `time` until the next breakpoint.
+struct RateBreakpoint {
+    double time;
+    double rate;
+};
+
 class Reaction {
 public:
     std::vector<Species> reactants;
     std::vector<Species> products;
+    // Scheduled rate changes (e.g. lockdowns), sorted by time. The rate passed to `System::operator()` applies before the first one.
+    std::vector<RateBreakpoint> schedule;
 
     double rate() const;
     double delay() const;
 
+    void setRate(double rate);
     void setDelay(double delay);
 
     std::vector<double> delta_R;
@@ -56,10 +66,18 @@ struct ReactionHash {
 
 bool operator==(const Reaction& lhs, const Reaction& rhs);
 
+// Discrete change of a species amount at a fixed time, e.g. imported cases.
+struct Injection {
+    double time;
+    Species species;
+    int amount;
+};
+
 class System {
 public:
     [[nodiscard]] const std::map<Species, int> &getSpecies() const;
     [[nodiscard]] std::vector<Reaction> &getReactions();
+    [[nodiscard]] const std::vector<Reaction> &getReactions() const;
 
     Species operator()(const std::string &name, double amount);
     Reaction operator()(Reaction &&r, double rate);
@@ -68,9 +86,18 @@ public:
     int amount(const Species &s) const;
     void setAmount(const Species &s, int amount);
 
+    // Changes the rate of `r` to `rate` from `time` on.
+    void schedule(const Reaction &r, double time, double rate);
+    // Follows `rate(t)` on [from, to) as a piecewise-constant schedule with breakpoints every `step`.
+    void schedule(const Reaction &r, const std::function<double(double)> &rate, double from, double to, double step);
+    void inject(const Species &s, double time, int amount);
+
+    [[nodiscard]] const std::vector<Injection> &getInjections() const;
+
 private:
     std::map<Species, int> species;
     std::vector<Reaction> reactions;
+    std::vector<Injection> injections;
 };
 
 #endif // TYPES_H
@@ -0,0 +1,25 @@
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace allocations {
+    thread_local uint64_t count = 0;
+}
+
+// new[] and delete[] forward to these by default, and the aligned forms use their own allocation, so all pairs match
+void* operator new(std::size_t size) {
+    ++allocations::count;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,13 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+// Counts the heap allocations of the calling thread, for the allocation-free tests. The replacement operator new
+// and delete that do the counting are in allocation_counter.cpp, a translation unit of their own, so the compiler
+// never inlines a `free` into code that got the pointer from `new` and warns about the mismatch.
+namespace allocations {
+    extern thread_local uint64_t count;
+}
+
+#endif //ALLOCATION_COUNTER_H
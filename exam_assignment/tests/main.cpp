@@ -1,6 +1,36 @@
 #include <gtest/gtest.h>
 #include "../src/types.cpp"
 #include "../src/symbol_table.cpp"
+#include "../src/indexed_priority_queue.h"
+#include "../src/compiled_network.cpp"
+#include "../src/instrumentation.cpp"
+#include "../src/perf_counters.cpp"
+#include "../src/telemetry.cpp"
+#include "../src/arena.cpp"
+#include "../src/cpu_topology.cpp"
+#include "../src/result_sink.cpp"
+#include "../src/stochastic_simulator.cpp"
+#include "../src/monitor/species_trajectory_monitor.cpp"
+#include "../src/engines/fsp_solver.cpp"
+#include "../src/engines/uniformization_simulator.cpp"
+#include "../src/engines/rre_solver.cpp"
+#include "../src/engines/time_warp_simulator.cpp"
+#include "../src/engines/adaptive_simulator.cpp"
+#include "../src/replicated_network.cpp"
+#include "../src/engines/replicated_simulator.cpp"
+#include "../src/engines/generated_simulator.cpp"
+#include "../src/network_format.cpp"
+#include "../src/network_image.cpp"
+#include "../src/network_generator.cpp"
+#include "../src/scaling_harness.cpp"
+#include "../src/engines/spatial_simulator.cpp"
+#include "../src/engines/tau_leaping.cpp"
+#include "../src/multilevel_monte_carlo.h"
+#include "../src/examples/simple.cpp"
+#include "../src/examples/circadian_oscillator.cpp"
+#include "../src/examples/seihr.cpp"
+#include "../src/examples/static_examples.cpp"
+#include "allocation_counter.h"
 
 // Solves requirement 9: Implement unit tests (e.g. test symbol table methods and pretty-printing of reaction rules).
 
@@ -68,6 +98,1370 @@ TEST(SymbolTableTest, Update) {
     EXPECT_EQ(actualValue, expectedValue);
 }
 
+TEST(CompiledNetworkTest, CatalystIsLeftOutOfStateChange) {
+    // Arrange
+    System s = System();
+
+    auto A = s("A", 100);
+    auto B = s("B", 0);
+    auto C = s("C", 2);
+    s(A + C >>= B + C, 0.001);
+
+    // Act
+    CompiledNetwork network(s);
+    auto state = network.initialState();
+    network.fire(0, state.data());
+
+    // Assert
+    EXPECT_EQ(network.changedSpecies(0).size(), 2);
+    EXPECT_DOUBLE_EQ(network.propensity(0, network.initialState().data()), 0.001 * 100 * 2);
+    EXPECT_EQ(state[network.speciesIndex("A")], 99);
+    EXPECT_EQ(state[network.speciesIndex("B")], 1);
+    EXPECT_EQ(state[network.speciesIndex("C")], 2);
+}
+
+TEST(MultilevelMonteCarloTest, BirthDeathMeanWithinStandardErrors) {
+    // Arrange
+    System s = System();
+
+    auto G = s("G", 1);
+    auto X = s("X", 0);
+    auto Y = s("Y", 0);
+    s(G >>= G + X, 10.0);
+    s(X >>= Y, 0.5);
+
+    struct FinalAmount : StateMonitor {
+        int x = 0;
+        void operator()(const CompiledNetwork& network, std::span<const int> state, double) override {
+            x = state[network.speciesIndex("X")];
+        }
+    };
+
+    MultilevelMonteCarlo<FinalAmount> mlmc(s, [] { return std::make_unique<FinalAmount>(); },
+                                           [](const FinalAmount& monitor) { return monitor.x; },
+                                           {.end_time = 10, .coarsest_step = 1.0, .refinement = 4, .tau_levels = 2,
+                                            .pilot_samples = 64, .target_rmse = 0.3, .num_threads = 4, .seed = 7});
+
+    // Act
+    const auto result = mlmc.run();
+
+    // Assert
+    // E[X(t)] = k/γ (1 - e^(-γt)) for a birth-death process started empty
+    const double expected = 10.0 / 0.5 * (1 - std::exp(-0.5 * 10));
+    ASSERT_EQ(result.levels.size(), 3);
+    EXPECT_GT(result.standard_error, 0);
+    EXPECT_LT(result.standard_error, 0.5);
+    EXPECT_NEAR(result.estimate, expected, 4 * result.standard_error);
+}
+
+TEST(FspSolverTest, DecayMatchesExponential) {
+    // Arrange
+    System s = System();
+
+    auto A = s("A", 1);
+    auto B = s("B", 0);
+    s(A >>= B, 0.5);
+
+    FspSolver fsp(s);
+
+    // Act
+    auto result = fsp.solve(2.0);
+
+    // Assert
+    EXPECT_EQ(fsp.numStates(), 2);
+    EXPECT_NEAR(fsp.mean(result, "A"), std::exp(-1.0), 1e-9);
+    EXPECT_NEAR(result.truncation_error, 0.0, 1e-9);
+}
+
+TEST(ScheduleTest, InjectionAndRateChangeAreApplied) {
+    // Arrange
+    System s = System();
+
+    auto A = s("A", 10);
+    auto B = s("B", 0);
+    auto decay = s(A >>= B, 0.0);
+    s.schedule(decay, 5.0, 1000.0);
+    s.inject(A, 2.0, 5);
+
+    struct LastState : StateMonitor {
+        std::vector<int> state;
+        void operator()(const CompiledNetwork&, std::span<const int> x, double) override { state.assign(x.begin(), x.end()); }
+    } monitor;
+
+    CompiledNetwork network(s);
+    UniformizationSimulator simulator(network, 10.0, 1);
+
+    // Act
+    simulator.simulate(monitor);
+
+    // Assert
+    EXPECT_EQ(monitor.state[network.speciesIndex("A")], 0);
+    EXPECT_EQ(monitor.state[network.speciesIndex("B")], 15);
+}
+
+TEST(ScheduleTest, EveryEngineAppliesOrRejectsSchedules) {
+    // Arrange
+    System s = System();
+
+    auto A = s("A", 10);
+    auto B = s("B", 0);
+    auto decay = s(A >>= B, 0.0);
+    s.schedule(decay, 5.0, 1000.0);
+    s.inject(A, 2.0, 5);
+
+    struct LastState : StateMonitor {
+        std::vector<int> state;
+        void operator()(const CompiledNetwork&, std::span<const int> x, double) override { state.assign(x.begin(), x.end()); }
+    };
+
+    const CompiledNetwork network(s);
+    const auto a = network.speciesIndex("A");
+    const auto b = network.speciesIndex("B");
+    const ReplicatedNetwork population(s, 2);
+    const Metapopulation regions(s, 2);
+
+    // Act
+    std::map<std::string, int> system_state;
+    Simulator(s, 10.0, 1).simulate([&](const System& system, double) {
+        system_state = {{"A", system.amount(A)}, {"B", system.amount(B)}};
+    });
+    LastState uniformization, adaptive, replicated;
+    UniformizationSimulator(network, 10.0, 1).simulate(uniformization);
+    AdaptiveSimulator(network, 10.0, 1).simulate(adaptive);
+    ReplicatedSimulator(population, 10.0, 1).simulate(replicated);
+
+    // Assert
+    // Engines that apply schedules: the injection adds 5 to A, and the rate change then drains all of A into B
+    EXPECT_EQ(system_state["A"], 0);
+    EXPECT_EQ(system_state["B"], 15);
+    for (const auto* monitor : {&uniformization, &adaptive}) {
+        EXPECT_EQ(monitor->state[a], 0);
+        EXPECT_EQ(monitor->state[b], 15);
+    }
+    // The replicated engine reports totals over its two instances
+    EXPECT_EQ(replicated.state[a], 0);
+    EXPECT_EQ(replicated.state[b], 30);
+
+    // Engines that do not refuse the network instead of running it without the schedule
+    EXPECT_THROW(TauLeapSimulator(network, 10.0, 0.1, 1), std::runtime_error);
+    EXPECT_THROW(TimeWarpSimulator(network, 10.0, 1, 2), std::runtime_error);
+    EXPECT_THROW(SpatialSimulator(regions, 10.0, 1), std::runtime_error);
+    EXPECT_THROW(RreSolver rre(s), std::runtime_error);
+    EXPECT_THROW(FspSolver fsp(s), std::runtime_error);
+    auto monitor_factory = [] { return std::make_unique<LastState>(); };
+    auto quantity = [](const LastState& monitor) { return static_cast<double>(monitor.state[0]); };
+    EXPECT_THROW(MultilevelMonteCarlo<LastState>(s, monitor_factory, quantity, {}), std::runtime_error);
+}
+
+TEST(RreSolverTest, DecayMatchesExponential) {
+    // Arrange
+    System s = System();
+
+    auto A = s("A", 1000);
+    auto B = s("B", 0);
+    s(A >>= B, 0.5);
+
+    RreSolver rre(s, {.relative_tolerance = 1e-9, .absolute_tolerance = 1e-9});
+
+    // Act
+    auto trajectory = rre.solve(4.0, 1.0);
+
+    // Assert
+    ASSERT_EQ(trajectory.times.size(), 5);
+    EXPECT_NEAR(trajectory.of("A").back(), 1000 * std::exp(-2.0), 1e-5);
+    EXPECT_NEAR(trajectory.of("B").back(), 1000 * (1 - std::exp(-2.0)), 1e-5);
+}
+
+TEST(RreSolverTest, RejectsInvalidTimes) {
+    // Arrange
+    System s = System();
+
+    auto A = s("A", 1000);
+    auto B = s("B", 0);
+    s(A >>= B, 0.5);
+
+    RreSolver rre(s);
+
+    // Act & Assert
+    EXPECT_THROW((void)rre.solve(4.0, 0.0), std::invalid_argument);
+    EXPECT_THROW((void)rre.solve(4.0, -1.0), std::invalid_argument);
+    EXPECT_THROW((void)rre.solve(4.0, NAN), std::invalid_argument);
+    EXPECT_THROW((void)rre.solve(NAN, 1.0), std::invalid_argument);
+    EXPECT_THROW((void)rre.solve(INFINITY, 1.0), std::invalid_argument);
+}
+
+TEST(IndexedPriorityQueueTest, TopFollowsUpdates) {
+    // Arrange
+    IndexedPriorityQueue queue(4);
+
+    // Act
+    queue.update(0, 5.0);
+    queue.update(1, 3.0);
+    queue.update(2, 4.0);
+    queue.update(1, 6.0);
+
+    // Assert
+    EXPECT_EQ(queue.top(), 2);
+    EXPECT_DOUBLE_EQ(queue.topKey(), 4.0);
+    EXPECT_DOUBLE_EQ(queue.key(1), 6.0);
+}
+
+TEST(SpatialSimulatorTest, ConservesMassAndApproachesWellMixedLimit) {
+    // Arrange
+    // A and B start in different regions and can only react after migrating; with fast migration the four regions
+    // behave as one well-mixed volume with a quarter of the local rate constant
+    System local = System();
+
+    auto A = local("A", 0);
+    auto B = local("B", 0);
+    auto C = local("C", 0);
+    local(A + B >>= C, 0.01);
+
+    Metapopulation regions(local, 4);
+    regions.setAmount(0, "A", 400);
+    regions.setAmount(1, "B", 400);
+    for (size_t from = 0; from < 4; ++from) {
+        for (size_t to = 0; to < 4; ++to) {
+            if (from != to) {
+                regions.addMigration(from, to, "A", 5.0);
+                regions.addMigration(from, to, "B", 5.0);
+            }
+        }
+    }
+    regions.addMigration(2, 3, "C", 1.0);  // the only edge of C
+
+    System mixed = System();
+    auto mixed_A = mixed("A", 400);
+    auto mixed_B = mixed("B", 400);
+    auto mixed_C = mixed("C", 0);
+    mixed(mixed_A + mixed_B >>= mixed_C, 0.01 / 4);
+
+    struct Totals : StateMonitor {
+        bool conserved = true;
+        std::vector<int> last;
+        void operator()(const CompiledNetwork&, std::span<const int> x, double) override {
+            conserved = conserved && x[0] + x[2] == 400 && x[1] + x[2] == 400 && x[0] >= 0 && x[1] >= 0;
+            last.assign(x.begin(), x.end());
+        }
+    } serial_totals, parallel_totals;
+
+    SpatialSimulator serial(regions, 2.0, 42);
+    SpatialSimulator parallel(regions, 2.0, 42, 2, 0.002);
+
+    // Act
+    serial.simulate(serial_totals);
+    parallel.simulate(parallel_totals);
+    const double expected_A = RreSolver(mixed).solve(2.0, 2.0).of("A").back();
+
+    // Assert
+    for (const auto* simulator : {&serial, &parallel}) {
+        const auto& state = simulator->state();
+        int a = 0, b = 0, c = 0;
+        for (size_t region = 0; region < 4; ++region) {
+            EXPECT_GE(*std::min_element(state.begin() + 3 * region, state.begin() + 3 * region + 3), 0);
+            a += state[3 * region];
+            b += state[3 * region + 1];
+            c += state[3 * region + 2];
+        }
+        EXPECT_EQ(a + c, 400);
+        EXPECT_EQ(b + c, 400);
+        EXPECT_GT(simulator->events(), 0);
+    }
+    EXPECT_TRUE(serial_totals.conserved);
+    EXPECT_TRUE(parallel_totals.conserved);
+    // 400 / (1 + 400 * 0.0025 * t) in the well-mixed limit; a short lag while A and B spread out keeps it a bit higher
+    EXPECT_NEAR(expected_A, 400.0 / 3.0, 0.5);
+    EXPECT_NEAR(serial_totals.last[0], expected_A, 0.15 * expected_A);
+    EXPECT_NEAR(parallel_totals.last[0], expected_A, 0.15 * expected_A);
+}
+
+TEST(TimeWarpTest, CommittedStateConservesMassAcrossBlocks) {
+    // Arrange
+    System s = System();
+
+    auto A = s("A", 500);
+    auto B = s("B", 500);
+    s(A >>= B, 1.0);
+    s(B >>= A, 1.0);
+
+    const CompiledNetwork network(s);
+
+    struct TotalMonitor : StateMonitor {
+        std::vector<int> totals;
+        void operator()(const CompiledNetwork&, std::span<const int> state, double) override {
+            totals.push_back(state[0] + state[1]);
+        }
+    } monitor;
+
+    TimeWarpSimulator simulator(network, 5.0, 42, 2, {.gvt_interval = 50,
+                                                      .optimism_window = std::numeric_limits<double>::infinity(),
+                                                      .locality = nullptr});
+
+    // Act
+    simulator.simulate(monitor);
+
+    // Assert
+    EXPECT_NE(simulator.owners()[0], simulator.owners()[1]);
+    EXPECT_GT(simulator.stats().messages, 0);
+    ASSERT_FALSE(monitor.totals.empty());
+    for (auto total : monitor.totals) {
+        EXPECT_EQ(total, 1000);
+    }
+    // Every molecule flips at rate 1, so about 1000 events per time unit
+    EXPECT_NEAR(static_cast<double>(simulator.stats().committed_events), 5000.0, 400.0);
+}
+
+TEST(AdaptiveSimulatorTest, ChoosesEngineFromStatistics) {
+    // Arrange
+    NetworkStatistics small{.reactions = 5, .mean_fanout = 3};
+    NetworkStatistics narrow{.reactions = 1000, .mean_fanout = 3, .propensity_octaves = 8};
+    NetworkStatistics wide{.reactions = 1000, .mean_fanout = 3, .propensity_octaves = 40};
+    NetworkStatistics abundant{.reactions = 1000, .mean_fanout = 3, .leap_gain = 50};
+
+    // Act & Assert
+    EXPECT_EQ(AdaptiveSimulator::choose(small, {}).first, EngineKind::Direct);
+    EXPECT_EQ(AdaptiveSimulator::choose(narrow, {}).first, EngineKind::CompositionRejection);
+    EXPECT_EQ(AdaptiveSimulator::choose(wide, {}).first, EngineKind::NextReaction);
+    EXPECT_EQ(AdaptiveSimulator::choose(abundant, {}).first, EngineKind::TauLeaping);
+}
+
+TEST(AdaptiveSimulatorTest, SwitchesToLeapingAsPopulationsGrow) {
+    // Arrange
+    System s = System();
+
+    auto A = s("A", 10);
+    s(A >>= A + A, 1.0);
+
+    const CompiledNetwork network(s);
+
+    struct LastMonitor : StateMonitor {
+        int last = 0;
+        void operator()(const CompiledNetwork&, std::span<const int> state, double) override { last = state[0]; }
+    } monitor;
+
+    AdaptiveSimulator simulator(network, 5.0, 42);
+
+    // Act
+    simulator.simulate(monitor);
+
+    // Assert
+    const auto& decisions = simulator.metadata().decisions;
+    ASSERT_GE(decisions.size(), 2);
+    EXPECT_EQ(decisions.front().engine, EngineKind::Direct);
+    EXPECT_EQ(decisions.back().engine, EngineKind::TauLeaping);
+    EXPECT_GT(simulator.metadata().leaps, 0);
+    // Pure birth from 10 at rate 1 has mean 10 e^5 ≈ 1484 and standard deviation ≈ 468
+    EXPECT_GT(monitor.last, 200);
+}
+
+TEST(AdaptiveSimulatorTest, ForcedExactEnginesMatchBirthDeathDistribution) {
+    // Arrange
+    // Two independent birth-death processes whose propensities span several powers of two, so composition-rejection
+    // moves the death channels between groups as the populations change
+    System s = System();
+
+    auto G = s("G", 1);
+    auto X = s("X", 0);
+    auto Y = s("Y", 0);
+    auto Z = s("Z", 0);
+    s(G >>= G + X, 4.0);
+    s(X >>= Z, 0.2);
+    s(G >>= G + Y, 40.0);
+    s(Y >>= Z, 1.0);
+
+    const CompiledNetwork network(s);
+    const auto x = network.speciesIndex("X");
+    const auto y = network.speciesIndex("Y");
+
+    struct LastState : StateMonitor {
+        std::vector<int> state;
+        void operator()(const CompiledNetwork&, std::span<const int> st, double) override { state.assign(st.begin(), st.end()); }
+    };
+
+    constexpr size_t replicas = 200;
+    constexpr double end_time = 10;
+
+    for (const auto engine : {EngineKind::NextReaction, EngineKind::CompositionRejection}) {
+        // Act
+        double sum_x = 0, sum_xx = 0, sum_y = 0, sum_yy = 0;
+        for (unsigned seed = 0; seed < replicas; ++seed) {
+            LastState monitor;
+            AdaptiveOptions options;
+            options.engine = engine;
+            AdaptiveSimulator simulator(network, end_time, seed, options);
+            simulator.simulate(monitor);
+            ASSERT_EQ(simulator.metadata().decisions.size(), 1);
+            ASSERT_EQ(simulator.metadata().decisions.front().engine, engine);
+            sum_x += monitor.state[x];
+            sum_xx += monitor.state[x] * monitor.state[x];
+            sum_y += monitor.state[y];
+            sum_yy += monitor.state[y] * monitor.state[y];
+        }
+
+        // Assert
+        // Started empty, X(t) is Poisson with mean k/γ (1 - e^(-γt)), so its variance equals its mean
+        const double mean_x = 4.0 / 0.2 * (1 - std::exp(-0.2 * end_time));
+        const double mean_y = 40.0 / 1.0 * (1 - std::exp(-1.0 * end_time));
+        const double sample_mean_x = sum_x / replicas, sample_mean_y = sum_y / replicas;
+        const double sample_var_x = (sum_xx - sum_x * sum_x / replicas) / (replicas - 1);
+        const double sample_var_y = (sum_yy - sum_y * sum_y / replicas) / (replicas - 1);
+        SCOPED_TRACE(std::string(to_string(engine)));
+        EXPECT_NEAR(sample_mean_x, mean_x, 4 * std::sqrt(mean_x / replicas));
+        EXPECT_NEAR(sample_mean_y, mean_y, 4 * std::sqrt(mean_y / replicas));
+        EXPECT_NEAR(sample_var_x / mean_x, 1.0, 0.4);
+        EXPECT_NEAR(sample_var_y / mean_y, 1.0, 0.4);
+    }
+}
+
+TEST(ReplicatedSimulatorTest, InstancesShareTemplateAndCouplingsMoveBetweenThem) {
+    // Arrange
+    System cell = System();
+
+    auto A = cell("A", 50);
+    auto B = cell("B", 0);
+    cell(A >>= B, 1.0);
+
+    ReplicatedNetwork population(cell, 3);
+    population.setAmount(2, "A", 0);
+    population.addCoupling({population.site(0, "B")}, {population.site(2, "B")}, 1.0);
+
+    struct TotalMonitor : StateMonitor {
+        std::vector<int> totals;
+        void operator()(const CompiledNetwork&, std::span<const int> state, double) override {
+            totals.push_back(state[0] + state[1]);
+        }
+    } monitor;
+
+    ReplicatedSimulator simulator(population, 20.0, 42);
+
+    // Act
+    simulator.simulate(monitor);
+
+    // Assert
+    for (auto total : monitor.totals) {
+        EXPECT_EQ(total, 100);
+    }
+    EXPECT_EQ(simulator.events(), 100);
+    EXPECT_EQ(simulator.instance(1)[1], 50);
+    EXPECT_EQ(simulator.instance(0)[1] + simulator.instance(2)[1], 50);
+    EXPECT_GT(simulator.couplingEvents(), 0);
+    EXPECT_EQ(simulator.instance(2)[1], static_cast<int>(simulator.couplingEvents()));
+}
+
+TEST(StaticNetworkTest, KernelFollowsSameTrajectoryAsCompiledNetwork) {
+    // Arrange
+    const auto kernel = seihr_static(1000);
+    const CompiledNetwork network(seihr(1000));
+
+    struct LastMonitor : StateMonitor {
+        std::vector<int> last;
+        void operator()(const CompiledNetwork&, std::span<const int> state, double) override {
+            last.assign(state.begin(), state.end());
+        }
+    } monitor;
+    static_seihr::Model::State last{};
+
+    AdaptiveSimulator simulator(network, 50, 7, {.engine = EngineKind::Direct});
+
+    // Act
+    simulator.simulate(monitor);
+    kernel.simulate(50, 7, [&last](const auto& state, double) { last = state; });
+
+    // Assert
+    static_assert(static_seihr::Model::num_species == 5 && static_seihr::Model::num_reactions == 5);
+    ASSERT_EQ(monitor.last.size(), last.size());
+    const std::pair<std::string, size_t> species[] = {{"S", static_seihr::S.index}, {"E", static_seihr::E.index},
+        {"I", static_seihr::I.index}, {"H", static_seihr::H.index}, {"R", static_seihr::R.index}};
+    for (const auto& [name, index] : species) {
+        SCOPED_TRACE(name);
+        EXPECT_EQ(monitor.last[network.speciesIndex(name)], last[index]);
+    }
+}
+
+TEST(GeneratedKernelTest, CompiledKernelMatchesStaticKernelAndIsCached) {
+    // Arrange
+    const CompiledNetwork network(seihr(1000));
+    const auto kernel = seihr_static(1000);
+    const auto cache_dir = std::filesystem::temp_directory_path() / "generated_kernel_test";
+    std::filesystem::remove_all(cache_dir);
+
+    struct LastMonitor : StateMonitor {
+        std::vector<int> last;
+        void operator()(const CompiledNetwork&, std::span<const int> state, double) override {
+            last.assign(state.begin(), state.end());
+        }
+    } monitor;
+    static_seihr::Model::State last{};
+
+    // Act
+    const GeneratedKernel generated(network, {.cache_dir = cache_dir});
+    const GeneratedKernel reloaded(network, {.cache_dir = cache_dir});
+    GeneratedSimulator simulator(generated, 50, 7);
+    simulator.simulate(monitor);
+    const auto events = kernel.simulate(50, 7, [&last](const auto& state, double) { last = state; });
+
+    // Assert
+    EXPECT_FALSE(generated.cached());
+    EXPECT_TRUE(reloaded.cached());
+    EXPECT_EQ(generated.library(), reloaded.library());
+    EXPECT_EQ(simulator.events(), events);
+    ASSERT_EQ(monitor.last.size(), last.size());
+    const std::pair<std::string, size_t> species[] = {{"S", static_seihr::S.index}, {"E", static_seihr::E.index},
+        {"I", static_seihr::I.index}, {"H", static_seihr::H.index}, {"R", static_seihr::R.index}};
+    for (const auto& [name, index] : species) {
+        SCOPED_TRACE(name);
+        EXPECT_EQ(monitor.last[network.speciesIndex(name)], last[index]);
+    }
+    std::filesystem::remove_all(cache_dir);
+}
+
+TEST(GeneratedKernelTest, RefusesCacheOthersCanWrite) {
+    // Arrange
+    const CompiledNetwork network(seihr(1000));
+    const auto cache_dir = std::filesystem::temp_directory_path() / "generated_kernel_shared_test";
+    std::filesystem::remove_all(cache_dir);
+    std::filesystem::create_directory(cache_dir);
+    std::filesystem::permissions(cache_dir, std::filesystem::perms::all);
+
+    // Act & Assert
+    EXPECT_THROW(GeneratedKernel(network, {.cache_dir = cache_dir}), std::runtime_error);
+    EXPECT_TRUE(std::filesystem::is_empty(cache_dir));
+    std::filesystem::remove_all(cache_dir);
+}
+
+TEST(NetworkFormatTest, ParsedTextCompilesToSameNetworkAsSystem) {
+    // Arrange
+    const CompiledNetwork expected(seihr(10000));
+    std::ostringstream text;
+    text << "# SEIHR written by hand, species in the order CompiledNetwork(System) uses\n"
+            "param N = 10000\n"
+            "param gamma = 1 / 3.1\n"
+            "param P_H = 0.9e-3\n"
+            "species E = 135, H, I = 9\n"
+            "species R, S = N - 135 - 9   # the rest are susceptible\n"
+            "S + I -> E + I @ 2.4 * gamma / N\n"
+            "E -> I @ 1.0 / 5.1\n"
+            "I -> R @ gamma\n"
+            "I -> H @ gamma * P_H * (1.0 - P_H)\n"
+            "H -> R @ 1.0 / 10.12\n";
+
+    // Act
+    const auto network = parse_network(text.str());
+    std::ostringstream written;
+    write_network(written, network);
+    const auto reloaded = parse_network(written.str());
+
+    // Assert
+    ASSERT_EQ(network.speciesNames(), expected.speciesNames());
+    EXPECT_EQ(network.initialState(), expected.initialState());
+    ASSERT_EQ(network.numReactions(), expected.numReactions());
+    for (size_t r = 0; r < network.numReactions(); ++r) {
+        EXPECT_DOUBLE_EQ(network.rate(r), expected.rate(r));
+        EXPECT_TRUE(std::ranges::equal(network.reactants(r), expected.reactants(r)));
+        EXPECT_TRUE(std::ranges::equal(network.changeDeltas(r), expected.changeDeltas(r)));
+        EXPECT_TRUE(std::ranges::equal(network.dependents(r), expected.dependents(r)));
+        EXPECT_EQ(reloaded.rate(r), network.rate(r));
+        EXPECT_TRUE(std::ranges::equal(reloaded.changedSpecies(r), network.changedSpecies(r)));
+    }
+}
+
+TEST(NetworkFormatTest, SourceAndSinkReactionsRoundTrip) {
+    // Arrange
+    const auto network = parse_network("species X = 3, Y\n"
+                                       "0 -> X @ 2\n"
+                                       "X -> 0 @ 0.5\n"
+                                       "X + Y -> 0 @ 0.1\n");
+
+    // Act
+    std::ostringstream written;
+    write_network(written, network);
+    const auto reloaded = parse_network(written.str());
+
+    // Assert
+    EXPECT_NE(written.str().find("0 -> X @"), std::string::npos);
+    EXPECT_NE(written.str().find("X -> 0 @"), std::string::npos);
+    EXPECT_TRUE(network.reactants(0).empty());
+    ASSERT_EQ(reloaded.numReactions(), 3u);
+    EXPECT_EQ(reloaded.initialState(), network.initialState());
+    for (size_t r = 0; r < network.numReactions(); ++r) {
+        EXPECT_EQ(reloaded.rate(r), network.rate(r));
+        EXPECT_TRUE(std::ranges::equal(reloaded.reactants(r), network.reactants(r)));
+        EXPECT_TRUE(std::ranges::equal(reloaded.changedSpecies(r), network.changedSpecies(r)));
+        EXPECT_TRUE(std::ranges::equal(reloaded.changeDeltas(r), network.changeDeltas(r)));
+    }
+}
+
+TEST(NetworkFormatTest, ErrorsReportLineAndColumn) {
+    // Arrange
+    const std::pair<std::string, std::pair<size_t, size_t>> cases[] = {
+        {"species A\nA -> B @ 1\n", {2, 6}},
+        {"param k = 2\nspecies A\n\nA -> A @ k * q\n", {4, 14}},
+        {"species A = -1\n", {1, 13}},
+        {"species A, B\nA B -> A @ 1\n", {2, 3}},
+        {"species A, A\n", {1, 12}},
+    };
+
+    for (const auto& [text, position] : cases) {
+        SCOPED_TRACE(text);
+        try {
+            // Act
+            parse_network(text);
+            ADD_FAILURE() << "no error";
+        } catch (const NetworkParseError& e) {
+            // Assert
+            EXPECT_EQ(e.line(), position.first);
+            EXPECT_EQ(e.column(), position.second);
+        }
+    }
+}
+
+TEST(NetworkImageTest, MappedImageMatchesBuiltNetwork) {
+    // Arrange
+    const CompiledNetwork built(seihr_lockdown(10000, 20, 60, 0.6));
+    const auto path = std::filesystem::temp_directory_path() / "network_image_test.bin";
+
+    struct LastMonitor : StateMonitor {
+        std::vector<int> last;
+        void operator()(const CompiledNetwork&, std::span<const int> state, double) override {
+            last.assign(state.begin(), state.end());
+        }
+    } expected, actual;
+
+    // Act
+    built.saveImage(path);
+    const auto mapped = CompiledNetwork::mapImage(path);
+    const CompiledNetwork copy = mapped;
+    AdaptiveSimulator(built, 100, 3, {.engine = EngineKind::NextReaction}).simulate(expected);
+    AdaptiveSimulator(copy, 100, 3, {.engine = EngineKind::NextReaction}).simulate(actual);
+
+    // Assert
+    EXPECT_EQ(mapped.speciesNames(), built.speciesNames());
+    EXPECT_EQ(mapped.initialState(), built.initialState());
+    ASSERT_EQ(mapped.numReactions(), built.numReactions());
+    for (size_t r = 0; r < built.numReactions(); ++r) {
+        EXPECT_EQ(mapped.rate(r), built.rate(r));
+        EXPECT_TRUE(std::ranges::equal(mapped.reactants(r), built.reactants(r)));
+        EXPECT_TRUE(std::ranges::equal(mapped.changedSpecies(r), built.changedSpecies(r)));
+        EXPECT_TRUE(std::ranges::equal(mapped.changeDeltas(r), built.changeDeltas(r)));
+        EXPECT_TRUE(std::ranges::equal(mapped.dependents(r), built.dependents(r)));
+    }
+    for (size_t s = 0; s < built.numSpecies(); ++s) {
+        EXPECT_TRUE(std::ranges::equal(mapped.readers(s), built.readers(s)));
+    }
+    ASSERT_EQ(mapped.scheduledEvents().size(), built.scheduledEvents().size());
+    EXPECT_EQ(actual.last, expected.last);
+    std::filesystem::remove(path);
+}
+
+TEST(NetworkImageTest, RejectsCorruptIndexArrays) {
+    // Arrange
+    const CompiledNetwork built(seihr_lockdown(1000, 20, 60, 0.6));
+    const auto path = std::filesystem::temp_directory_path() / "network_image_corrupt_test.bin";
+    built.saveImage(path);
+    std::string image(std::filesystem::file_size(path), '\0');
+    std::ifstream(path, std::ios::binary).read(image.data(), static_cast<std::streamsize>(image.size()));
+    Header header{};
+    std::memcpy(&header, image.data(), sizeof(header));
+    const auto species = static_cast<uint32_t>(built.numSpecies()), reactions = static_cast<uint32_t>(built.numReactions());
+    const std::pair<Section, std::pair<size_t, uint32_t>> corruptions[] = {
+        {ReactantSpecies, {0, species}},
+        {ChangeSpecies, {0, species + 7}},
+        {DependentReactions, {0, reactions}},
+        {ReaderReactions, {0, UINT32_MAX}},
+        {ReactantOffsets, {1, UINT32_MAX}},
+        {ChangeOffsets, {0, 1}},
+    };
+    // Header counts that wrap the size arithmetic (2^61 events of 24 bytes are 0 bytes modulo 2^64), and events
+    // that target nothing or happen at no time
+    ASSERT_FALSE(built.scheduledEvents().empty());
+    const size_t first_event = header.sections[Events].offset;
+    const uint32_t no_target = species + reactions;
+    const double no_time = std::numeric_limits<double>::quiet_NaN();
+    auto with_header = [&header](auto change) {
+        return [header, change](std::string& bytes) mutable {
+            change(header);
+            std::memcpy(bytes.data(), &header, sizeof(header));
+        };
+    };
+    const std::pair<std::string, std::function<void(std::string&)>> header_corruptions[] = {
+        {"species count", with_header([](Header& h) { h.num_species = UINT64_MAX; })},
+        {"event count", with_header([](Header& h) {
+            h.num_events = uint64_t{1} << 61;
+            h.sections[Events].size = 0;
+        })},
+        {"event target", [&](std::string& bytes) {
+            std::memcpy(bytes.data() + first_event + offsetof(PackedEvent, target), &no_target, sizeof(no_target));
+        }},
+        {"event time", [&](std::string& bytes) {
+            std::memcpy(bytes.data() + first_event + offsetof(PackedEvent, time), &no_time, sizeof(no_time));
+        }},
+    };
+    auto rejects = [&path](const std::string& corrupt) {
+        std::ofstream(path, std::ios::binary).write(corrupt.data(), static_cast<std::streamsize>(corrupt.size()));
+        // Act & Assert
+        EXPECT_THROW(CompiledNetwork::mapImage(path), std::runtime_error);
+    };
+
+    for (const auto& [section, entry] : corruptions) {
+        SCOPED_TRACE(section);
+        std::string corrupt = image;
+        std::memcpy(corrupt.data() + header.sections[section].offset + entry.first * sizeof(uint32_t), &entry.second,
+                    sizeof(uint32_t));
+        rejects(corrupt);
+    }
+    for (const auto& [name, corrupt_header] : header_corruptions) {
+        SCOPED_TRACE(name);
+        std::string corrupt = image;
+        corrupt_header(corrupt);
+        rejects(corrupt);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(NetworkGeneratorTest, ScaleFreeNetworkHasRequestedShapeAndConservesMolecules) {
+    // Arrange
+    const NetworkShape shape{.species = 50, .reactions = 400, .rate_spread = 3, .seed = 7};
+
+    // Act
+    const auto network = scale_free_network(shape);
+    const auto again = scale_free_network(shape);
+    const auto other = scale_free_network({.species = 50, .reactions = 400, .rate_spread = 3, .seed = 8});
+
+    // Assert
+    EXPECT_EQ(network.numSpecies(), 50);
+    ASSERT_EQ(network.numReactions(), 400);
+    bool same = true, same_as_other = true;
+    for (size_t r = 0; r < network.numReactions(); ++r) {
+        const auto deltas = network.changeDeltas(r);
+        EXPECT_EQ(std::accumulate(deltas.begin(), deltas.end(), 0), 0);
+        EXPECT_GT(network.rate(r), 0);
+        same = same && network.rate(r) == again.rate(r) && std::ranges::equal(network.reactants(r), again.reactants(r));
+        same_as_other = same_as_other && network.rate(r) == other.rate(r);
+    }
+    EXPECT_TRUE(same);
+    EXPECT_FALSE(same_as_other);
+    EXPECT_EQ(metapopulation_seihr(8, 1000, 0.01, 1).numReactions(), 8 * 13);
+    EXPECT_EQ(gene_cascade(8, 1, 1).numSpecies(), 1 + 8 * 4);
+}
+
+TEST(ScalingHarnessTest, StatisticsAndScalingMetrics) {
+    // Arrange
+    std::vector<ScalingPoint> points(3);
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i].threads = size_t{1} << i;
+        // Perfect strong scaling, with the same relative spread at every thread count
+        for (double x : {0.9, 1.0, 1.1, 1.2, 0.8}) {
+            points[i].seconds.push_back(x / static_cast<double>(points[i].threads));
+        }
+    }
+    struct NullMonitor : Monitor {
+        void operator()(const System&, double) override {}
+    };
+    ScalingHarness<NullMonitor> harness([] { return simple(); }, [] { return std::make_unique<NullMonitor>(); },
+                                        2000, {.threads = {2, 1}, .repeats = 3});
+
+    // Act
+    const auto summary = summarize({4, 1, 3, 2, 5}, 0.95, 500, 1);
+    analyze_scaling(points, ScalingMode::Strong, {});
+    const auto measured = harness.weak(2);
+
+    // Assert
+    EXPECT_DOUBLE_EQ(summary.median, 3);
+    EXPECT_DOUBLE_EQ(summary.iqr(), 2);
+    EXPECT_LE(summary.ci_low, summary.median);
+    EXPECT_GE(summary.ci_high, summary.median);
+    EXPECT_NEAR(karp_flatt(3, 4), 1.0 / 9, 1e-12);
+    for (const auto& point : points) {
+        EXPECT_NEAR(point.speedup, static_cast<double>(point.threads), 1e-9);
+        EXPECT_NEAR(point.efficiency, 1, 1e-9);
+        EXPECT_LE(point.speedup_ci_low, point.speedup);
+        EXPECT_GE(point.speedup_ci_high, point.speedup);
+    }
+    EXPECT_TRUE(std::isnan(points[0].karp_flatt));
+    EXPECT_NEAR(points[2].karp_flatt, 0, 1e-9);
+    ASSERT_EQ(measured.size(), 2);
+    EXPECT_EQ(measured[0].threads, 1);
+    EXPECT_EQ(measured[1].replicas, 4);
+    EXPECT_EQ(measured[1].seconds.size(), 3);
+}
+
+TEST(InstrumentationTest, CountsMatchEngineMetadataWhenEnabled) {
+    // Arrange
+    const CompiledNetwork network(seihr(1000));
+    struct Discard : StateMonitor {
+        void operator()(const CompiledNetwork&, std::span<const int>, double) override {}
+    } monitor;
+    AdaptiveSimulator simulator(network, 100, 5, {.engine = EngineKind::NextReaction});
+    instrumentation::reset();
+
+    // Act
+    simulator.simulate(monitor);
+    const auto counters = instrumentation::snapshot();
+    std::ostringstream report;
+    report << std::setprecision(4);
+    instrumentation::report(report);
+
+    // Assert
+    EXPECT_EQ(report.precision(), 4);
+    EXPECT_EQ(report.flags() & (std::ios::floatfield | std::ios::adjustfield), std::ios::fmtflags{});
+    if (instrumentation::enabled) {
+        EXPECT_EQ(counters.count(instrumentation::Counter::Events), simulator.metadata().exact_events);
+        EXPECT_EQ(counters.entries[static_cast<size_t>(instrumentation::Phase::MonitorCallback)], simulator.metadata().exact_events);
+        EXPECT_GT(counters.count(instrumentation::Counter::HeapOperations), simulator.metadata().exact_events);
+        EXPECT_GT(counters.nanoseconds(instrumentation::Phase::Selection), 0);
+    } else {
+        EXPECT_EQ(counters.count(instrumentation::Counter::Events), 0);
+        EXPECT_EQ(counters.threads, 0);
+    }
+}
+
+TEST(PerfCountersTest, CountsOrExplainsWhyNot) {
+    // Arrange
+    PerfCounters perf;
+    volatile double sink = 0;
+
+    // Act
+    perf.start();
+    for (int i = 0; i < 100000; ++i) {
+        sink = sink + i;
+    }
+    const auto sample = perf.stop();
+    std::ostringstream os;
+    os << sample;
+
+    // Assert
+    if (perf.available()) {
+        EXPECT_TRUE(std::any_of(sample.values.begin(), sample.values.end(), [](double x) { return x > 0; }));
+    } else {
+        EXPECT_FALSE(perf.why().empty());
+        EXPECT_TRUE(std::isnan(sample[PerfEvent::Cycles]));
+        EXPECT_NE(os.str().find("cycles n/a"), std::string::npos);
+    }
+}
+
+TEST(TelemetryTest, ParallelReplicasReportEventsAndProgress) {
+    // Arrange
+    struct NullMonitor : Monitor {
+        void operator()(const System&, double) override {}
+    };
+    const auto path = std::filesystem::temp_directory_path() / "telemetry_test.prom";
+    std::filesystem::remove(path);
+    TelemetrySnapshot snapshot;
+
+    // Act
+    {
+        Telemetry telemetry(2, {.metrics_file = path, .interval = std::chrono::milliseconds(5)});
+        ParallelSimulator<NullMonitor> simulator([] { return simple(); }, [] { return std::make_unique<NullMonitor>(); },
+                                                 100000, 6, 2, &telemetry);
+        simulator.simulate();
+        snapshot = telemetry.sample();
+    }
+    std::ifstream in(path);
+    const std::string metrics((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // Assert
+    // Simple runs until A is used up: 100 reactions per replica, all counted by the slot that ran it
+    ASSERT_EQ(snapshot.worker_events.size(), 2);
+    EXPECT_EQ(snapshot.worker_events[0] + snapshot.worker_events[1], 600);
+    for (size_t w = 0; w < 2; ++w) {
+        SCOPED_TRACE(w);
+        EXPECT_EQ(snapshot.worker_events[w] % 100, 0);
+        const auto line = "stochastic_simulator_worker_events_total{worker=\"" + std::to_string(w) + "\"} " +
+                          std::to_string(snapshot.worker_events[w]) + "\n";
+        EXPECT_NE(metrics.find(line), std::string::npos);
+    }
+    EXPECT_EQ(snapshot.replicas_completed, 6);
+    EXPECT_EQ(snapshot.queueDepth(), 0);
+    EXPECT_EQ(snapshot.running(), 0);
+    EXPECT_DOUBLE_EQ(snapshot.eta, 0);
+    EXPECT_NE(metrics.find("stochastic_simulator_replicas_completed_total 6\n"), std::string::npos);
+    EXPECT_NE(metrics.find("# TYPE stochastic_simulator_queue_depth gauge\n"), std::string::npos);
+    std::filesystem::remove(path);
+}
+
+TEST(TelemetryTest, ConsoleLineLeavesStreamFormatAlone) {
+    // Arrange
+    std::ostringstream console;
+    console << std::setprecision(4);
+
+    // Act
+    {
+        Telemetry telemetry(1, {.metrics_file = {}, .interval = std::chrono::milliseconds(1000), .console = &console});
+        telemetry.expectReplicas(1);
+    }
+    const auto line = console.str();
+    console << 1194.3;
+
+    // Assert
+    EXPECT_NE(line.find("0/1 replicas"), std::string::npos);
+    EXPECT_EQ(console.str().substr(line.size()), "1194");
+    EXPECT_EQ(console.precision(), 4);
+    EXPECT_FALSE(console.flags() & std::ios::fixed);
+}
+
+TEST(ArenaTest, TrajectoryMonitorRecordsRowsInReplicaArena) {
+    // Arrange
+    static_assert(ArenaMonitor<SpeciesTrajectoryMonitor>);
+    SpeciesTrajectoryMonitor serial;
+    ParallelSimulator<SpeciesTrajectoryMonitor> simulator([] { return simple(); },
+                                                          [] { return std::make_unique<SpeciesTrajectoryMonitor>(); },
+                                                          100000, 4, 2);
+
+    // Act
+    Simulator(simple(), 100000).simulate(std::ref(serial));
+    simulator.simulate();
+
+    // Assert
+    // Species in name order (A, B, C), and simple turns one A into one B per event, with C as the catalyst
+    ASSERT_EQ(serial.species().size(), 3);
+    EXPECT_EQ(serial.species()[0].getName(), "A");
+    EXPECT_EQ(serial.timePoints().size(), 100);
+    const auto a = serial.quantities(0), b = serial.quantities(1), c = serial.quantities(2);
+    ASSERT_EQ(a.size(), 100);
+    for (size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a[i], 99 - static_cast<double>(i));
+        EXPECT_EQ(a[i] + b[i], 100);
+        EXPECT_EQ(c[i], 2);
+    }
+    ASSERT_EQ(simulator.getMonitors().size(), 4);
+    for (const auto& monitor : simulator.getMonitors()) {
+        EXPECT_NE(monitor->timePoints().get_allocator().resource(), std::pmr::get_default_resource());
+        EXPECT_EQ(monitor->quantities(1), b);
+    }
+}
+
+TEST(ArenaTest, GrowsToHighWaterMarkAndServesReplicaMonitors) {
+    // Arrange
+    struct TimeMonitor : Monitor {
+        std::pmr::vector<double> times;
+        // A pmr container keeps its resource on assignment, so the (still empty) vector is rebuilt in place
+        void useMemoryResource(std::pmr::memory_resource* resource) {
+            std::destroy_at(&times);
+            std::construct_at(&times, resource);
+        }
+        void operator()(const System&, double t) override { times.push_back(t); }
+    };
+    static_assert(ArenaMonitor<TimeMonitor>);
+    ReplicaArena arena(1024);
+    ParallelSimulator<TimeMonitor> simulator([] { return simple(); }, [] { return std::make_unique<TimeMonitor>(); },
+                                             100000, 6, 2);
+
+    // Act
+    std::pmr::vector<int> first(4096, 0, arena.resource());
+    const auto overflowed = arena.overflows();
+    first = std::pmr::vector<int>(arena.resource());
+    arena.reset();
+    std::pmr::vector<int> second(4096, 0, arena.resource());
+    simulator.simulate();
+    simulator.simulate();
+
+    // Assert
+    EXPECT_GT(overflowed, 0);
+    EXPECT_GE(arena.capacity(), 4096 * sizeof(int));
+    EXPECT_EQ(arena.overflows(), overflowed);
+    ASSERT_EQ(simulator.getMonitors().size(), 6);
+    for (const auto& monitor : simulator.getMonitors()) {
+        EXPECT_NE(monitor->times.get_allocator().resource(), std::pmr::get_default_resource());
+        EXPECT_EQ(monitor->times.size(), 100);
+        EXPECT_TRUE(std::is_sorted(monitor->times.begin(), monitor->times.end()));
+    }
+    EXPECT_EQ(simulator.arenaOverflows(), 0);
+}
+
+TEST(PlacementTest, WorkersRunOnTheirNodeAndStayPinned) {
+    // Arrange
+    // Two nodes on whatever CPUs this machine lets us use, so the placement logic is exercised on one socket too
+    const auto machine = CpuTopology::detect();
+    const auto& cpus = machine.nodes.front();
+    const CpuTopology two_nodes{{cpus, cpus}};
+    struct CountingMonitor : Monitor {
+        size_t events = 0;
+        void operator()(const System&, double) override { ++events; }
+    };
+    ThreadPool pool(4, {.placement = Placement::Cores, .topology = two_nodes});
+    ParallelSimulator<CountingMonitor> simulator([] { return simple(); }, [] { return std::make_unique<CountingMonitor>(); },
+                                                 100000, 6, 2, nullptr, {.placement = Placement::Sockets, .topology = two_nodes});
+
+    // Act
+    std::vector<std::future<std::pair<size_t, std::vector<int>>>> futures;
+    for (size_t node : {1, 0}) {
+        futures.push_back(pool.enqueue_on(node, Priority::Batch, [] {
+            cpu_set_t set;
+            sched_getaffinity(0, sizeof(set), &set);
+            std::vector<int> allowed;
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) {
+                    allowed.push_back(cpu);
+                }
+            }
+            return std::pair{ThreadPool::current_slot(), allowed};
+        }));
+    }
+    simulator.simulate();
+
+    // Assert
+    EXPECT_EQ(parse_cpu_list("0-3,8,10-11\n"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_GE(machine.numCpus(), 1);
+    EXPECT_TRUE(two_nodes.numa());
+    EXPECT_EQ(pool.nodes(), 2);
+    EXPECT_EQ(ThreadPool::current_slot(), SIZE_MAX);
+    for (size_t node : {1, 0}) {
+        const auto [slot, allowed] = futures[1 - node].get();
+        EXPECT_EQ(pool.node_of(slot), node);
+        ASSERT_EQ(allowed.size(), 1);  // pinned to a single core of the node
+        EXPECT_NE(std::find(cpus.begin(), cpus.end(), allowed.front()), cpus.end());
+    }
+    for (const auto& monitor : simulator.getMonitors()) {
+        EXPECT_EQ(monitor->events, 100);
+    }
+}
+
+TEST(JobControlTest, DeadlinesCancellationAndPriorities) {
+    // Arrange
+    struct CountingMonitor : Monitor {
+        size_t events = 0;
+        void operator()(const System&, double) override { ++events; }
+    };
+    auto monitor_factory = [] { return std::make_unique<CountingMonitor>(); };
+    // The oscillator never runs out of reactions, so these replicas only end when they are stopped
+    ParallelSimulator<CountingMonitor> endless([] { return circadian_oscillator(); }, monitor_factory, 1e12, 4, 2);
+    auto pool = std::make_shared<ThreadPool>(1);
+    ParallelSimulator<CountingMonitor> batch([] { return circadian_oscillator(); }, monitor_factory, 1, 10, pool);
+    ParallelSimulator<CountingMonitor> interactive([] { return simple(); }, monitor_factory, 100000, 2, pool);
+
+    // Act
+    const auto begin = std::chrono::steady_clock::now();
+    const auto expired = endless.simulate({.priority = Priority::Batch, .stop = {}, .deadline = std::chrono::milliseconds(50)});
+    const double expired_after = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::stop_source stop;
+    std::jthread canceller([&stop] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        stop.request_stop();
+    });
+    const auto cancelled = endless.simulate({.priority = Priority::Batch, .stop = stop.get_token(), .deadline = std::nullopt});
+    const auto cancelled_monitors = endless.getMonitors().size();
+
+    std::atomic<bool> batch_done = false;
+    JobReport batch_report;
+    std::jthread batch_job([&] {
+        batch_report = batch.simulate();
+        batch_done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const auto interactive_report = interactive.simulate({.priority = Priority::Interactive, .stop = {}, .deadline = std::nullopt});
+    const bool batch_done_before_interactive = batch_done;
+    batch_job.join();
+
+    // Assert
+    EXPECT_EQ(expired.completed, 0);
+    EXPECT_GE(expired.expired, 2);
+    EXPECT_EQ(expired.expired + expired.not_started, 4);
+    EXPECT_LT(expired_after, 5.0);
+    EXPECT_EQ(cancelled.completed, 0);
+    EXPECT_GE(cancelled.cancelled, 2);
+    EXPECT_EQ(cancelled.cancelled + cancelled.not_started, 4);
+    EXPECT_EQ(cancelled_monitors, cancelled.cancelled);
+    EXPECT_EQ(endless.getStatuses().size(), cancelled_monitors);
+    EXPECT_GT(endless.getMonitors().front()->events, 0);  // partial results are kept
+
+    EXPECT_TRUE(interactive_report.finished());
+    EXPECT_FALSE(batch_done_before_interactive);
+    EXPECT_TRUE(batch_report.finished());
+    EXPECT_EQ(batch_report.completed, 10);
+}
+
+TEST(JobControlTest, ReplicaErrorIsRethrownAfterEveryReplicaFinished) {
+    // Arrange
+    struct FailingMonitor : Monitor {
+        bool fails = false;
+        size_t events = 0;
+        void operator()(const System&, double) override {
+            if (fails) {
+                throw std::runtime_error("monitor failed");
+            }
+            ++events;
+        }
+    };
+    size_t created = 0;
+    ParallelSimulator<FailingMonitor> simulator([] { return simple(); }, [&created] {
+        auto monitor = std::make_unique<FailingMonitor>();
+        monitor->fails = created++ == 1;
+        return monitor;
+    }, 100000, 6, 2);
+
+    // Act & Assert
+    EXPECT_THROW(simulator.simulate(), std::runtime_error);
+    ASSERT_EQ(simulator.getMonitors().size(), 6);
+    for (size_t i = 0; i < 6; ++i) {
+        SCOPED_TRACE(i);
+        EXPECT_EQ(simulator.getMonitors()[i]->events, i == 1 ? 0 : 100);
+    }
+}
+
+TEST(PullApiTest, GeneratorAndChannelFollowTheMonitoredRun) {
+    // Arrange
+    struct Sample {
+        double time;
+        std::vector<int> amounts;
+        bool operator==(const Sample&) const = default;
+    };
+    auto sample = [](const System& state, double t) {
+        Sample s{t, {}};
+        for (const auto& [species, amount] : state.getSpecies()) {
+            s.amounts.push_back(amount);
+        }
+        return s;
+    };
+    auto project = [&](const SimulationEvent& event) { return sample(event.state, event.time); };
+    std::vector<Sample> monitored;
+    Simulator(seihr(1000), 100, 7).simulate([&](const System& state, double t) { monitored.push_back(sample(state, t)); });
+
+    // Act
+    // Two runs of the same seed, interleaved on this thread, event by event
+    Simulator first(seihr(1000), 100, 7), second(seihr(1000), 100, 7);
+    std::vector<Sample> pulled, interleaved;
+    auto first_events = first.events();
+    auto second_events = second.events();
+    size_t fired_reactions = 0;
+    for (auto a = first_events.begin(), b = second_events.begin(); a != first_events.end(); ++a, ++b) {
+        pulled.push_back(project(*a));
+        interleaved.push_back(project(*b));
+        fired_reactions += a->reaction != nullptr;
+    }
+
+    Simulator inline_producer(seihr(1000), 100, 7);
+    EventChannel<Sample> in_turns(16);
+    inline_producer.stream(in_turns, project);
+    std::vector<Sample> in_turns_samples;
+    size_t most_buffered = 0;
+    while (auto s = in_turns.pop()) {
+        most_buffered = std::max(most_buffered, in_turns.size());
+        in_turns_samples.push_back(std::move(*s));
+    }
+
+    ThreadPool pool(1);
+    Simulator threaded_producer(seihr(1000), 100, 7);
+    std::vector<Sample> threaded_samples;
+    {
+        EventChannel<Sample> threaded(8, [&pool](std::coroutine_handle<> producer) {
+            pool.enqueue([producer] { producer.resume(); });
+        });
+        threaded_producer.stream(threaded, project);
+        for (const auto& s : threaded.values()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(10));  // a slow consumer
+            most_buffered = std::max(most_buffered, threaded.size());
+            threaded_samples.push_back(s);
+        }
+        EXPECT_GT(threaded.suspensions(), 0);
+    }
+
+    // The oscillator runs forever; leaving the channel must stop it
+    Simulator endless(circadian_oscillator(), 1e12, 7);
+    size_t taken = 0;
+    {
+        EventChannel<Sample> abandoned(4, [&pool](std::coroutine_handle<> producer) {
+            pool.enqueue([producer] { producer.resume(); });
+        });
+        endless.stream(abandoned, project);
+        while (taken < 100 && abandoned.pop()) {
+            ++taken;
+        }
+    }
+
+    // Assert
+    ASSERT_FALSE(monitored.empty());
+    EXPECT_EQ(pulled, monitored);
+    EXPECT_EQ(interleaved, monitored);
+    EXPECT_GT(fired_reactions, 0);
+    EXPECT_EQ(in_turns_samples, monitored);
+    EXPECT_EQ(threaded_samples, monitored);
+    EXPECT_LE(most_buffered, 16);
+    EXPECT_EQ(taken, 100);
+}
+
+TEST(ResultSinkTest, WorkersHandRecordsToTheWriterThread) {
+    // Arrange
+    struct EventRecord {
+        uint32_t replica, sequence;
+        double time;
+    };
+    const auto path = std::filesystem::temp_directory_path() / "result_sink_test.bin";
+    std::optional<ResultSink<EventRecord>> sink;
+    // Every event of a replica becomes a record, pushed from the worker that runs it
+    struct RecordingMonitor : Monitor {
+        ResultSink<EventRecord>* sink = nullptr;
+        uint32_t replica = 0, sequence = 0;
+        void operator()(const System&, double t) override {
+            sink->push(ThreadPool::current_slot(), {replica, sequence++, t});
+        }
+    };
+    uint32_t replicas = 0;
+    ParallelSimulator<RecordingMonitor> simulator([] { return simple(); }, [&] {
+        auto monitor = std::make_unique<RecordingMonitor>();
+        monitor->sink = &*sink;
+        monitor->replica = replicas++;
+        return monitor;
+    }, 100000, 8, 4);
+
+    // Act
+    std::vector<uint32_t> next(8, 0);
+    bool in_order = true;
+    size_t largest_batch = 0;
+    SinkStats blocking;
+    {
+        RecordFile file(path);
+        sink.emplace(4, [&](std::span<const EventRecord> batch) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));  // a slow disk
+            file.write(batch);
+            largest_batch = std::max(largest_batch, batch.size());
+            for (const auto& record : batch) {
+                in_order = in_order && record.sequence == next[record.replica]++;
+            }
+        }, SinkOptions{.capacity = 16, .batch = 32});
+        simulator.simulate();
+        sink->close();
+        blocking = sink->stats();
+        sink.reset();
+    }
+    const auto file_size = std::filesystem::file_size(path);
+    std::filesystem::remove(path);
+
+    SinkStats dropping;
+    {
+        ResultSink<EventRecord> lossy(1, [](std::span<const EventRecord>) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }, {.capacity = 4, .overflow = Overflow::Drop});
+        for (uint32_t i = 0; i < 1000; ++i) {
+            lossy.push(0, {0, i, 0.0});
+        }
+        lossy.close();
+        dropping = lossy.stats();
+    }
+
+    bool rethrown = false;
+    SinkStats failing;
+    {
+        ResultSink<EventRecord> broken(1, [](std::span<const EventRecord>) { throw std::runtime_error("disk full"); });
+        broken.push(0, {});
+        broken.push(0, {});
+        try {
+            broken.close();
+        } catch (const std::runtime_error&) {
+            rethrown = true;
+        }
+        failing = broken.stats();
+    }
+    std::ostringstream metrics;
+    SinkStats::writeExposition(metrics, blocking);
+
+    // Assert
+    // Simple runs until A is used up: 100 reactions per replica
+    EXPECT_EQ(blocking.pushed, 800);
+    EXPECT_EQ(blocking.written, 800);
+    EXPECT_EQ(blocking.dropped, 0);
+    EXPECT_GT(blocking.waits, 0);
+    EXPECT_EQ(blocking.buffered(), 0);
+    EXPECT_EQ(blocking.capacity, 16);
+    EXPECT_LE(largest_batch, 32);
+    EXPECT_LT(blocking.batches, 800);
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(next, std::vector<uint32_t>(8, 100));
+    EXPECT_EQ(file_size, 800 * sizeof(EventRecord));
+
+    EXPECT_GT(dropping.dropped, 0);
+    EXPECT_EQ(dropping.pushed + dropping.dropped, 1000);
+    EXPECT_EQ(dropping.written, dropping.pushed);
+    EXPECT_EQ(dropping.waits, 0);
+
+    EXPECT_TRUE(rethrown);
+    EXPECT_EQ(failing.written, 0);
+    EXPECT_EQ(failing.dropped, 2);
+
+    EXPECT_NE(metrics.str().find("stochastic_simulator_sink_records_written_total 800\n"), std::string::npos);
+    EXPECT_NE(metrics.str().find("stochastic_simulator_sink_ring_occupancy{producer=\"3\"} 0\n"), std::string::npos);
+}
+
+namespace {
+    // Allocations made while events `warmup` to the last were processed; the first events may still grow buffers
+    class AllocationMonitor : public StateMonitor {
+    public:
+        explicit AllocationMonitor(size_t warmup = 100) : warmup_(warmup) {}
+
+        void operator()(const CompiledNetwork&, std::span<const int>, double) override { observe(); }
+        void operator()(const System&, double) { observe(); }
+
+        void observe() {
+            if (++events == warmup_) {
+                at_warmup_ = allocations::count;
+            }
+            last_ = allocations::count;
+        }
+
+        [[nodiscard]] uint64_t steadyAllocations() const { return last_ - at_warmup_; }
+
+        size_t events = 0;
+
+    private:
+        size_t warmup_;
+        uint64_t at_warmup_ = 0, last_ = 0;
+    };
+}
+
+TEST(AllocationTest, EventLoopsDoNotAllocate) {
+    // Arrange
+    const auto system = seihr(10000);
+    const CompiledNetwork network(system);
+    const auto kernel = seihr_static(10000);
+    const GeneratedKernel generated(network);
+
+    System cell;
+    auto A = cell("A", 500);
+    auto B = cell("B", 0);
+    cell(A >>= B, 0.1);
+    cell(B >>= A, 0.1);
+    ReplicatedNetwork population(cell, 8);
+    population.addCoupling({population.site(0, "B")}, {population.site(7, "B")}, 0.5);
+
+    Metapopulation regions(seihr(1000), 4);
+    for (size_t k = 0; k < 4; ++k) {
+        regions.addMigration(k, (k + 1) % 4, "I", 0.05);
+    }
+
+    std::vector<std::pair<std::string, AllocationMonitor>> runs;
+    auto run = [&runs](const std::string& name, auto simulate) {
+        AllocationMonitor monitor;
+        simulate(monitor);
+        runs.emplace_back(name, monitor);
+    };
+
+    // Act
+    run("first reaction (Simulator)", [&](AllocationMonitor& monitor) {
+        Simulator simulator(system, 100, 1);
+        simulator.simulate([&monitor](const System& s, double t) { monitor(s, t); });
+    });
+    for (auto engine : {EngineKind::Direct, EngineKind::NextReaction, EngineKind::CompositionRejection, EngineKind::TauLeaping}) {
+        run(std::string(to_string(engine)), [&](AllocationMonitor& monitor) {
+            AdaptiveSimulator(network, 100, 1, {.engine = engine}).simulate(monitor);
+        });
+    }
+    run("uniformization", [&](AllocationMonitor& monitor) { UniformizationSimulator(network, 100, 1).simulate(monitor); });
+    run("tau-leaping", [&](AllocationMonitor& monitor) { TauLeapSimulator(network, 100, 0.01, 1).simulate(monitor); });
+    run("generated kernel", [&](AllocationMonitor& monitor) { GeneratedSimulator(generated, 100, 1).simulate(monitor); });
+    run("static kernel", [&](AllocationMonitor& monitor) {
+        kernel.simulate(100, 1, [&monitor](const auto&, double) { monitor.observe(); });
+    });
+    run("replicated", [&](AllocationMonitor& monitor) { ReplicatedSimulator(population, 10, 1).simulate(monitor); });
+    run("spatial", [&](AllocationMonitor& monitor) { SpatialSimulator(regions, 50, 1).simulate(monitor); });
+
+    // Assert
+    for (const auto& [name, monitor] : runs) {
+        SCOPED_TRACE(name);
+        EXPECT_GT(monitor.events, 1000);
+        EXPECT_EQ(monitor.steadyAllocations(), 0);
+    }
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();